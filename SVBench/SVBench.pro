@@ -0,0 +1,78 @@
+QT += quick qml charts network core gui concurrent
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+# The following define makes your compiler emit warnings if you use
+# any Qt feature that has been marked deprecated (the exact warnings
+# depend on your compiler). Please consult the documentation of the
+# deprecated API in order to know how to port your code away from it.
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+        main.cpp \
+        bench_charts.cpp \
+        bench_filters.cpp \
+        bench_map.cpp \
+        bench_planner.cpp \
+        bench_trail.cpp \
+        bench_pipeline.cpp \
+        bench_compression.cpp \
+        bench_batch.cpp \
+    ../SVGUI_qml/svseries.cpp \
+    ../SVGUI_qml/filter.cpp \
+    ../SVGUI_qml/refilter.cpp \
+    ../SVGUI_qml/lodpyramid.cpp \
+    ../SVGUI_qml/svlinenode.cpp \
+    ../SVGUI_qml/svchartitem.cpp \
+    ../SVGUI_qml/svmapitem.cpp \
+    ../SVGUI_qml/trajectorytrail.cpp \
+    ../SVGUI_qml/adapter.cpp \
+    ../SVGUI_qml/svclient.cpp \
+    ../SVGUI_qml/sessionmanager.cpp \
+    ../SVGUI_qml/channelmodel.cpp \
+    ../SVGUI_qml/channelstats.cpp \
+    ../SVGUI_qml/derivedchannels.cpp \
+    ../SVGUI_qml/telemetrystore.cpp \
+    ../SVGUI_qml/telemetryexporter.cpp \
+    ../common/datapackage.cpp \
+    ../common/gridplanner.cpp \
+    ../common/svserver.cpp \
+    ../common/svtrace.cpp \
+    ../common/svmetrics.cpp \
+    ../common/telemetrycodec.cpp \
+    ../common/telemetrybatch.cpp \
+    ../common/vehiclesimulator.cpp
+
+RESOURCES += ../SVGUI_qml/qml.qrc
+
+INCLUDEPATH += ../SVGUI_qml/ ../common/
+
+HEADERS += \
+        benchmarks.h \
+    ../SVGUI_qml/svseries.h \
+    ../SVGUI_qml/filter.h \
+    ../SVGUI_qml/refilter.h \
+    ../SVGUI_qml/ringbuffer.h \
+    ../SVGUI_qml/lodpyramid.h \
+    ../SVGUI_qml/svlinenode.h \
+    ../SVGUI_qml/svchartitem.h \
+    ../SVGUI_qml/svmapitem.h \
+    ../SVGUI_qml/trajectorytrail.h \
+    ../SVGUI_qml/adapter.h \
+    ../SVGUI_qml/svclient.h \
+    ../SVGUI_qml/sessionmanager.h \
+    ../SVGUI_qml/channelmodel.h \
+    ../SVGUI_qml/channelstats.h \
+    ../SVGUI_qml/derivedchannels.h \
+    ../SVGUI_qml/telemetrystore.h \
+    ../SVGUI_qml/telemetryexporter.h \
+    ../common/datapackage.h \
+    ../common/gridplanner.h \
+    ../common/svserver.h \
+    ../common/svtrace.h \
+    ../common/svmetrics.h \
+    ../common/telemetrycodec.h \
+    ../common/telemetrybatch.h \
+    ../common/vehiclesimulator.h
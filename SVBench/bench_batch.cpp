@@ -0,0 +1,99 @@
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QtMath>
+#include <limits>
+#include "benchmarks.h"
+#include "datapackage.h"
+#include "telemetrybatch.h"
+
+//framed packages as they are queued in the receive buffer
+static QByteArray frames(QVector<HighFreqDataPackage> const& samples, Package::Layout layout, bool longFrames)  {
+    QByteArray bytes;
+    for (HighFreqDataPackage const& data : samples)
+        bytes.append(PackageFrame::wrap(data.toBytes(layout), longFrames));
+    return bytes;
+}
+
+static bool same(HighFreqDataPackage const& a, HighFreqDataPackage const& b)    {
+    return a.timeStamp == b.timeStamp && a.m_encoderValue == b.m_encoderValue && a.m_steeringAngle == b.m_steeringAngle &&
+            a.x == b.x && a.y == b.y && a.angle == b.angle;
+}
+
+//samples per second of the per-package constructors and of the bulk decoder paths, best of the runs
+int benchBatch(QStringList const& args)   {
+    int count = argValue(args, "--samples", 100000);
+    int runs = qMax(argValue(args, "--runs", 5), 1);
+
+    QVector<HighFreqDataPackage> samples(count);
+    for (int i = 0; i < count; i++) {
+        HighFreqDataPackage &data = samples[i];
+        double t = i / 100.0;
+        data.timeStamp = static_cast<quint32>(i * 10);
+        data.m_encoderValue = static_cast<float>(t * 0.8);
+        data.m_steeringAngle = static_cast<float>(20 * qSin(t / 3));
+        data.x = static_cast<float>(100 + 10 * qCos(t / 10));
+        data.y = static_cast<float>(100 + 10 * qSin(t / 10));
+        data.angle = static_cast<float>(std::fmod(t * 5.7, 360.0) - 180);
+    }
+    qInfo().noquote() << QString("%1 samples, %2 runs, best path of the CPU: %3")
+                         .arg(count).arg(runs).arg(TelemetryBatchDecoder::pathName(TelemetryBatchDecoder::available()));
+
+    struct Format {
+        Package::Layout layout;
+        bool longFrames;
+        QString name;
+    };
+    Format const formats[2] = {
+        {Package::STREAM, false, "stream (protocol 1)"},
+        {Package::COMPACT, true, "compact (protocol 3)"}
+    };
+
+    int errors = 0;
+    for (Format const& format : formats)    {
+        QByteArray buffer = frames(samples, format.layout, format.longFrames);
+        auto report = [&](QString const& name, qint64 best, qint64 baseline) {
+            qInfo().noquote() << QString("%1 %2: %3 M samples/s, %4 ns/sample%5")
+                                 .arg(format.name, -20).arg(name, -12)
+                                 .arg(count / (best / 1e3), 0, 'f', 2).arg(static_cast<double>(best) / count, 0, 'f', 1)
+                                 .arg(baseline ? QString(", x%1").arg(static_cast<double>(baseline) / best, 0, 'f', 1) : QString());
+        };
+
+        //what SVClient does for every package: the frame from the device, the constructor
+        qint64 perPackage = std::numeric_limits<qint64>::max();
+        QVector<HighFreqDataPackage> decoded(count);
+        for (int run = 0; run < runs; run++)    {
+            QBuffer device(&buffer);
+            device.open(QIODevice::ReadOnly);
+            QElapsedTimer timer;
+            timer.start();
+            QByteArray bytes;
+            int i = 0;
+            while (PackageFrame::read(&device, format.longFrames, bytes) && i < count)
+                decoded[i++] = HighFreqDataPackage(bytes, format.layout);
+            perPackage = qMin(perPackage, timer.nsecsElapsed());
+        }
+        report("constructor", perPackage, 0);
+
+        for (int path = TelemetryBatchDecoder::SCALAR; path <= TelemetryBatchDecoder::available(); path++)  {
+            qint64 best = std::numeric_limits<qint64>::max();
+            TelemetryColumns columns;
+            for (int run = 0; run < runs; run++)    {
+                columns.clear();
+                QElapsedTimer timer;
+                timer.start();
+                TelemetryBatchDecoder::decode(buffer.constData(), buffer.size(), format.longFrames, format.layout, columns,
+                                              static_cast<TelemetryBatchDecoder::Path>(path));
+                best = qMin(best, timer.nsecsElapsed());
+            }
+            int mismatches = columns.size() == count ? 0 : 1;
+            for (int i = 0; i < columns.size() && i < count; i++)
+                mismatches += same(columns.at(i), decoded.at(i)) ? 0 : 1;
+            if (mismatches)
+                qWarning() << "batch" << TelemetryBatchDecoder::pathName(static_cast<TelemetryBatchDecoder::Path>(path))
+                           << "differs from the constructor in" << mismatches << "samples";
+            errors += mismatches;
+            report("batch " + TelemetryBatchDecoder::pathName(static_cast<TelemetryBatchDecoder::Path>(path)), best, perPackage);
+        }
+    }
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,81 @@
+#include <QQuickView>
+#include <QQuickItem>
+#include <QQmlComponent>
+#include <QQmlEngine>
+#include <QElapsedTimer>
+#include <cmath>
+#include "benchmarks.h"
+#include "svseries.h"
+
+static const char qtChartsScene[] =
+        "import QtQuick 2.9\n"
+        "import QtCharts 2.2\n"
+        "ChartView {\n"
+        "    property var series: line\n"
+        "    anchors.fill: parent\n"
+        "    antialiasing: true\n"
+        "    LineSeries {\n"
+        "        id: line\n"
+        "        axisX: ValueAxis { min: 0; max: 60 }\n"
+        "        axisY: ValueAxis { min: -10; max: 10 }\n"
+        "    }\n"
+        "}\n";
+
+static const char sceneGraphScene[] =
+        "import QtQuick 2.9\n"
+        "import SmartVehicle 1.0\n"
+        "SVChart {\n"
+        "    id: chart\n"
+        "    property var series: chart\n"
+        "    anchors.fill: parent\n"
+        "}\n";
+
+//feeds the chart through SVSeries like the GUI does and measures
+//sync + render of every frame
+static QVector<qint64> runChart(QByteArray const& scene, int pointsPerFrame, int frames)    {
+    QQuickView view;
+    view.resize(1280, 400);
+    QQmlComponent component(view.engine());
+    component.setData(scene, QUrl());
+    QQuickItem *root = qobject_cast<QQuickItem*>(component.create());
+    if (root == nullptr)    {
+        qWarning() << component.errors();
+        return QVector<qint64>();
+    }
+    root->setParentItem(view.contentItem());
+    view.show();
+
+    SVSeries series;
+    series.setSeriesObj(root->property("series").value<QObject*>());
+
+    QVector<qint64> nsecs;
+    nsecs.reserve(frames);
+    QElapsedTimer timer;
+    double time = 0;
+    double step = 1.0 / 60 / pointsPerFrame;
+    for (int frame = 0; frame < frames; frame++)    {
+        for (int i = 0; i < pointsPerFrame; i++)    {
+            time += step;
+            series.addPoint(QPointF(time, sin(time) * 8 + sin(time * 50)));
+        }
+        timer.start();
+        series.flush();
+        view.grabWindow();
+        nsecs.append(timer.nsecsElapsed());
+    }
+
+    delete root;
+    return nsecs;
+}
+
+int benchCharts(QStringList const& args)    {
+    int pointsPerFrame = argValue(args, "--points", 16);
+    int frames = argValue(args, "--frames", 3600);
+    if (!args.contains("--opengl"))
+        QQuickWindow::setSceneGraphBackend(QSGRendererInterface::Software);
+
+    qInfo() << "Chart render time," << pointsPerFrame << "points per frame," << frames << "frames";
+    printStats("QtCharts LineSeries", runChart(qtChartsScene, pointsPerFrame, frames));
+    printStats("SVChart scene graph", runChart(sceneGraphScene, pointsPerFrame, frames));
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include <QFile>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QtMath>
+#include "benchmarks.h"
+#include "datapackage.h"
+#include "telemetrycodec.h"
+#include "vehiclesimulator.h"
+
+//high freq samples of a binary export (.svtx) of the GUI
+static bool readRecording(QString const& fileName, QVector<HighFreqDataPackage> &samples)  {
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))    {
+        qWarning() << "Can't open" << fileName;
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    char magic[4];
+    quint16 version = 0;
+    if (stream.readRawData(magic, 4) != 4 || QByteArray(magic, 4) != "SVTX")   {
+        qWarning() << fileName << "is not a telemetry export";
+        return false;
+    }
+    stream >> version;
+    while (!stream.atEnd() && stream.status() == QDataStream::Ok)  {
+        qint8 type = 0;
+        quint32 count = 0;
+        stream >> type >> count;
+        QVector<quint32> timeStamps(static_cast<int>(count));
+        for (quint32 &timeStamp : timeStamps)
+            stream >> timeStamp;
+        if (type != HighFreqDataPackage::packageType)  {
+            //state, batteries and temperature of low freq blocks
+            stream.skipRawData(static_cast<int>(count) * 13);
+            continue;
+        }
+        int first = samples.size();
+        for (quint32 timeStamp : timeStamps)    {
+            HighFreqDataPackage data;
+            data.timeStamp = timeStamp;
+            samples.append(data);
+        }
+        for (int column = 0; column < 5; column++)
+            for (int i = first; i < samples.size(); i++)    {
+                HighFreqDataPackage &data = samples[i];
+                float *fields[5] = {&data.m_encoderValue, &data.m_steeringAngle, &data.x, &data.y, &data.angle};
+                stream >> *fields[column];
+            }
+    }
+    return stream.status() == QDataStream::Ok;
+}
+
+//the simulated vehicle drives slow circles on an empty map
+static QVector<HighFreqDataPackage> simulate(int minutes, int rate)   {
+    QVector<QVector<qint8>> cells(200, QVector<qint8>(200, MapPackage::EMPTY));
+    VehicleSimulator::Config config;
+    config.highFreqRate = rate;
+    VehicleSimulator simulator(MapPackage(cells), config);
+    simulator.setPose(100.5, 100.5, 0);
+    QVector<HighFreqDataPackage> samples;
+    samples.reserve(minutes * 60 * rate);
+    QObject::connect(&simulator, &VehicleSimulator::signalHighFreqData, [&samples](HighFreqDataPackage const& data) {
+        samples.append(data);
+    });
+    ControlPackage control;
+    control.xAxis = 0.3f;
+    control.yAxis = 0.5f;
+    for (int second = 0; second < minutes * 60; second++)   {
+        simulator.slotControl(control);
+        simulator.advance(config.stepRate);
+    }
+    return samples;
+}
+
+//bytes on the wire (with the size prefix) and the quantization error of the compressed
+//telemetry against HighFreqDataPackage for a recorded or a simulated session
+int benchCompression(QStringList const& args)  {
+    int minutes = argValue(args, "--minutes", 10);
+    int rate = argValue(args, "--rate", 100);
+    int keyframeInterval = argValue(args, "--keyframe", 100);
+    int fileIndex = args.indexOf("--file");
+
+    QVector<HighFreqDataPackage> samples;
+    if (fileIndex >= 0 && fileIndex + 1 < args.size())  {
+        if (!readRecording(args.at(fileIndex + 1), samples))
+            return 1;
+        qInfo() << "Recorded session" << args.at(fileIndex + 1) << "," << samples.size() << "samples";
+    }   else    {
+        samples = simulate(minutes, rate);
+        qInfo() << "Simulated session," << minutes << "min at" << rate << "samples/s," << samples.size() << "samples";
+    }
+    if (samples.isEmpty())
+        return 1;
+
+    QElapsedTimer timer;
+    qint64 plainBytes = 0;
+    timer.start();
+    for (HighFreqDataPackage const& data : samples)
+        plainBytes += data.toBytes().size() + 1;
+    qint64 plainEncode = timer.nsecsElapsed();
+
+    TelemetryEncoder encoder(TelemetryResolution(), keyframeInterval);
+    QVector<QByteArray> frames;
+    frames.reserve(samples.size());
+    qint64 compressedBytes = 0;
+    timer.restart();
+    for (HighFreqDataPackage const& data : samples) {
+        frames.append(encoder.encode(data));
+        compressedBytes += frames.last().size() + 1;
+    }
+    qint64 compressedEncode = timer.nsecsElapsed();
+
+    QVector<QByteArray> plainFrames;
+    plainFrames.reserve(samples.size());
+    for (HighFreqDataPackage const& data : samples)
+        plainFrames.append(data.toBytes());
+    timer.restart();
+    float checksum = 0;
+    for (QByteArray &bytes : plainFrames)   {
+        HighFreqDataPackage data(bytes);
+        checksum += data.x;
+    }
+    qint64 plainDecode = timer.nsecsElapsed();
+
+    TelemetryDecoder decoder;
+    QVector<HighFreqDataPackage> decoded(samples.size());
+    int broken = 0;
+    timer.restart();
+    for (int i = 0; i < frames.size(); i++)
+        broken += decoder.decode(frames.at(i), decoded[i]) ? 0 : 1;
+    qint64 compressedDecode = timer.nsecsElapsed();
+
+    double maxError[5] = {};
+    int timeErrors = 0;
+    for (int i = 0; i < samples.size(); i++)    {
+        HighFreqDataPackage const& a = samples.at(i);
+        HighFreqDataPackage const& b = decoded.at(i);
+        float const source[5] = {a.m_encoderValue, a.m_steeringAngle, a.x, a.y, a.angle};
+        float const result[5] = {b.m_encoderValue, b.m_steeringAngle, b.x, b.y, b.angle};
+        for (int channel = 0; channel < 5; channel++)
+            maxError[channel] = qMax(maxError[channel], qAbs(static_cast<double>(source[channel] - result[channel])));
+        timeErrors += a.timeStamp != b.timeStamp ? 1 : 0;
+    }
+
+    double count = samples.size();
+    double seconds = (samples.last().timeStamp - samples.first().timeStamp) / 1000.0;
+    qInfo().noquote() << QString("plain: %1 KiB, %2 bytes/sample%3")
+                         .arg(plainBytes / 1024.0, 0, 'f', 1).arg(plainBytes / count, 0, 'f', 2)
+                         .arg(seconds > 0 ? QString(", %1 kbit/s").arg(plainBytes * 8 / seconds / 1000, 0, 'f', 1) : QString());
+    qInfo().noquote() << QString("compressed: %1 KiB, %2 bytes/sample%3, keyframe every %4 frames")
+                         .arg(compressedBytes / 1024.0, 0, 'f', 1).arg(compressedBytes / count, 0, 'f', 2)
+                         .arg(seconds > 0 ? QString(", %1 kbit/s").arg(compressedBytes * 8 / seconds / 1000, 0, 'f', 1) : QString())
+                         .arg(keyframeInterval);
+    qInfo().noquote() << QString("saved %1% of the bandwidth, ratio %2")
+                         .arg(100.0 * (plainBytes - compressedBytes) / plainBytes, 0, 'f', 1)
+                         .arg(static_cast<double>(plainBytes) / compressedBytes, 0, 'f', 2);
+    qInfo().noquote() << QString("max error: encoder %1, steering %2, x %3, y %4, angle %5, timestamps %6, broken frames %7")
+                         .arg(maxError[0]).arg(maxError[1]).arg(maxError[2]).arg(maxError[3]).arg(maxError[4])
+                         .arg(timeErrors).arg(broken);
+    qInfo().noquote() << QString("encode: plain %1 ns/sample, compressed %2 ns/sample")
+                         .arg(plainEncode / count, 0, 'f', 1).arg(compressedEncode / count, 0, 'f', 1);
+    qInfo().noquote() << QString("decode: plain %1 ns/sample, compressed %2 ns/sample (checksum %3)")
+                         .arg(plainDecode / count, 0, 'f', 1).arg(compressedDecode / count, 0, 'f', 1)
+                         .arg(static_cast<double>(checksum), 0, 'g', 3);
+    return broken || timeErrors ? 1 : 0;
+}
@@ -0,0 +1,58 @@
+#include <QElapsedTimer>
+#include <cmath>
+#include "benchmarks.h"
+#include "filter.h"
+
+//filters a noisy signal by blocks of the frame size, like SVSeries does,
+//and sample by sample for comparison
+static void runFilter(QString const& name, Filter::FilterType type, QVector<float> const& input, int blockSize, int runs)  {
+    Filter *filter = Filter::create(type);
+    QVector<float> output(input.size());
+    QVector<qint64> blockNsecs;
+    QVector<qint64> sampleNsecs;
+    QElapsedTimer timer;
+
+    for (int run = 0; run < runs; run++)    {
+        filter->reset();
+        timer.start();
+        for (int i = 0; i < input.size(); i += blockSize)
+            filter->process(input.constData() + i, output.data() + i, qMin(blockSize, input.size() - i));
+        blockNsecs.append(timer.nsecsElapsed());
+
+        filter->reset();
+        timer.start();
+        for (int i = 0; i < input.size(); i++)
+            output[i] = filter->process(input.at(i));
+        sampleNsecs.append(timer.nsecsElapsed());
+    }
+    delete filter;
+
+    std::sort(blockNsecs.begin(), blockNsecs.end());
+    std::sort(sampleNsecs.begin(), sampleNsecs.end());
+    double blockRate = input.size() * 1000.0 / blockNsecs.at(blockNsecs.size() / 2);
+    double sampleRate = input.size() * 1000.0 / sampleNsecs.at(sampleNsecs.size() / 2);
+    qInfo().noquote() << QString("%1: %2 Msamples/s by blocks, %3 Msamples/s by samples")
+                         .arg(name, -20)
+                         .arg(blockRate, 8, 'f', 1)
+                         .arg(sampleRate, 8, 'f', 1);
+}
+
+int benchFilters(QStringList const& args)   {
+    int samples = argValue(args, "--samples", 1 << 20);
+    int blockSize = qMax(1, argValue(args, "--block", 256));
+    int runs = qMax(1, argValue(args, "--runs", 20));
+
+    QVector<float> input(samples);
+    for (int i = 0; i < samples; i++)
+        input[i] = static_cast<float>(sin(i * 0.001) * 8 + sin(i * 0.7) + (i % 97 == 0 ? 20 : 0));
+
+    qInfo() << "Filter throughput," << samples << "samples, blocks of" << blockSize << "samples, median of" << runs << "runs";
+    runFilter("Kalman", Filter::KALMAN, input, blockSize, runs);
+    runFilter("Kalman (velocity)", Filter::KALMAN_CV, input, blockSize, runs);
+    runFilter("Gliding average", Filter::GAF, input, blockSize, runs);
+    runFilter("Low-pass", Filter::LOWPASS, input, blockSize, runs);
+    runFilter("Median", Filter::MEDIAN, input, blockSize, runs);
+    runFilter("Savitzky-Golay", Filter::SAVGOL, input, blockSize, runs);
+    runFilter("Median + Low-pass", Filter::CHAIN, input, blockSize, runs);
+    return 0;
+}
@@ -0,0 +1,178 @@
+#include <QQuickView>
+#include <QQuickItem>
+#include <QQmlComponent>
+#include <QQmlEngine>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QCoreApplication>
+#include <QtMath>
+#include "benchmarks.h"
+#include "svmapitem.h"
+#include "datapackage.h"
+
+//former CellMap.qml grid, one Rectangle per cell
+static const char repeaterScene[] =
+        "import QtQuick 2.9\n"
+        "Item {\n"
+        "    anchors.fill: parent\n"
+        "    property int map_width: 0\n"
+        "    property int map_height: 0\n"
+        "    property var cellList: []\n"
+        "    property double cell_width: width / map_width\n"
+        "    property double cell_height: height / map_height\n"
+        "    Column  {\n"
+        "        Repeater    {\n"
+        "            model: map_height\n"
+        "            delegate: Row {\n"
+        "                Repeater    {\n"
+        "                    id: row_repeater\n"
+        "                    property int column_index: index\n"
+        "                    model: map_width\n"
+        "                    delegate: Rectangle   {\n"
+        "                        width: cell_width\n"
+        "                        height: cell_height\n"
+        "                        color: (cellList[row_repeater.column_index * map_width + index] !== 1) ? \"white\" : \"lightgray\"\n"
+        "                        border.width: 1\n"
+        "                        border.color: \"gray\"\n"
+        "                    }\n"
+        "                }\n"
+        "            }\n"
+        "        }\n"
+        "    }\n"
+        "}\n";
+
+static const char sceneGraphScene[] =
+        "import QtQuick 2.9\n"
+        "import SmartVehicle 1.0\n"
+        "SVMap {\n"
+        "    anchors.fill: parent\n"
+        "}\n";
+
+//random walls, about a quarter of the cells
+static QByteArray makeCells(int size)   {
+    QByteArray cells(size * size, static_cast<char>(MapPackage::EMPTY));
+    quint32 seed = 12345;
+    for (int i = 0; i < cells.size(); i++)  {
+        seed = seed * 1664525u + 1013904223u;
+        if ((seed >> 24) < 64)
+            cells[i] = static_cast<char>(MapPackage::WALL);
+    }
+    return cells;
+}
+
+//renders frames until the lazily built tiles are all shown
+static void waitTiles(QQuickView &view, QQuickItem *root)  {
+    SVMapItem *map = qobject_cast<SVMapItem*>(root);
+    while (map && map->pendingTiles())  {
+        QThreadPool::globalInstance()->waitForDone();
+        QCoreApplication::processEvents();
+        view.grabWindow();
+    }
+}
+
+//load: map is set and the first frame is rendered; frame: the next frames are rendered
+static void runMap(QString const& name, QByteArray const& scene, int size, int frames)  {
+    QByteArray cells = makeCells(size);
+    QQuickView view;
+    view.resize(800, 800);
+    view.show();
+    QQmlComponent component(view.engine());
+    component.setData(scene, QUrl());
+
+    QElapsedTimer timer;
+    timer.start();
+    QQuickItem *root = qobject_cast<QQuickItem*>(component.create());
+    if (root == nullptr)    {
+        qWarning() << component.errors();
+        return;
+    }
+    root->setParentItem(view.contentItem());
+    if (SVMapItem *map = qobject_cast<SVMapItem*>(root))    {
+        map->setMap(size, size, cells);
+    }   else    {
+        QVariantList cellList;
+        cellList.reserve(cells.size());
+        for (char cell : cells)
+            cellList.append(static_cast<int>(cell));
+        root->setProperty("cellList", cellList);
+        root->setProperty("map_width", size);
+        root->setProperty("map_height", size);
+    }
+    view.grabWindow();
+    waitTiles(view, root);
+    qint64 load = timer.nsecsElapsed();
+
+    QVector<qint64> nsecs;
+    nsecs.reserve(frames);
+    for (int frame = 0; frame < frames; frame++)    {
+        //vehicle moving over the map, the map itself is the same
+        root->setX(frame % 2);
+        timer.start();
+        view.grabWindow();
+        nsecs.append(timer.nsecsElapsed());
+    }
+
+    qInfo().noquote() << QString("%1: load %2 ms").arg(name, -28).arg(load / 1000000.0, 0, 'f', 1);
+    printStats(name + " frame", nsecs);
+    delete root;
+}
+
+//pans the zoomed map in circles, tiles come in while panning like in the GUI
+static void runPan(int size, int frames, qreal zoom)    {
+    QByteArray cells = makeCells(size);
+    QQuickView view;
+    view.resize(800, 800);
+    view.show();
+    QQmlComponent component(view.engine());
+    component.setData(sceneGraphScene, QUrl());
+    SVMapItem *map = qobject_cast<SVMapItem*>(component.create());
+    if (map == nullptr) {
+        qWarning() << component.errors();
+        return;
+    }
+    map->setParentItem(view.contentItem());
+    map->setMap(size, size, cells);
+    map->setZoom(zoom);
+    view.grabWindow();
+    waitTiles(view, map);
+
+    QVector<qint64> nsecs;
+    nsecs.reserve(frames);
+    QElapsedTimer timer;
+    for (int frame = 0; frame < frames; frame++)    {
+        timer.start();
+        map->pan(40 * qCos(frame / 100.0), 40 * qSin(frame / 100.0));
+        QCoreApplication::processEvents();
+        view.grabWindow();
+        nsecs.append(timer.nsecsElapsed());
+    }
+    printStats(QString("SVMap pan %1x%1, zoom %2").arg(size).arg(zoom), nsecs);
+    delete map;
+}
+
+int benchMap(QStringList const& args)   {
+    int maxSize = argValue(args, "--size", 500);
+    int frames = argValue(args, "--frames", 100);
+    int repeaterLimit = argValue(args, "--repeater-limit", 200);
+    int panSize = argValue(args, "--pan-size", 8192);
+    if (!args.contains("--opengl"))
+        QQuickWindow::setSceneGraphBackend(QSGRendererInterface::Software);
+
+    QVector<int> sizes;
+    for (int size = 50; size < maxSize; size *= 2)
+        sizes.append(size);
+    sizes.append(maxSize);
+
+    qInfo() << "Map load and render time," << frames << "frames, Repeater grid up to" << repeaterLimit << "cells side";
+    for (int size : sizes)  {
+        QString suffix = QString(" %1x%1").arg(size);
+        if (size <= repeaterLimit)
+            runMap("Repeater grid" + suffix, repeaterScene, size, frames);
+        runMap("SVMap scene graph" + suffix, sceneGraphScene, size, frames);
+    }
+
+    qInfo() << "Map pan frame time," << panSize << "cells side," << frames * 10 << "frames";
+    runPan(panSize, frames * 10, 1);
+    runPan(panSize, frames * 10, 16);
+    return 0;
+}
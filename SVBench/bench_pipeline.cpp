@@ -0,0 +1,317 @@
+#include <QQmlApplicationEngine>
+#include <QQmlContext>
+#include <QQuickWindow>
+#include <QThread>
+#include <QTimer>
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QSemaphore>
+#include <QMutex>
+#include <QCoreApplication>
+#include <functional>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#ifdef Q_OS_UNIX
+#include <time.h>
+#endif
+#include "benchmarks.h"
+#include "sessionmanager.h"
+#include "svserver.h"
+#include "vehiclesimulator.h"
+#include "svtrace.h"
+
+//allocations of the thread, the allocator is replaced for the whole benchmark process
+//and only this benchmark reads the counter
+static thread_local quint64 threadAllocations = 0;
+
+#ifdef __GLIBC__
+//malloc itself, so Qt containers, QString and C allocations are counted along with operator new
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *memory, size_t size);
+void __libc_free(void *memory);
+
+void *malloc(size_t size)   {
+    threadAllocations++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    threadAllocations++;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *memory, size_t size)    {
+    threadAllocations++;
+    return __libc_realloc(memory, size);
+}
+
+void free(void *memory) {
+    __libc_free(memory);
+}
+}
+#else
+//operator new only, malloc can't be replaced portably
+void* operator new(size_t size) {
+    threadAllocations++;
+    if (void *memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+#endif
+
+struct ThreadUsage {
+    qint64 cpu = 0;     //nsec
+    quint64 allocations = 0;
+};
+
+static ThreadUsage threadUsage()    {
+    ThreadUsage usage;
+#ifdef Q_OS_UNIX
+    timespec time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    usage.cpu = time.tv_sec * 1000000000LL + time.tv_nsec;
+#endif
+    usage.allocations = threadAllocations;
+    return usage;
+}
+
+//runs the function in the thread of the object and waits for it
+static void runIn(QObject *context, std::function<void()> const& function)  {
+    QSemaphore done;
+    QTimer::singleShot(0, context, [&function, &done]  {
+        function();
+        done.release();
+    });
+    done.acquire();
+}
+
+static ThreadUsage threadUsage(QObject *context)    {
+    ThreadUsage usage;
+    runIn(context, [&usage] { usage = threadUsage(); });
+    return usage;
+}
+
+//processes GUI events until the condition or the timeout
+static bool waitFor(std::function<bool()> const& condition, int msec)    {
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition())    {
+        if (timer.elapsed() > msec)
+            return false;
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    }
+    return true;
+}
+
+static QtMessageHandler defaultHandler = nullptr;
+
+//per package debug output of the client and the adapter is formatted but not printed
+static void quietHandler(QtMsgType type, QMessageLogContext const& context, QString const& message) {
+    if (type != QtDebugMsg)
+        defaultHandler(type, context, message);
+}
+
+//empty square map with the wall border
+static MapPackage makeMap(int size)    {
+    QVector<QVector<qint8>> cells(size, QVector<qint8>(size, MapPackage::EMPTY));
+    for (int i = 0; i < size; i++)  {
+        cells[0][i] = cells[size - 1][i] = MapPackage::WALL;
+        cells[i][0] = cells[i][size - 1] = MapPackage::WALL;
+    }
+    return MapPackage(cells);
+}
+
+//the whole GUI (sessions, client in the I/O thread, adapter, main.qml) gets telemetry
+//from the simulated vehicle served by SVServer in another thread of the process;
+//CPU time and allocations are of the GUI and the I/O threads (the render thread too
+//if the render loop isn't threaded), frames are timed by the window signals
+int benchPipeline(QStringList const& args)  {
+    int maxRate = argValue(args, "--max-rate", 5000);
+    int seconds = argValue(args, "--seconds", 5);
+    int port = argValue(args, "--port", 5599);
+    int updateRate = argValue(args, "--update-rate", 60);
+    int traceIndex = args.indexOf("--trace");
+    QString traceFile = traceIndex >= 0 && traceIndex + 1 < args.size() ? args.at(traceIndex + 1) : QString();
+    if (!args.contains("--opengl"))
+        QQuickWindow::setSceneGraphBackend(QSGRendererInterface::Software);
+    if (!args.contains("--log"))
+        defaultHandler = qInstallMessageHandler(quietHandler);
+
+    //vehicle side
+    QThread serverThread;
+    serverThread.setObjectName("SVServer");
+    serverThread.start();
+    QObject *serverContext = new QObject();
+    serverContext->moveToThread(&serverThread);
+    MapPackage map = makeMap(100);
+    SVServer *server = nullptr;
+    VehicleSimulator *simulator = nullptr;
+    std::atomic<qint64> sent(0);
+    bool listening = false;
+    runIn(serverContext, [&] {
+        server = new SVServer();
+        listening = server->start(QHostAddress::LocalHost, static_cast<quint16>(port));
+        QObject::connect(server, &SVServer::signalNewConnection, [server, &map] {
+            server->slotSendMap(map);
+        });
+    });
+
+    //GUI side
+    SessionManager sessions;
+    sessions.slotUIAddSession();
+    sessions.slotUISetUpdateRate(updateRate);
+    Adapter *adapter = sessions.currentAdapter();
+    SVClient *client = sessions.currentClient();
+    std::atomic<qint64> received(0);
+    QObject::connect(client, static_cast<void (SVClient::*)(HighFreqDataPackage const&)>(&SVClient::signalUIData),
+                     [&received](HighFreqDataPackage const&) { received++; });
+    QObject::connect(client, &SVClient::signalUIDataBatch,
+                     [&received](TelemetryColumns const& batch) { received += batch.size(); });
+
+    QQmlApplicationEngine engine;
+    engine.rootContext()->setContextProperty("sessions", &sessions);
+    engine.rootContext()->setContextProperty("adapter", adapter);
+    engine.load(QUrl(QStringLiteral("qrc:/main.qml")));
+    QQuickWindow *window = engine.rootObjects().isEmpty() ? nullptr : qobject_cast<QQuickWindow*>(engine.rootObjects().first());
+    bool connected = false;
+    QObject::connect(adapter, &Adapter::signalUIConnected, [&connected] { connected = true; });
+    if (listening && window)
+        adapter->slotUIConnect("127.0.0.1", QString::number(port));
+    if (!listening || window == nullptr || !waitFor([&connected] { return connected; }, 5000))    {
+        qWarning() << "Pipeline is not ready: server" << listening << "window" << (window != nullptr) << "connected" << connected;
+        runIn(serverContext, [&server] { delete server; });
+        serverThread.quit();
+        serverThread.wait();
+        delete serverContext;
+        return 1;
+    }
+
+    //the whole run is traced, the buffers keep the last events of every thread
+    if (!traceFile.isEmpty())
+        SVTrace::setEnabled(true);
+
+    //frames are timed on the render thread
+    QMutex frameMutex;
+    QElapsedTimer frameClock;
+    frameClock.start();
+    QVector<qint64> intervals;
+    QVector<qint64> renders;
+    qint64 lastSwap = -1;
+    qint64 renderStart = 0;
+    QObject::connect(window, &QQuickWindow::beforeRendering, [&] {
+        renderStart = frameClock.nsecsElapsed();
+    });
+    QObject::connect(window, &QQuickWindow::afterRendering, [&] {
+        QMutexLocker lock(&frameMutex);
+        renders.append(frameClock.nsecsElapsed() - renderStart);
+    });
+    QObject::connect(window, &QQuickWindow::frameSwapped, [&] {
+        QMutexLocker lock(&frameMutex);
+        qint64 now = frameClock.nsecsElapsed();
+        if (lastSwap >= 0)
+            intervals.append(now - lastSwap);
+        lastSwap = now;
+    });
+
+    qInfo() << "GUI pipeline," << seconds << "s per rate, UI update rate" << updateRate << "Hz";
+    QVector<int> rates;
+    for (int rate = 100; rate < maxRate; rate *= 2)
+        rates.append(rate);
+    rates.append(maxRate);
+    for (int rate : rates)  {
+        adapter->slotUIClearCharts();
+        sent = 0;
+        received = 0;
+        {
+            QMutexLocker lock(&frameMutex);
+            intervals.clear();
+            renders.clear();
+            lastSwap = -1;
+        }
+        ThreadUsage gui0 = threadUsage();
+        ThreadUsage io0 = threadUsage(client);
+
+        runIn(serverContext, [&] {
+            VehicleSimulator::Config config;
+            config.highFreqRate = rate;
+            simulator = new VehicleSimulator(map, config);
+            simulator->setPose(50.5, 50.5, 0);
+            QObject::connect(simulator, &VehicleSimulator::signalHighFreqData, server, &SVServer::slotSendHighFreqData);
+            QObject::connect(simulator, &VehicleSimulator::signalLowFreqData, server, &SVServer::slotSendLowFreqData);
+            QObject::connect(simulator, &VehicleSimulator::signalHighFreqData, [&sent] { sent++; });
+            //slow circles, the controls come like from the control panel
+            QTimer *control = new QTimer(simulator);
+            QObject::connect(control, &QTimer::timeout, simulator, [simulator] {
+                ControlPackage data;
+                data.xAxis = 0.3f;
+                data.yAxis = 0.5f;
+                simulator->slotControl(data);
+            });
+            control->start(100);
+            simulator->start();
+        });
+        QEventLoop loop;
+        QTimer::singleShot(seconds * 1000, &loop, &QEventLoop::quit);
+        loop.exec();
+        runIn(serverContext, [&simulator] {
+            simulator->stop();
+            delete simulator;
+        });
+
+        //samples still on the way are processed too
+        QElapsedTimer drain;
+        drain.start();
+        bool drained = waitFor([&sent, &received] { return received >= sent; }, 5000);
+        qint64 drainTime = drain.elapsed();
+        QCoreApplication::processEvents();
+
+        ThreadUsage gui1 = threadUsage();
+        ThreadUsage io1 = threadUsage(client);
+        QVector<qint64> frameIntervals;
+        QVector<qint64> frameRenders;
+        {
+            QMutexLocker lock(&frameMutex);
+            frameIntervals = intervals;
+            frameRenders = renders;
+        }
+        int dropped = 0;
+        for (qint64 interval : frameIntervals)
+            dropped += qMax(0, qRound(interval / (1000000000.0 / 60)) - 1);
+
+        qint64 receivedSamples = received;
+        qint64 samples = qMax<qint64>(receivedSamples, 1);
+        qInfo().noquote() << QString("%1 samples/s: %2 of %3 received, drained in %4 ms%5")
+                             .arg(rate).arg(receivedSamples).arg(static_cast<qint64>(sent)).arg(drainTime)
+                             .arg(drained ? "" : " (timeout)");
+        qInfo().noquote() << QString("  CPU %1 us/sample (GUI %2, I/O %3), allocations %4/sample (GUI %5, I/O %6)")
+                             .arg((gui1.cpu - gui0.cpu + io1.cpu - io0.cpu) / 1000.0 / samples, 0, 'f', 2)
+                             .arg((gui1.cpu - gui0.cpu) / 1000.0 / samples, 0, 'f', 2)
+                             .arg((io1.cpu - io0.cpu) / 1000.0 / samples, 0, 'f', 2)
+                             .arg(static_cast<double>(gui1.allocations - gui0.allocations + io1.allocations - io0.allocations) / samples, 0, 'f', 1)
+                             .arg(static_cast<double>(gui1.allocations - gui0.allocations) / samples, 0, 'f', 1)
+                             .arg(static_cast<double>(io1.allocations - io0.allocations) / samples, 0, 'f', 1);
+        qInfo().noquote() << QString("  %1 frames, %2 dropped at 60 fps").arg(frameIntervals.size() + 1).arg(dropped);
+        printStats("  frame interval", frameIntervals);
+        printStats("  frame render", frameRenders);
+    }
+
+    if (!traceFile.isEmpty())   {
+        SVTrace::setEnabled(false);
+        SVTrace::dump(traceFile);
+    }
+    adapter->slotUIDisconnect();
+    runIn(serverContext, [&server] { delete server; });
+    serverThread.quit();
+    serverThread.wait();
+    delete serverContext;
+    if (defaultHandler)
+        qInstallMessageHandler(defaultHandler);
+    return 0;
+}
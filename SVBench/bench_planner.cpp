@@ -0,0 +1,158 @@
+#include <QElapsedTimer>
+#include <queue>
+#include <functional>
+#include "benchmarks.h"
+#include "gridplanner.h"
+
+//plain A* on the same moves (8-connected, no corner cutting) as the reference
+static float planAStar(GridPlanner const& grid, QPoint const& start, QPoint const& goal)    {
+    int width = grid.getWidth();
+    QVector<float> cost(width * grid.getHeight(), 1e30f);
+    auto heuristic = [&goal](int x, int y) {
+        int dx = qAbs(x - goal.x());
+        int dy = qAbs(y - goal.y());
+        return qAbs(dx - dy) + 1.41421356f * qMin(dx, dy);
+    };
+    typedef QPair<float, int> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    cost[start.y() * width + start.x()] = 0;
+    open.push(Entry(heuristic(start.x(), start.y()), start.y() * width + start.x()));
+    while (!open.empty())   {
+        Entry entry = open.top();
+        open.pop();
+        int x = entry.second % width;
+        int y = entry.second / width;
+        float g = cost.at(entry.second);
+        if (entry.first > g + heuristic(x, y) + 1e-3f)
+            continue;
+        if (x == goal.x() && y == goal.y())
+            return g;
+        for (int dy = -1; dy <= 1; dy++)
+            for (int dx = -1; dx <= 1; dx++)    {
+                if ((!dx && !dy) || grid.isWall(x + dx, y + dy))
+                    continue;
+                if (dx && dy && (grid.isWall(x + dx, y) || grid.isWall(x, y + dy)))
+                    continue;
+                float next = g + (dx && dy ? 1.41421356f : 1.0f);
+                int cell = (y + dy) * width + x + dx;
+                if (next < cost.at(cell))   {
+                    cost[cell] = next;
+                    open.push(Entry(next + heuristic(x + dx, y + dy), cell));
+                }
+            }
+    }
+    return -1;
+}
+
+static quint32 nextRandom(quint32 &seed)    {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+//rooms of the size with 3 cells doors in every wall, and random single cell obstacles
+static void fillMap(GridPlanner &grid, int size, int room, int obstacles)    {
+    grid.setSize(size, size);
+    quint32 seed = 4242;
+    for (int y = 0; y < size; y++)
+        for (int x = 0; x < size; x++)  {
+            bool wall = false;
+            if (room && (x % room == 0 || y % room == 0))   {
+                int door = ((x / room) * 7 + (y / room) * 13) % (room - 6) + 3;
+                bool doorX = x % room == 0 && y % room >= door && y % room < door + 3;
+                bool doorY = y % room == 0 && x % room >= door && x % room < door + 3;
+                wall = !doorX && !doorY;
+            }
+            if (static_cast<int>(nextRandom(seed) % 1000) < obstacles)
+                wall = true;
+            if (wall)
+                grid.setCell(x, y, true);
+        }
+}
+
+static QPoint randomFreeCell(GridPlanner const& grid, quint32 &seed)   {
+    for (;;)    {
+        QPoint cell(nextRandom(seed) % grid.getWidth(), nextRandom(seed) % grid.getHeight());
+        if (!grid.isWall(cell.x(), cell.y()))
+            return cell;
+    }
+}
+
+//plans between random free cells, checks the length by A* on a few queries
+//and replans after a new wall on the path and after a change far from it
+static void runPlanner(QString const& name, GridPlanner &grid, int queries, int checks)    {
+    QVector<qint64> planNsecs;
+    QVector<qint64> blockedNsecs;
+    QVector<qint64> keptNsecs;
+    QVector<qint64> astarNsecs;
+    qint64 expanded = 0;
+    int mismatches = 0;
+    quint32 seed = 17;
+    QElapsedTimer timer;
+
+    for (int query = 0; query < queries; query++)   {
+        QPoint start = randomFreeCell(grid, seed);
+        QPoint goal = randomFreeCell(grid, seed);
+        timer.start();
+        bool planned = grid.plan(start, goal);
+        planNsecs.append(timer.nsecsElapsed());
+        expanded += grid.getExpanded();
+
+        if (query < checks) {
+            timer.start();
+            float reference = planAStar(grid, start, goal);
+            astarNsecs.append(timer.nsecsElapsed());
+            //float sums of long paths differ in the last digits
+            if (planned != (reference >= 0) || (planned && qAbs(grid.getPathLength() - reference) > reference * 1e-4f))
+                mismatches++;
+        }
+        if (!planned || grid.getPath().size() < 2)
+            continue;
+
+        //a cell far from the path changes, the path is kept
+        QPoint far(grid.getWidth() - 1 - goal.x(), grid.getHeight() - 1 - goal.y());
+        bool farWall = grid.isWall(far.x(), far.y());
+        grid.setCell(far.x(), far.y(), true);
+        timer.start();
+        grid.replan(start);
+        keptNsecs.append(timer.nsecsElapsed());
+        grid.setCell(far.x(), far.y(), farWall);
+
+        //new wall on the path
+        QVector<QPoint> cells = GridPlanner::cells(grid.getPath());
+        QPoint blocked = cells.at(cells.size() / 2);
+        if (blocked == start || blocked == goal)
+            continue;
+        grid.setCell(blocked.x(), blocked.y(), true);
+        timer.start();
+        grid.replan(start);
+        blockedNsecs.append(timer.nsecsElapsed());
+        grid.setCell(blocked.x(), blocked.y(), false);
+    }
+
+    qInfo().noquote() << QString("%1: %2 cells expanded per plan, %3 length mismatches with A*")
+                         .arg(name).arg(expanded / qMax(queries, 1)).arg(mismatches);
+    printStats("  JPS plan", planNsecs);
+    printStats("  A* plan", astarNsecs);
+    printStats("  replan, path kept", keptNsecs);
+    printStats("  replan, path blocked", blockedNsecs);
+}
+
+int benchPlanner(QStringList const& args)   {
+    int size = argValue(args, "--size", 2000);
+    int queries = argValue(args, "--queries", 50);
+    int checks = argValue(args, "--checks", 5);
+
+    qInfo() << "Grid planner," << size << "x" << size << "cells," << queries << "queries";
+    GridPlanner grid;
+    fillMap(grid, size, 0, 0);
+    runPlanner("Open", grid, queries, checks);
+    fillMap(grid, size, 50, 0);
+    runPlanner("Rooms 50x50", grid, queries, checks);
+    fillMap(grid, size, 100, 0);
+    runPlanner("Rooms 100x100", grid, queries, checks);
+    fillMap(grid, size, 50, 10);
+    runPlanner("Rooms 50x50, 1% obstacles", grid, queries, checks);
+    fillMap(grid, size, 0, 100);
+    runPlanner("Random 10% obstacles", grid, queries, checks);
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include <QQuickView>
+#include <QQmlComponent>
+#include <QQmlEngine>
+#include <QElapsedTimer>
+#include <QtMath>
+#include "benchmarks.h"
+#include "svmapitem.h"
+#include "trajectorytrail.h"
+#include "datapackage.h"
+
+static const char mapScene[] =
+        "import QtQuick 2.9\n"
+        "import SmartVehicle 1.0\n"
+        "SVMap {\n"
+        "    anchors.fill: parent\n"
+        "}\n";
+
+//drives over the map for hours, the trail gets every position sample and the map
+//is rendered once per simulated second; append and frame time shouldn't grow
+int benchTrail(QStringList const& args)  {
+    int hours = argValue(args, "--hours", 4);
+    int rate = argValue(args, "--rate", 100);
+    int size = argValue(args, "--size", 500);
+    if (!args.contains("--opengl"))
+        QQuickWindow::setSceneGraphBackend(QSGRendererInterface::Software);
+
+    QQuickView view;
+    view.resize(800, 800);
+    view.show();
+    QQmlComponent component(view.engine());
+    component.setData(mapScene, QUrl());
+    SVMapItem *map = qobject_cast<SVMapItem*>(component.create());
+    if (map == nullptr) {
+        qWarning() << component.errors();
+        return 1;
+    }
+    map->setParentItem(view.contentItem());
+    map->setMap(size, size, QByteArray(size * size, static_cast<char>(MapPackage::EMPTY)));
+    TrajectoryTrail trail;
+    map->setTrail(&trail);
+
+    qInfo() << "Trajectory trail," << hours << "hours at" << rate << "samples/s," << size << "x" << size << "cells map";
+    QVector<qint64> appendNsecs;
+    QVector<qint64> frameNsecs;
+    int maxPoints = 0;
+    qreal x = size / 2.0;
+    qreal y = size / 2.0;
+    qreal angle = 0;
+    quint32 seed = 777;
+    QElapsedTimer timer;
+    int seconds = hours * 3600;
+    for (int second = 0; second < seconds; second++)    {
+        //1 cell/s, slow turns with sharp ones now and then, bounced back from the map border
+        timer.start();
+        for (int i = 0; i < rate; i++)  {
+            seed = seed * 1664525u + 1013904223u;
+            angle += 0.5 * qSin(second / 30.0) / rate + ((seed >> 24) == 0 ? 0.5 : 0);
+            x += qCos(angle) / rate;
+            y += qSin(angle) / rate;
+            if (x < 1 || y < 1 || x > size - 1 || y > size - 1)  {
+                angle += M_PI;
+                x = qBound(1.0, x, size - 1.0);
+                y = qBound(1.0, y, size - 1.0);
+            }
+            trail.append(QPointF(x, y));
+        }
+        appendNsecs.append(timer.nsecsElapsed() / rate);
+        maxPoints = qMax(maxPoints, trail.getPoints().size());
+
+        timer.start();
+        map->updateTrail();
+        view.grabWindow();
+        frameNsecs.append(timer.nsecsElapsed());
+    }
+
+    printStats("Trail append, per sample", appendNsecs);
+    printStats("Map frame with the trail", frameNsecs);
+    qInfo().noquote() << QString("Trail vertices: %1 now, %2 max, %3 samples")
+                         .arg(trail.getPoints().size()).arg(maxPoints).arg(static_cast<qint64>(seconds) * rate);
+    delete map;
+    return 0;
+}
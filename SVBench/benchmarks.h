@@ -0,0 +1,50 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <QStringList>
+#include <QVector>
+#include <QString>
+#include <QDebug>
+#include <algorithm>
+
+//every benchmark gets arguments after its name and returns the process exit code
+int benchCharts(QStringList const& args);
+int benchFilters(QStringList const& args);
+int benchMap(QStringList const& args);
+int benchPlanner(QStringList const& args);
+int benchTrail(QStringList const& args);
+int benchPipeline(QStringList const& args);
+int benchCompression(QStringList const& args);
+int benchBatch(QStringList const& args);
+
+//value of "--name value" argument
+inline int argValue(QStringList const& args, QString const& name, int defaultValue)  {
+    int index = args.indexOf(name);
+    if (index < 0 || index + 1 >= args.size())
+        return defaultValue;
+    return args.at(index + 1).toInt();
+}
+
+//prints mean and percentiles of the measured durations
+inline void printStats(QString const& name, QVector<qint64> nsecs)  {
+    if (nsecs.isEmpty())
+        return;
+    std::sort(nsecs.begin(), nsecs.end());
+    qint64 sum = 0;
+    for (qint64 value : nsecs)
+        sum += value;
+    auto percentile = [&nsecs](double p) {
+        int index = qMin(nsecs.size() - 1, static_cast<int>(p * nsecs.size()));
+        return nsecs.at(index) / 1000.0;
+    };
+    qInfo().noquote() << QString("%1: mean %2 us, p50 %3 us, p95 %4 us, p99 %5 us, max %6 us (%7 samples)")
+                         .arg(name, -28)
+                         .arg(sum / 1000.0 / nsecs.size(), 0, 'f', 1)
+                         .arg(percentile(0.5), 0, 'f', 1)
+                         .arg(percentile(0.95), 0, 'f', 1)
+                         .arg(percentile(0.99), 0, 'f', 1)
+                         .arg(nsecs.last() / 1000.0, 0, 'f', 1)
+                         .arg(nsecs.size());
+}
+
+#endif // BENCHMARKS_H
@@ -0,0 +1,57 @@
+#include <QApplication>
+#include <QtQml>
+#include <QDebug>
+#include "benchmarks.h"
+#include "svchartitem.h"
+#include "svmapitem.h"
+
+void usage()    {
+    qInfo() << "Usage: SVBench <benchmark> [options]";
+    qInfo() << "  charts [--points N] [--frames N] [--opengl]    chart render time, QtCharts vs SVChart";
+    qInfo() << "  filters [--samples N] [--block N] [--runs N]    filter throughput";
+    qInfo() << "  map [--size N] [--frames N] [--repeater-limit N] [--pan-size N] [--opengl]    map load, render and pan time";
+    qInfo() << "  planner [--size N] [--queries N] [--checks N]    grid path planning and replanning time";
+    qInfo() << "  trail [--hours N] [--rate N] [--size N] [--opengl]    trajectory trail append and render time";
+    qInfo() << "  pipeline [--max-rate N] [--seconds N] [--update-rate N] [--port N] [--log] [--opengl] [--trace FILE]    GUI CPU time, allocations and frames per telemetry rate";
+    qInfo() << "  compression [--file FILE.svtx] [--minutes N] [--rate N] [--keyframe N]    compressed telemetry size and error";
+    qInfo() << "  batch [--samples N] [--runs N]    bulk telemetry decoding vs the package constructor, samples/s";
+}
+
+int main(int argc, char *argv[])
+{
+    //benchmarks are running without display and GPU by default
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+
+    qmlRegisterType<SVChartItem>("SmartVehicle", 1, 0, "SVChart");
+    qmlRegisterType<SVMapItem>("SmartVehicle", 1, 0, "SVMap");
+
+    QStringList args = app.arguments();
+    args.removeFirst();
+    if (args.isEmpty()) {
+        usage();
+        return 1;
+    }
+
+    QString name = args.takeFirst();
+    if (name == "charts")
+        return benchCharts(args);
+    if (name == "filters")
+        return benchFilters(args);
+    if (name == "map")
+        return benchMap(args);
+    if (name == "planner")
+        return benchPlanner(args);
+    if (name == "trail")
+        return benchTrail(args);
+    if (name == "pipeline")
+        return benchPipeline(args);
+    if (name == "compression")
+        return benchCompression(args);
+    if (name == "batch")
+        return benchBatch(args);
+
+    usage();
+    return 1;
+}
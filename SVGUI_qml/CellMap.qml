@@ -1,26 +1,42 @@
 import QtQuick 2.9
 import QtQuick.Controls 2.4
+import SmartVehicle 1.0
 
 Item {
     property int map_width: 0
     property int map_height: 0
-    property var cellList: undefined
     property bool isVisible: false
     property int header_height: 50
-    property double cell_width: container.width / map_width
-    property double cell_height: (container.height - header_height) / map_height
+    property double cell_width: map_view.cellSize
+    property double cell_height: map_view.cellSize
+    property var mapView: map_view
+    property real vehicle_x: 0
+    property real vehicle_y: 0
+    property int goal_x: -1
+    property int goal_y: -1
 
-    function setMap(w, h, newCellList)   {
+    //cells are passed to the map view by the adapter
+    function setMap(w, h)   {
         map_height = h;
         map_width = w;
-        cellList = newCellList;
-        isVisible = true;
-        vehicle_img.visible = true;
+        isVisible = w > 0 && h > 0;
+        goal_x = -1;
+        vehicle_img.visible = isVisible;
     }
     function setPos(x, y, angle) {
-        vehicle_img.x = x * cell_width - vehicle_img.width / 2;
-        vehicle_img.y = y * cell_height - vehicle_img.height / 2 + header_height;
+        vehicle_x = x;
+        vehicle_y = y;
         vehicle_img.rotation = angle;
+        placeVehicle();
+    }
+    //vehicle follows the map pan and zoom
+    function placeVehicle() {
+        var pos = map_view.mapToView(vehicle_x, vehicle_y);
+        vehicle_img.x = pos.x - vehicle_img.width / 2;
+        vehicle_img.y = pos.y - vehicle_img.height / 2;
+        var goal = map_view.mapToView(goal_x + 0.5, goal_y + 0.5);
+        goal_marker.x = goal.x - goal_marker.width / 2;
+        goal_marker.y = goal.y - goal_marker.height / 2;
     }
 
     Rectangle   {
@@ -55,36 +71,39 @@ Item {
             visible: !isVisible
         }
 
-        Image {
-            id: vehicle_img
-            x: 0; y: 0
-            visible: false
-            width: cell_width / 3
-            height: cell_height / 2
-            source: "vehicle.png"
-            z: 10
-        }
-
-        Column  {
+        //drag to pan, wheel to zoom, double click to fit the whole map, right click to send the vehicle to the cell
+        SVMap   {
+            id: map_view
             x: 0; y: header_height
-            Repeater    {
-                id: column_repeater
-                model: map_height
-                delegate: Row {
-                    id: row_container
-                    Repeater    {
-                        id: row_repeater
-                        property int column_index: index
-                        model: map_width
-                        delegate: Rectangle   {
-                             width: cell_width
-                             height: cell_height
-                             color: (cellList[row_repeater.column_index * map_width + index] !== 1) ? "white" : "lightgray"
-                             border.width: 1
-                             border.color: "gray"
-                        }
-                    }
-                }
+            width: container.width
+            height: container.height - header_height
+            visible: isVisible
+            onSignalViewChanged: placeVehicle()
+            onSignalCellClicked:    {
+                goal_x = x;
+                goal_y = y;
+                placeVehicle();
+                adapter.slotUIGoal(x, y);
+            }
+
+            Rectangle   {
+                id: goal_marker
+                width: Math.max(cell_width / 2, 8)
+                height: width
+                radius: width / 2
+                color: "#4fc622"
+                visible: isVisible && goal_x >= 0
+                z: 9
+            }
+
+            Image {
+                id: vehicle_img
+                x: 0; y: 0
+                visible: false
+                width: cell_width / 3
+                height: cell_height / 2
+                source: "vehicle.png"
+                z: 10
             }
         }
     }
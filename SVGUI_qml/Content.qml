@@ -1,33 +1,31 @@
 import QtQuick 2.9
 import QtQuick.Controls 2.4
 import QtQuick.Layouts 1.1
-import QtCharts 2.2
 
 Item {
-    property var speedSeries: charts_speed_series
-    property var steeringSeries: charts_steering_series
-    property var tempSeries: charts_temp_series
-    property var tempSeriesFilter: charts_temp_series_filter
-    property var speedSeriesFilter: charts_speed_series_filtered
+    property var speedSeries: charts_speed.series
+    property var steeringSeries: charts_steering.series
+    property var tempSeries: charts_temp.series
+    property var tempSeriesFilter: charts_temp.filterSeries
+    property var speedSeriesFilter: charts_speed.filterSeries
+    property var derivedSeries: charts_derived.series
 
     function log(message)   {
         log_textArea.append(message);
         log_textArea.cursorPosition = log_textArea.length - 1;
     }
-    function encoderSet(encValue)   {
-        values_list_model.setProperty(0, "value", encValue);
+    function exportingSet(exporting)    {
+        charts_export_button.checked = exporting;
     }
-    function potentiometerSet(potValue) {
-        values_list_model.setProperty(1, "value", potValue);
-    }    
-    function speedSet(speedValue)   {
-        values_list_model.setProperty(2, "value", speedValue);
+    function historyApproximateSet(approximate) {
+        charts_history_approximate.visible = approximate;
     }
-    function tempSet(temp)  {
-        values_list_model.setProperty(3, "value", temp);
+    function statsSet(rows) {
+        stats_list.model = rows;
     }
-    function batterySet(number, batValue)   {
-        values_list_model.setProperty(3 + number, "value", batValue);
+    function derivedSet(names, current)    {
+        charts_derived_comboBox.model = names;
+        charts_derived_comboBox.currentIndex = current;
     }
 
     Rectangle   {
@@ -51,6 +49,11 @@ Item {
                     text: qsTr("Show values")
                     checked: true
                 }
+                Switch    {
+                    id: toolBar_stats_switch
+                    text: qsTr("Show statistics")
+                    checked: false
+                }
                 Switch    {
                     id: toolBar_charts_switch
                     text: qsTr("Show charts")
@@ -67,7 +70,7 @@ Item {
                 ColumnLayout    {
                     Layout.fillHeight: true
                     Layout.fillWidth: true
-                    visible: toolBar_log_switch.checked || toolBar_values_switch.checked
+                    visible: toolBar_log_switch.checked || toolBar_values_switch.checked || toolBar_stats_switch.checked
                     Rectangle   {
                         id: log_container
                         visible: toolBar_log_switch.checked
@@ -162,44 +165,85 @@ Item {
                             anchors.margins: 20
                             anchors.topMargin: 40
                             anchors.fill: parent
+                            clip: true
 
-                            model:  ListModel   {
-                                id: values_list_model
-                                ListElement {
-                                    name: "Odometry"
-                                    value: 0
-                                    measure: "m"
-                                }
-                                ListElement {
-                                    name: "Steering wheel"
-                                    value: 0
-                                    measure: "°"
-                                }
-                                ListElement {
-                                    name: "Speed"
-                                    value: 0
-                                    measure: "mps"
-                                }
-                                ListElement {
-                                    name: "Temperature"
-                                    value: 0
-                                    measure: "°С"
-                                }
-                                ListElement {
-                                    name: "Motor battery"
-                                    value: 0
-                                    measure: "%"
-                                }
-                                ListElement {
-                                    name: "Computer battery"
-                                    value: 0
-                                    measure: "%"
+                            //channels of the current vehicle, rows are updated once per frame
+                            model: adapter.channels
+
+                            delegate: Text {
+                                font.pointSize: 12
+                                text: title + ": " + value.toPrecision(4) + " " + measure
+                            }
+                        }
+                    }
+
+                    Rectangle   {
+                        id: stats_container
+                        visible: toolBar_stats_switch.checked
+                        Layout.columnSpan: 20
+                        Layout.rowSpan: 20
+                        Layout.fillHeight: true
+                        Layout.fillWidth: true
+                        anchors.margins: 10
+                        anchors.leftMargin: 20
+                        anchors.rightMargin: 20
+                        color: "#f4f4f4"
+
+                        Label {
+                            id: stats_label
+                            text: qsTr("Statistics")
+                            anchors.left: parent.left
+                            anchors.leftMargin: 40
+                            anchors.top: parent.top
+                            anchors.topMargin: 5
+                            font.bold: true
+                            font.pointSize: 14
+                        }
+
+                        Image   {
+                            x: 0; y: 0
+                            width: 30; height: 30
+                            source: "corner.png"
+                        }
+
+                        RowLayout   {
+                            id: stats_control_panel
+                            anchors.top: stats_label.bottom
+                            anchors.left: parent.left
+                            anchors.leftMargin: 20
+                            Switch  {
+                                id: stats_window_switch
+                                text: qsTr("Last seconds")
+                                font.pointSize: 10
+                            }
+                            SpinBox {
+                                id: stats_window_spinBox
+                                enabled: stats_window_switch.checked
+                                editable: true
+                                from: 5; to: 3600
+                                value: 60
+                                onValueModified: {
+                                    adapter.slotUISetStatsWindow(value);
                                 }
                             }
+                        }
+
+                        ListView    {
+                            id: stats_list
+                            spacing: 5
+                            clip: true
+                            anchors.fill: parent
+                            anchors.margins: 20
+                            anchors.topMargin: stats_label.height + stats_control_panel.height + 15
 
                             delegate: Text {
-                                font.pointSize: 12
-                                text: name + ": " + value.toPrecision(4) + " " + measure
+                                property var stats: stats_window_switch.checked ? modelData.window : modelData.session
+                                font.pointSize: 10
+                                text: modelData.name + ": min " + stats.min.toPrecision(4) + ", max " + stats.max.toPrecision(4) +
+                                      ", mean " + stats.mean.toPrecision(4) + " ± " + stats.std.toPrecision(3) +
+                                      ", p50 " + stats.p50.toPrecision(4) + ", p95 " + stats.p95.toPrecision(4) +
+                                      ", p99 " + stats.p99.toPrecision(4) +
+                                      (stats.rejected > 0 ? ", rejected " + stats.rejected : "")
                             }
                         }
                     }
@@ -251,6 +295,59 @@ Item {
                             }
                         }
 
+                        RowLayout {
+                            Layout.leftMargin: 10; Layout.rightMargin: 10
+                            Layout.fillWidth: true
+
+                            ComboBox    {
+                                id: charts_export_comboBox
+                                enabled: !charts_export_button.checked
+                                //values are TelemetryExporter::Format flags
+                                model: ListModel    {
+                                    ListElement { text: "CSV"; formats: 1 }
+                                    ListElement { text: "Binary"; formats: 2 }
+                                    ListElement { text: "CSV + Binary"; formats: 3 }
+                                }
+                                textRole: "text"
+                            }
+
+                            Button  {
+                                id: charts_export_button
+                                Layout.fillWidth: true
+                                checkable: true
+                                text: checked ? qsTr("Stop export") : qsTr("Export telemetry")
+                                font.pointSize: 12
+                                onClicked: {
+                                    if (checked)
+                                        adapter.slotUIExportStart(charts_export_comboBox.model.get(charts_export_comboBox.currentIndex).formats);
+                                    else
+                                        adapter.slotUIExportStop();
+                                }
+                            }
+                        }
+
+                        RowLayout {
+                            Layout.leftMargin: 10; Layout.rightMargin: 10
+                            Layout.fillWidth: true
+
+                            TextField   {
+                                id: charts_replay_path
+                                Layout.fillWidth: true
+                                placeholderText: qsTr("Latest recording (.svtx)")
+                                selectByMouse: true
+                            }
+
+                            Button  {
+                                id: charts_replay_button
+                                text: qsTr("Replay")
+                                font.pointSize: 12
+                                enabled: !charts_export_button.checked
+                                onClicked: {
+                                    adapter.slotUIReplay(charts_replay_path.text);
+                                }
+                            }
+                        }
+
                         RowLayout {
                             Layout.margins: 10
                             Layout.fillHeight: true
@@ -267,23 +364,29 @@ Item {
 
                             ComboBox    {
                                 id: charts_filter_comboBox
-                                model: ["None", "Kalman", "Gliding Average"]
+                                model: ["None", "Kalman", "Gliding Average", "Kalman (velocity)", "Low-pass",
+                                    "Median", "Savitzky-Golay", "Median + Low-pass"]
                                 displayText: currentText
                                 onActivated: {
                                     adapter.slotUISetFilter(currentIndex);
                                 }
                             }
 
+                            //every K change restarts the filter over the shown history, it's done once per pause of the slider
+                            Timer   {
+                                id: charts_filter_timer
+                                interval: 50
+                                onTriggered: adapter.slotUISetFilterK(charts_filter_slider.value)
+                            }
+
                             Slider {
                                 id: charts_filter_slider
-                                visible: charts_filter_comboBox.currentIndex == 1
+                                visible: [1, 3, 4, 7].indexOf(charts_filter_comboBox.currentIndex) >= 0
                                 Layout.alignment: Qt.AlignLeft
                                 width: parent.width / 2
                                 from: 0; to: 1;
                                 value: 0.5
-                                onValueChanged: {
-                                    adapter.slotUISetFilterK(value);
-                                }
+                                onValueChanged: charts_filter_timer.restart()
                                 Label   {
                                     font.pointSize: 10
                                     color: "#4fc622"
@@ -294,6 +397,61 @@ Item {
                             }
 
                         }
+
+                        RowLayout {
+                            id: charts_history_row
+                            Layout.leftMargin: 10; Layout.rightMargin: 10
+                            Layout.fillWidth: true
+
+                            function showHistory()  {
+                                if (charts_live_switch.checked)
+                                    adapter.slotUILive();
+                                else
+                                    adapter.slotUIHistory(charts_history_slider.value, charts_history_range.value);
+                            }
+
+                            Switch  {
+                                id: charts_live_switch
+                                text: qsTr("Live")
+                                font.pointSize: 12
+                                checked: true
+                                onCheckedChanged: parent.showHistory()
+                            }
+
+                            //slider and range changes are coalesced, the history is read once per pause
+                            Timer   {
+                                id: charts_history_timer
+                                interval: 50
+                                onTriggered: charts_history_row.showHistory()
+                            }
+
+                            Slider {
+                                id: charts_history_slider
+                                enabled: !charts_live_switch.checked
+                                Layout.fillWidth: true
+                                from: 0; to: 1;
+                                value: 1
+                                onValueChanged: charts_history_timer.restart()
+                            }
+
+                            SpinBox {
+                                id: charts_history_range
+                                enabled: !charts_live_switch.checked
+                                editable: true
+                                from: 10; to: 36000
+                                stepSize: 10
+                                value: 60
+                                onValueChanged: charts_history_timer.restart()
+                            }
+
+                            Label   {
+                                id: charts_history_approximate
+                                visible: false
+                                font.pointSize: 10
+                                color: "#4fc622"
+                                text: qsTr("Filtered: approx.")
+                            }
+                        }
                     }
 
                     ScrollView   {
@@ -301,91 +459,54 @@ Item {
                         width: parent.width
                         height: parent.height - charts_control_panel.height - charts_label.height - 10
                         contentWidth: charts_speed.width
-                        contentHeight: charts_container.height * 1.5
+                        contentHeight: charts_container.height * 2
                         clip: true
                         ScrollBar.vertical.policy: ScrollBar.AlwaysOn
 
                         ColumnLayout    {
                             width: charts_container.width
-                            height: charts_container.height * 1.5
+                            height: charts_container.height * 2
 
 
-                            ChartView   {
+                            LineChart   {
                                 id: charts_speed
                                 Layout.fillWidth: true
                                 Layout.fillHeight: true
-                                antialiasing: true
-                                backgroundRoundness: 10
-                                theme: ChartView.ChartThemeQt
-                                LineSeries {
-                                    id: charts_speed_series
-                                    name: "Vehicle speed"
-                                    useOpenGL: true
-                                    color: charts_filter_comboBox.currentIndex !== 0 ? "#4c4fc622" : "#4fc622"
-                                    axisX: ValueAxis    {
-                                        max: 60
-                                        min: 0
-                                    }
-                                    axisY: ValueAxis    {
-                                        min: -10
-                                        max: 10
-                                    }
-                                }
-                                LineSeries  {
-                                    id: charts_speed_series_filtered
-                                    name: "Vehicle speed (filter)"
-                                    useOpenGL: true
-                                    visible: charts_filter_comboBox.currentIndex !== 0
-                                }
+                                title: qsTr("Vehicle speed")
+                                lineColor: charts_filter_comboBox.currentIndex !== 0 ? "#4c4fc622" : "#4fc622"
+                                filterVisible: charts_filter_comboBox.currentIndex !== 0
                             }
-                            ChartView   {
+                            LineChart   {
                                 id: charts_steering
                                 Layout.fillWidth: true
                                 Layout.fillHeight: true
-                                antialiasing: true
-                                backgroundRoundness: 10
-                                theme: ChartView.ChartThemeQt
-                                LineSeries {
-                                    id: charts_steering_series
-                                    name: "Steering wheel rotating angle"
-                                    useOpenGL: true
-                                    axisX: ValueAxis    {
-                                        max: 60
-                                        min: 0
-                                    }
-                                    axisY: ValueAxis    {
-                                        min: -10
-                                        max: 10
-                                    }
-                                }
+                                title: qsTr("Steering wheel rotating angle")
                             }
-                            ChartView   {
+                            LineChart   {
                                 id: charts_temp
                                 Layout.fillWidth: true
                                 Layout.fillHeight: true
-                                antialiasing: true
-                                backgroundRoundness: 10
-                                theme: ChartView.ChartThemeQt
-                                LineSeries {
-                                    id: charts_temp_series
-                                    name: "Temperature °C"
-                                    useOpenGL: true
-                                    color: charts_filter_comboBox.currentIndex !== 0 ? "#4c4fc622" : "#4fc622"
-                                    axisX: ValueAxis    {
-                                        max: 60
-                                        min: 0
-                                    }
-                                    axisY: ValueAxis    {
-                                        min: 0
-                                        max: 100
+                                title: qsTr("Temperature °C")
+                                yFrom: 0; yTo: 100
+                                lineColor: charts_filter_comboBox.currentIndex !== 0 ? "#4c4fc622" : "#4fc622"
+                                filterVisible: charts_filter_comboBox.currentIndex !== 0
+                            }
+                            LineChart   {
+                                id: charts_derived
+                                Layout.fillWidth: true
+                                Layout.fillHeight: true
+                                title: qsTr("Derived: ") + charts_derived_comboBox.currentText
+
+                                ComboBox    {
+                                    id: charts_derived_comboBox
+                                    anchors.top: parent.top
+                                    anchors.right: parent.right
+                                    anchors.margins: 5
+                                    height: 25
+                                    onActivated: {
+                                        adapter.slotUISelectDerived(currentIndex);
                                     }
                                 }
-                                LineSeries  {
-                                    id: charts_temp_series_filter
-                                    name: "Filtered temperature °C"
-                                    useOpenGL: true
-                                    visible: charts_filter_comboBox.currentIndex !== 0
-                                }
                             }
                         }
                     }
@@ -0,0 +1,77 @@
+import QtQuick 2.9
+import QtQuick.Controls 2.4
+import SmartVehicle 1.0
+
+Rectangle {
+    property alias title: chart_title.text
+    property alias series: chart_line
+    property alias filterSeries: chart_line_filter
+    property alias lineColor: chart_line.color
+    property alias filterVisible: chart_line_filter.visible
+    property real yFrom: -10
+    property real yTo: 10
+
+    radius: 10
+    color: "white"
+
+    Label   {
+        id: chart_title
+        anchors.top: parent.top
+        anchors.horizontalCenter: parent.horizontalCenter
+        anchors.topMargin: 5
+        font.pointSize: 11
+        font.bold: true
+    }
+
+    Rectangle   {
+        id: chart_plot_area
+        anchors.fill: parent
+        anchors.leftMargin: 40
+        anchors.rightMargin: 15
+        anchors.topMargin: 30
+        anchors.bottomMargin: 25
+        color: "transparent"
+        border.width: 1
+        border.color: "lightgray"
+
+        SVChart {
+            id: chart_line
+            anchors.fill: parent
+            xMin: 0; xMax: 60
+            yMin: yFrom; yMax: yTo
+            color: "#4fc622"
+        }
+        SVChart {
+            id: chart_line_filter
+            anchors.fill: parent
+            rangeSource: chart_line
+            color: "#209fdf"
+            visible: false
+        }
+    }
+
+    Label   {
+        anchors.right: chart_plot_area.left
+        anchors.top: chart_plot_area.top
+        anchors.rightMargin: 5
+        text: chart_line.yMax.toFixed(0)
+    }
+    Label   {
+        anchors.right: chart_plot_area.left
+        anchors.bottom: chart_plot_area.bottom
+        anchors.rightMargin: 5
+        text: chart_line.yMin.toFixed(0)
+    }
+    Label   {
+        anchors.left: chart_plot_area.left
+        anchors.top: chart_plot_area.bottom
+        anchors.topMargin: 3
+        text: chart_line.xMin.toFixed(0)
+    }
+    Label   {
+        anchors.right: chart_plot_area.right
+        anchors.top: chart_plot_area.bottom
+        anchors.topMargin: 3
+        text: chart_line.xMax.toFixed(0)
+    }
+}
@@ -1,4 +1,4 @@
-QT += quick network core gui qml charts
+QT += quick network core gui qml charts concurrent
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 CONFIG += c++11
 
@@ -19,8 +19,24 @@ SOURCES += \
         svclient.cpp \
         adapter.cpp \
     ../common/svserver.cpp \
+    ../common/svtrace.cpp \
+    ../common/svmetrics.cpp \
+    ../common/telemetrycodec.cpp \
+    ../common/telemetrybatch.cpp \
     svseries.cpp \
-    filter.cpp
+    filter.cpp \
+    refilter.cpp \
+    sessionmanager.cpp \
+    lodpyramid.cpp \
+    svlinenode.cpp \
+    svchartitem.cpp \
+    telemetrystore.cpp \
+    derivedchannels.cpp \
+    channelstats.cpp \
+    telemetryexporter.cpp \
+    channelmodel.cpp \
+    svmapitem.cpp \
+    trajectorytrail.cpp
 
 RESOURCES += qml.qrc
 
@@ -42,7 +58,24 @@ HEADERS += \
         svclient.h \
         adapter.h \
     ../common/svserver.h \
+    ../common/svtrace.h \
+    ../common/svmetrics.h \
+    ../common/telemetrycodec.h \
+    ../common/telemetrybatch.h \
     svseries.h \
-    filter.h
+    filter.h \
+    refilter.h \
+    sessionmanager.h \
+    ringbuffer.h \
+    lodpyramid.h \
+    svlinenode.h \
+    svchartitem.h \
+    telemetrystore.h \
+    derivedchannels.h \
+    channelstats.h \
+    telemetryexporter.h \
+    channelmodel.h \
+    svmapitem.h \
+    trajectorytrail.h
 
 DISTFILES +=
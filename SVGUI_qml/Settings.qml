@@ -95,6 +95,103 @@ Item {
                             editable: true
                         }
                     }
+                    Row {
+                        Layout.margins: 20
+                        spacing: 20
+                        Label   {
+                            text: qsTr("UI update rate")
+                            font.bold: true
+                            font.pointSize: 12
+                        }
+                        SpinBox {
+                            id: settings_ui_update_rate
+                            value: 60
+                            from: 5; to: 60
+                            stepSize: 5
+                            editable: true
+                            onValueChanged: {
+                                sessions.slotUISetUpdateRate(value);
+                            }
+                        }
+                    }
+                    Row {
+                        Layout.margins: 20
+                        spacing: 20
+                        Label   {
+                            text: qsTr("Telemetry rates (0 - vehicle's)")
+                            font.bold: true
+                            font.pointSize: 12
+                        }
+                        SpinBox {
+                            id: settings_ui_high_freq_rate
+                            value: 0
+                            from: 0; to: 5000
+                            stepSize: 50
+                            editable: true
+                            onValueChanged: {
+                                sessions.slotUISetTelemetryRates(value, settings_ui_low_freq_rate.value);
+                            }
+                        }
+                        SpinBox {
+                            id: settings_ui_low_freq_rate
+                            value: 0
+                            from: 0; to: 100
+                            stepSize: 1
+                            editable: true
+                            onValueChanged: {
+                                sessions.slotUISetTelemetryRates(settings_ui_high_freq_rate.value, value);
+                            }
+                        }
+                    }
+                    Row {
+                        Layout.margins: 20
+                        spacing: 20
+                        Label   {
+                            text: qsTr("Tracing")
+                            font.bold: true
+                            font.pointSize: 12
+                        }
+                        Switch  {
+                            id: settings_tracing
+                            onCheckedChanged: {
+                                if (checked)    {
+                                    sessions.slotUITraceStart();
+                                    settings_trace_file.text = qsTr("Recording...");
+                                }   else    {
+                                    var file = sessions.slotUITraceStop();
+                                    settings_trace_file.text = file.length > 0 ? file : qsTr("Trace is not written");
+                                }
+                            }
+                        }
+                        Label   {
+                            id: settings_trace_file
+                            anchors.verticalCenter: parent.verticalCenter
+                        }
+                    }
+                    Label   {
+                        Layout.leftMargin: 20
+                        text: qsTr("Metrics")
+                        font.bold: true
+                        font.pointSize: 12
+                    }
+                    ScrollView  {
+                        Layout.leftMargin: 20
+                        Layout.preferredWidth: settings_ui_container.width - 40
+                        Layout.preferredHeight: 200
+                        clip: true
+                        Text    {
+                            id: settings_metrics
+                            font.family: "monospace"
+                            font.pointSize: 8
+                        }
+                    }
+                    Timer   {
+                        interval: 1000
+                        repeat: true
+                        triggeredOnStart: true
+                        running: settings_container.visible
+                        onTriggered: settings_metrics.text = sessions.slotUIMetrics()
+                    }
                 }
             }
 
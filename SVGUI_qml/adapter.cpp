@@ -1,10 +1,76 @@
 #include "adapter.h"
+#include "svtrace.h"
+#include <QStandardPaths>
+#include <QDateTime>
+#include <QDir>
+
+Adapter::Adapter(QObject *parent) : QObject(parent), channels(this) {
+    //the values list in UI follows this order
+    encoderChannel = addChannel("encoder", tr("Odometry"), "m");
+    steeringChannel = addChannel("steering", tr("Steering wheel"), "°");
+    speedChannel = addChannel("speed", tr("Speed"), "mps", true);
+    tempChannel = addChannel("temperature", tr("Temperature"), "°С", true);
+    motorBatteryChannel = addChannel("motor_battery", tr("Motor battery"), "%");
+    compBatteryChannel = addChannel("comp_battery", tr("Computer battery"), "%");
+    xChannel = addChannel("x", tr("X"), "m");
+    yChannel = addChannel("y", tr("Y"), "m");
+    angleChannel = addChannel("angle", tr("Angle"), "°");
+
+    channels.filterSeries(speedChannel)->setFilter(Filter::GAF);
+    channels.filterSeries(tempChannel)->setFilter(Filter::GAF);
+    channels.filterSeries(tempChannel)->setAutoScale(false);
+    channels.series(tempChannel)->setAutoScale(false);
+
+    //derived channels, a new one needs only a line here
+    struct Declaration  {
+        char const* name;
+        char const* source;
+        DerivedChannels::Operation operation;
+        char const* title;
+        char const* unit;
+    };
+    Declaration const declarations[] = {
+        { "speed", "encoder", DerivedChannels::DERIVATIVE, "Speed", "mps" },
+        { "acceleration", "speed", DerivedChannels::DERIVATIVE, "Acceleration", "m/s²" },
+        { "jerk", "acceleration", DerivedChannels::DERIVATIVE, "Jerk", "m/s³" },
+        { "distance", "speed", DerivedChannels::ABS_INTEGRAL, "Travelled distance", "m" },
+        { "yaw_rate", "angle", DerivedChannels::ANGLE_DERIVATIVE, "Yaw rate", "°/s" }
+    };
+    encoderSource = derived.addSource("encoder");
+    angleSource = derived.addSource("angle");
+    for (Declaration const& declaration : declarations) {
+        int input = derived.declare(declaration.name, declaration.source, declaration.operation);
+        if (input < 0)
+            continue;
+        int channel = channels.indexOf(declaration.name);
+        if (channel < 0)    {
+            channel = addChannel(declaration.name, tr(declaration.title), declaration.unit);
+            derivedCharts.append(channel);
+        }
+        derivedInputs.append(input);
+        derivedOutputs.append(channel);
+    }
+
+    statsTimer.start();
+    updateTimer.start();
+}
+
+Adapter::~Adapter() {
+    qDeleteAll(stats);
+}
 
-Adapter::Adapter(QObject *parent) : QObject(parent) {
-    speedSeriesFilter.setFilter(Filter::GAF);
-    tempSeriesFilter.setFilter(Filter::GAF);
-    tempSeriesFilter.setAutoScale(false);
-    tempSeries.setAutoScale(false);
+//registers the channel in the model, the store and the statistics
+int Adapter::addChannel(QString const& name, QString const& title, QString const& unit, bool filtered) {
+    int channel = channels.addChannel(name, title, unit, filtered);
+    int storeChannel = store.channel(name);
+    Q_ASSERT(storeChannel == channel);
+    Q_UNUSED(storeChannel);
+    stats.append(new ChannelStats());
+    return channel;
+}
+
+QObject* Adapter::getChannels() {
+    return &channels;
 }
 
 //converts state code into state string
@@ -35,14 +101,15 @@ QString Adapter::getStatusStr(const qint8 &state)  {
 }
 
 void Adapter::clearCharts() {
-    speedSeries.clear();
-    speedSeriesFilter.clear();
-    steeringSeries.clear();
-    tempSeries.clear();
-    tempSeriesFilter.clear();
-
-    chartStartTime = 0;
-    encoderLast = QPointF();
+    for (SVSeries *series : channels.serieses())
+        series->clear();
+    derived.reset();
+    store.clear();
+    for (ChannelStats *channelStats : stats)
+        channelStats->clear();
+
+    chartStartTime = -1;
+    trail.clear();
 }
 
 
@@ -51,34 +118,84 @@ void Adapter::log(const QString &message)   {
     emit signalUILog(message);
 }
 
-//gets a QLineSeries* from QML context
+//releases QML serieses, data is still collected while the vehicle is not shown
+void Adapter::detachSerieses()  {
+    for (SVSeries *series : channels.serieses())
+        series->setSeriesObj(nullptr);
+    if (mapItem)
+        mapItem->setTrail(nullptr);
+    mapItem = nullptr;
+}
+
+//gets the map view (SVMap item) from QML context
+void Adapter::slotUISetMap(QObject *mapItem)    {
+    this->mapItem = qobject_cast<SVMapItem*>(mapItem);
+    if (this->mapItem == nullptr)   {
+        qDebug() << "Map view init error.";
+        return;
+    }
+    qDebug() << "Map view has been initialized.";
+    this->mapItem->setTrail(&trail);
+    if (lastMap.getWidth() && lastMap.getHeight())
+        slotMap(lastMap);
+    else
+        this->mapItem->clear();
+}
+
+//gets chart serieses (SVChart items or QLineSeries) from QML context
 void Adapter::slotUISetSerieses(QObject *speedSeries, QObject* speedSeriesFilter, QObject *steeringSeries,
-                                QObject *tempSeries, QObject* tempSeriesFilter)   {
+                                QObject *tempSeries, QObject* tempSeriesFilter, QObject *derivedSeries)   {
     if (speedSeries)  {
-        this->speedSeries.setSeriesObj(qobject_cast<QtCharts::QLineSeries*>(speedSeries));
+        channels.series(speedChannel)->setSeriesObj(speedSeries);
         qDebug() << "Speed series has been initialized.";
     }   else
         qDebug() << "Speed series init error.";
     if (speedSeriesFilter)  {
-        this->speedSeriesFilter.setSeriesObj(qobject_cast<QtCharts::QLineSeries*>(speedSeriesFilter));
+        channels.filterSeries(speedChannel)->setSeriesObj(speedSeriesFilter);
         qDebug() << "Speed series (filter) has been initialized.";
     }   else
         qDebug() << "Speed series (filter) init error.";
     if (steeringSeries) {
-        this->steeringSeries.setSeriesObj(qobject_cast<QtCharts::QLineSeries*>(steeringSeries));
+        channels.series(steeringChannel)->setSeriesObj(steeringSeries);
         qDebug() << "Steering serieses has been initialized.";
     }   else
         qDebug() << "Steering series init error.";
     if (tempSeries) {
-        this->tempSeries.setSeriesObj(qobject_cast<QtCharts::QLineSeries*>(tempSeries));
+        channels.series(tempChannel)->setSeriesObj(tempSeries);
         qDebug() << "Temperature serieses has been initialized.";
     }   else
         qDebug() << "Temperature series init error.";
     if (tempSeriesFilter) {
-        this->tempSeriesFilter.setSeriesObj(qobject_cast<QtCharts::QLineSeries*>(tempSeriesFilter));
+        channels.filterSeries(tempChannel)->setSeriesObj(tempSeriesFilter);
         qDebug() << "Temperature filtered serieses has been initialized.";
     }   else
         qDebug() << "Temperature filtered series init error.";
+    //the map shows the vehicle of this session from the next update
+    positionChanged = chartStartTime >= 0;
+    derivedSeriesObj = derivedSeries;
+    if (derivedSeries && derivedShown < derivedCharts.size())  {
+        channels.series(derivedCharts.at(derivedShown))->setSeriesObj(derivedSeries);
+        qDebug() << "Derived series has been initialized.";
+    }   else
+        qDebug() << "Derived series init error.";
+    emitDerived();
+}
+
+//shows another derived channel on the derived chart
+void Adapter::slotUISelectDerived(int index)    {
+    if (index < 0 || index >= derivedCharts.size() || index == derivedShown)
+        return;
+    channels.series(derivedCharts.at(derivedShown))->setSeriesObj(nullptr);
+    derivedShown = index;
+    if (derivedSeriesObj)
+        channels.series(derivedCharts.at(derivedShown))->setSeriesObj(derivedSeriesObj);
+}
+
+void Adapter::emitDerived() {
+    QStringList titles;
+    for (int channel : derivedCharts)
+        titles.append(channels.title(channel));
+    emit signalUIDerived(titles, derivedShown);
 }
 
 //search for devices in current network
@@ -140,34 +257,120 @@ void Adapter::slotUIControl(float const& xAxis, float const& yAxis) {
     emit signalControl(data);
 }
 
+//sends a one-time command to go to the map cell, the vehicle plans the path itself
+void Adapter::slotUIGoal(int x, int y)  {
+    if (!connected)
+        return;
+    emit signalGoal(GoalPackage(x, y));
+    log("Goal sent: " + QString::number(x) + ", " + QString::number(y));
+}
+
 //sets filter type and create new Filter instead of last choosen filter for every series
+//filter types are listed in the UI in the order of Filter::FilterType
+//already stored points are re-filtered in background, see SVSeries::setFilter()
 void Adapter::slotUISetFilter(int filterType)   {
-    Filter::FilterType _filterType;
-    switch (filterType) {
-    case 0: {
-        _filterType = Filter::NONE;
-        break;
-    }
-    case 1: {
-        _filterType = Filter::KALMAN;
-        break;
-    }
-    case 2: {
-        _filterType = Filter::GAF;
-        break;
-    }
-    default:    {
-        _filterType = Filter::NONE;
+    Filter::FilterType _filterType = Filter::NONE;
+    if (filterType >= Filter::NONE && filterType <= Filter::CHAIN)
+        _filterType = static_cast<Filter::FilterType>(filterType);
+    for (int i = 0; i < channels.count(); i++)
+        if (SVSeries *series = channels.filterSeries(i))
+            series->setFilter(_filterType);
+}
+
+//sets K koef (Kalman gain or low-pass cutoff)
+void Adapter::slotUISetFilterK(float k) {
+    for (int i = 0; i < channels.count(); i++)
+        if (SVSeries *series = channels.filterSeries(i))
+            series->setFilterK(k);
+}
+
+//re-emits the session state for the UI, called after switching to this vehicle
+void Adapter::slotUIRefresh()   {
+    if (connected)  {
+        emit signalUIConnected();
+        emit signalUIStatus(status);
+    }   else    {
+        emit signalUIDisconnected();
     }
+    if (lastMap.getWidth() && lastMap.getHeight())
+        slotMap(lastMap);
+    else
+        emit signalUIMap(0, 0);
+    emit signalUIExporting(exporter.isExporting());
+    emitDerived();
+}
+
+//shows the stored history on the charts instead of the live window
+//position: 0..1 of the session, window end; range: window length, sec
+void Adapter::slotUIHistory(float position, float range)    {
+    double first, last;
+    if (!store.timeRange(steeringChannel, first, last))
+        return;
+    double end = first + (last - first) * static_cast<double>(qBound(0.0f, position, 1.0f));
+    double start = qMax(first, end - static_cast<double>(range));
+    end = qMax(end, start + static_cast<double>(range));
+
+    //only charted serieses are read, the others just leave the live mode
+    bool approximate = false;
+    for (int i = 0; i < channels.count(); i++)  {
+        SVSeries *series = channels.series(i);
+        SVSeries *filterSeries = channels.filterSeries(i);
+        bool filterShown = filterSeries && filterSeries->isAttached();
+        QVector<QPointF> history;
+        bool reduced = false;
+        if (series->isAttached() || filterShown)   {
+            int columns = series->isAttached() ? series->plotColumns() : filterSeries->plotColumns();
+            history = store.read(i, start, end, columns, &reduced);
+        }
+        series->showHistory(history, static_cast<float>(start), static_cast<float>(end));
+        if (filterSeries)
+            filterSeries->showHistory(history, static_cast<float>(start), static_cast<float>(end));
+        if (filterShown && reduced && filterSeries->filterType() != Filter::NONE)
+            approximate = true;
     }
-    speedSeriesFilter.setFilter(_filterType);
-    tempSeriesFilter.setFilter(_filterType);
+    emit signalUIHistoryApproximate(approximate);
 }
 
-//sets K koef (only for Kalman)
-void Adapter::slotUISetFilterK(float k) {
-    speedSeriesFilter.setFilterK(k);
-    tempSeriesFilter.setFilterK(k);
+//back to the live charts
+void Adapter::slotUILive()  {
+    for (SVSeries *series : channels.serieses())
+        series->showLive();
+    emit signalUIHistoryApproximate(false);
+}
+
+//sets how often the values list and the vehicle position are updated
+void Adapter::setUpdateInterval(int msec)   {
+    updateInterval = qMax(msec, 0);
+    nextUpdate = updateTimer.elapsed();
+}
+
+//flushes points staged since the previous frame into the charts,
+//the latest values and position are published at the UI update rate
+void Adapter::slotFrame()   {
+    SV_TRACE("Adapter::slotFrame");
+    for (SVSeries *series : channels.serieses())
+        series->flush();
+
+    qint64 now = updateTimer.elapsed();
+    if (now >= nextUpdate)  {
+        //a 30 Hz schedule on 16 msec frames is updated every 2 or 3 frames,
+        //after a stall the schedule starts again instead of catching up
+        nextUpdate += updateInterval;
+        if (nextUpdate <= now)
+            nextUpdate = now + updateInterval;
+        channels.flushChanges();
+        if (positionChanged)    {
+            positionChanged = false;
+            emit signalUIUpdatePosition(position.x, position.y, position.angle);
+            if (mapItem)
+                mapItem->updateTrail();
+        }
+    }
+
+    if (statsTimer.elapsed() >= statsInterval)  {
+        statsTimer.restart();
+        emitStats();
+    }
 }
 
 //gets a list of available network addresses
@@ -177,8 +380,10 @@ void Adapter::slotAddresses(QList<QString> const& addresses)    {
 
 void Adapter::slotConnected(qint8 const& state)   {
     qDebug() << "Adapter: Connected";
+    connected = true;
+    status = getStatusStr(state);
     emit signalUIConnected();
-    emit signalUIStatus(getStatusStr(state));
+    emit signalUIStatus(status);
 
     clearCharts();
 
@@ -187,6 +392,7 @@ void Adapter::slotConnected(qint8 const& state)   {
 
 void Adapter::slotDisconnected()    {
     qDebug() << "Adapter: Disconnected";
+    connected = false;
     emit signalUIDisconnected();
     log("Disconnected.");
 }
@@ -197,52 +403,208 @@ void Adapter::slotConnectionError(QString message) {
     log("Connection error: " + message);
 }
 
-//calculate speed by delta time and delta value
-float Adapter::getSpeed(float currentTime, float currentEncoder) {
-    if (encoderLast.isNull())   {
-        encoderLast = QPointF(currentTime, currentEncoder);
-        return 0;
+//seconds from the first package of the session, in double: float has only ~2 msec resolution after 4.5 hours
+double Adapter::sessionTime(quint32 timeStamp) {
+    if (chartStartTime < 0)
+        chartStartTime = timeStamp;
+    return (static_cast<qint64>(timeStamp) - chartStartTime) / 1000.0;
+}
+
+//updates the derived channels by the source value and records the new derived values
+void Adapter::updateDerived(int source, double time, float value)  {
+    derived.update(source, time, static_cast<double>(value));
+    for (int i = 0; i < derivedInputs.size(); i++)  {
+        if (derived.isUpdated(derivedInputs.at(i)))
+            record(derivedOutputs.at(i), time, static_cast<float>(derived.value(derivedInputs.at(i))));
     }
-    float speed = (currentEncoder - encoderLast.y()) / (currentTime - encoderLast.x());
-    encoderLast = QPointF(currentTime, currentEncoder);
-    return speed;
 }
 
-//gets new HighFreqDataPackage and extract all data from it to show in UI
-void Adapter::slotData(HighFreqDataPackage const& data) {
-    qDebug() << "Adapter: incoming high freq data package";
+//the channel value goes to the serieses, the values list, the store and the statistics
+void Adapter::record(int channel, double time, float value)  {
+    QPointF point(time, static_cast<double>(value));
+    channels.series(channel)->addPoint(point);
+    if (SVSeries *filterSeries = channels.filterSeries(channel))
+        filterSeries->addPoint(point);
+    channels.setValue(channel, static_cast<double>(value));
+    store.append(channel, time, value);
+    stats.at(channel)->add(time, static_cast<double>(value));
+}
+
+void Adapter::recordColumn(int channel, QVector<double> const& times, QVector<float> const& values)    {
+    for (int i = 0; i < times.size(); i++)
+        record(channel, times.at(i), values.at(i));
+}
+
+//a run of high freq samples is recorded channel by channel, the channels don't depend on each other
+void Adapter::recordBatch(TelemetryColumns const& batch)    {
+    int count = batch.size();
+    if (!count)
+        return;
+    QVector<double> times(count);
+    for (int i = 0; i < count; i++) {
+        times[i] = sessionTime(batch.timeStamps.at(i));
+        trail.append(QPointF(static_cast<qreal>(batch.x.at(i)), static_cast<qreal>(batch.y.at(i))));
+    }
 
-    if (!chartStartTime)
-        chartStartTime = data.timeStamp;
-    float deltaTime = (data.timeStamp - chartStartTime) / 1000.0f;
+    position.x = batch.x.last();
+    position.y = batch.y.last();
+    position.angle = batch.angle.last();
+    positionChanged = true;
+
+    for (int i = 0; i < count; i++)
+        updateDerived(encoderSource, times.at(i), batch.encoder.at(i));
+    for (int i = 0; i < count; i++)
+        updateDerived(angleSource, times.at(i), batch.angle.at(i));
+    recordColumn(encoderChannel, times, batch.encoder);
+    recordColumn(steeringChannel, times, batch.steering);
+    recordColumn(xChannel, times, batch.x);
+    recordColumn(yChannel, times, batch.y);
+    recordColumn(angleChannel, times, batch.angle);
+}
+
+void Adapter::recordLowFreq(LowFreqDataPackage const& data) {
+    qint8 state = data.stateType;
+    status = getStatusStr(state);
 
-    float speed = getSpeed(deltaTime, data.m_encoderValue);
+    emit signalUIStatus(status);
 
-    emit signalUIUpdateHighFreqData(data.m_encoderValue, data.m_steeringAngle, speed);
-    emit signalUIUpdatePosition(data.x, data.y, data.angle);
+    double deltaTime = sessionTime(data.timeStamp);
 
-    speedSeries.addPoint(QPointF(deltaTime, speed));
-    speedSeriesFilter.addPoint(QPointF(deltaTime, speed));
-    steeringSeries.addPoint(QPointF(deltaTime, data.m_steeringAngle));
+    record(tempChannel, deltaTime, data.m_temp);
+    record(motorBatteryChannel, deltaTime, static_cast<float>(data.m_motorBatteryPerc));
+    record(compBatteryChannel, deltaTime, static_cast<float>(data.m_compBatteryPerc));
 }
 
-//gets new LowFreqDataPackage and extract all data from it to show in UI
-void Adapter::slotData(LowFreqDataPackage const& data) {
-    qDebug() << "Adapter: incoming low freq data package";
+static QVariantMap statsMap(StreamStats const& stats)  {
+    QVariantMap map;
+    map["count"] = stats.count;
+    map["rejected"] = stats.rejected;
+    map["min"] = stats.count ? stats.min : 0;
+    map["max"] = stats.count ? stats.max : 0;
+    map["mean"] = stats.mean;
+    map["std"] = qSqrt(stats.variance());
+    map["p50"] = stats.sketch.quantile(0.5);
+    map["p95"] = stats.sketch.quantile(0.95);
+    map["p99"] = stats.sketch.quantile(0.99);
+    return map;
+}
 
-    qint8 state = data.stateType;
-    QString stateString = getStatusStr(state);
+//sends session and window statistics of every channel to UI
+void Adapter::emitStats()   {
+    QVariantList rows;
+    for (int i = 0; i < stats.size(); i++)  {
+        QVariantMap row;
+        row["name"] = store.channelName(i);
+        row["session"] = statsMap(stats.at(i)->sessionStats());
+        row["window"] = statsMap(stats.at(i)->windowStats());
+        rows.append(row);
+    }
+    emit signalUIStats(rows);
+}
+
+//sets the sliding window of the statistics, window statistics are started again
+void Adapter::slotUISetStatsWindow(int seconds) {
+    for (ChannelStats *channelStats : stats)
+        channelStats->setWindow(seconds);
+}
+
+//starts writing of the received packages into the documents directory
+//formats: TelemetryExporter::Format flags
+void Adapter::slotUIExportStart(int formats)    {
+    QString directory = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
+    QString basePath = QDir(directory).filePath("smart_vehicle_" +
+                                                QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"));
+    if (exporter.startExport(basePath, formats))    {
+        log("Export to " + basePath + " started.");
+        emit signalUIExporting(true);
+    }   else    {
+        log("Export error: can't open " + basePath);
+        emit signalUIExporting(false);
+    }
+}
 
-    emit signalUIStatus(stateString);
-    emit signalUIUpdateLowFreqData(data.m_motorBatteryPerc, data.m_compBatteryPerc, data.m_temp);
+void Adapter::slotUIExportStop()    {
+    if (!exporter.isExporting())
+        return;
+    exporter.stopExport();
+    log("Export finished: " + QString::number(exporter.writtenCount()) + " packages written, " +
+        QString::number(exporter.droppedCount()) + " dropped.");
+    emit signalUIExporting(false);
+}
+
+void Adapter::slotUIReplay(QString path)    {
+    if (connected)  {
+        log("Replay error: disconnect from the vehicle first.");
+        return;
+    }
+    if (path.isEmpty()) {
+        QDir directory(QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation));
+        QStringList files = directory.entryList(QStringList("smart_vehicle_*.svtx"), QDir::Files, QDir::Name);
+        if (files.isEmpty())    {
+            log("Replay error: no recordings in " + directory.path());
+            return;
+        }
+        path = directory.filePath(files.last());
+    }
+
+    TelemetryColumns highFreq;
+    QVector<LowFreqDataPackage> lowFreq;
+    if (!TelemetryExporter::readBinary(path, highFreq, lowFreq))    {
+        log("Replay error: can't read " + path);
+        return;
+    }
 
-    if (!chartStartTime)
-        chartStartTime = data.timeStamp;
-    float deltaTime = (data.timeStamp - chartStartTime) / 1000.0f;
+    clearCharts();
+    //the types are stored in separate blocks, the session starts with the earliest package of both
+    if (highFreq.size())
+        chartStartTime = highFreq.timeStamps.first();
+    if (!lowFreq.isEmpty() && (chartStartTime < 0 || lowFreq.first().timeStamp < chartStartTime))
+        chartStartTime = lowFreq.first().timeStamp;
+    recordBatch(highFreq);
+    for (LowFreqDataPackage const& data : lowFreq)
+        recordLowFreq(data);
+    log("Replayed " + path + ": " + QString::number(highFreq.size()) + " high freq and " +
+        QString::number(lowFreq.size()) + " low freq packages.");
+}
 
-    QPointF point(deltaTime, data.m_temp);
-    tempSeries.addPoint(point);
-    tempSeriesFilter.addPoint(point);
+//gets new HighFreqDataPackage and extract all data from it to show in UI
+void Adapter::slotData(HighFreqDataPackage const& data) {
+    SV_TRACE("Adapter::slotData(HighFreq)");
+    qCDebug(svPackages) << "Adapter: incoming high freq data package";
+    exporter.push(data);
+
+    double deltaTime = sessionTime(data.timeStamp);
+
+    position.x = data.x;
+    position.y = data.y;
+    position.angle = data.angle;
+    positionChanged = true;
+    trail.append(QPointF(static_cast<qreal>(data.x), static_cast<qreal>(data.y)));
+
+    updateDerived(encoderSource, deltaTime, data.m_encoderValue);
+    updateDerived(angleSource, deltaTime, data.angle);
+    record(encoderChannel, deltaTime, data.m_encoderValue);
+    record(steeringChannel, deltaTime, data.m_steeringAngle);
+    record(xChannel, deltaTime, data.x);
+    record(yChannel, deltaTime, data.y);
+    record(angleChannel, deltaTime, data.angle);
+}
+
+//gets a run of HighFreqDataPackage samples, decoded at once after a stall of the GUI
+void Adapter::slotDataBatch(TelemetryColumns const& batch)  {
+    SV_TRACE("Adapter::slotDataBatch");
+    qCDebug(svPackages) << "Adapter: incoming batch of" << batch.size() << "high freq samples";
+    for (int i = 0; i < batch.size(); i++)
+        exporter.push(batch.at(i));
+    recordBatch(batch);
+}
+
+//gets new LowFreqDataPackage and extract all data from it to show in UI
+void Adapter::slotData(LowFreqDataPackage const& data) {
+    SV_TRACE("Adapter::slotData(LowFreq)");
+    qCDebug(svPackages) << "Adapter: incoming low freq data package";
+    exporter.push(data);
+    recordLowFreq(data);
 }
 
 //gets result of settings applying
@@ -256,6 +618,14 @@ void Adapter::slotDone(qint8 const& answerCode) {
         log("Setting complete.");
         break;
     }
+    case AnswerPackage::GOAL_PLANNED:   {
+        log("Path to the goal is planned.");
+        break;
+    }
+    case AnswerPackage::GOAL_UNREACHABLE:   {
+        log("Error. The goal is unreachable.");
+        break;
+    }
     }
 }
 
@@ -269,12 +639,19 @@ void Adapter::slotSettings(SetPackage const& set)   {
 
 //gets MapPackage to create a cell map in UI
 void Adapter::slotMap(MapPackage const& map)    {
-    QList<int> cellsList;
-    for (auto const& line : map.cells())
-        for (auto const& cell : line)
-            cellsList.push_back(cell);
-
-    emit signalUIMap(map.getWidth(), map.getHeight(), cellsList);
+    lastMap = map;
+
+    //cells go to the map view as one buffer, QML gets the size only
+    if (mapItem)    {
+        int width = map.getWidth();
+        int height = map.getHeight();
+        QByteArray cells(width * height, static_cast<char>(MapPackage::EMPTY));
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < width; x++)
+                cells[y * width + x] = static_cast<char>(map.at(y, x));
+        mapItem->setMap(width, height, cells);
+    }
+    emit signalUIMap(map.getWidth(), map.getHeight());
 }
 
 void Adapter::slotBrokenPackage()   {
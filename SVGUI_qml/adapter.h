@@ -5,30 +5,96 @@
 #include <QDebug>
 #include <QList>
 #include <QPointF>
+#include <QVariantList>
+#include <QElapsedTimer>
+#include <QtMath>
 #include "datapackage.h"
 #include "svseries.h"
+#include "svmapitem.h"
+#include "channelmodel.h"
+#include "telemetrystore.h"
+#include "derivedchannels.h"
+#include "channelstats.h"
+#include "telemetryexporter.h"
 
 class Adapter : public QObject
 {
     Q_OBJECT
+    Q_PROPERTY(QObject* channels READ getChannels CONSTANT)
 private:
     QString getStatusStr(qint8 const& status);
 
-    //serieses
-    int chartStartTime = 0;
-    QPointF encoderLast;
-    SVSeries speedSeries;
-    SVSeries speedSeriesFilter;
-    SVSeries steeringSeries;
-    SVSeries tempSeries;
-    SVSeries tempSeriesFilter;
+    //session state to restore the UI after switching between vehicles
+    bool connected = false;
+    QString status;
+    MapPackage lastMap;
+    SVMapItem *mapItem = nullptr;
 
+    qint64 chartStartTime = -1;  //msec, timestamp of the first package, -1 before it
+
+    //latest values are published once per UI update, not for every package
+    int updateInterval = 0; //msec, 0 - every frame
+    QElapsedTimer updateTimer;
+    qint64 nextUpdate = 0;  //msec of updateTimer, updates are scheduled, so the rate isn't rounded to frames
+    struct Position {
+        float x = 0;
+        float y = 0;
+        float angle = 0;
+    } position;
+    bool positionChanged = false;
+    TrajectoryTrail trail;
+
+    //every channel has the latest value and serieses in the model,
+    //the store and the statistics by the same channel id
+    ChannelModel channels;
+    int encoderChannel;
+    int steeringChannel;
+    int speedChannel;
+    int xChannel;
+    int yChannel;
+    int angleChannel;
+    int tempChannel;
+    int motorBatteryChannel;
+    int compBatteryChannel;
+
+    //whole session history, charts keep only the visible window
+    TelemetryStore store;
+
+    //statistics of every channel
+    static const int statsInterval = 1000;  //msec
+    QVector<ChannelStats*> stats;
+    QElapsedTimer statsTimer;
+
+    TelemetryExporter exporter;
+
+    //derived channels, declared in the constructor
+    DerivedChannels derived;
+    int encoderSource;
+    int angleSource;
+    QVector<int> derivedInputs;     //derived engine channel -> model channel
+    QVector<int> derivedOutputs;
+    QVector<int> derivedCharts;     //channels for the derived chart
+    int derivedShown = 0;   //index in derivedCharts
+    QObject *derivedSeriesObj = nullptr;
+
+    int addChannel(QString const& name, QString const& title, QString const& unit, bool filtered = false);
     void clearCharts();
-    float getSpeed(float currentTime, float currentEncoder);
+    double sessionTime(quint32 timeStamp);
+    void updateDerived(int source, double time, float value);
+    void record(int channel, double time, float value);
+    void recordColumn(int channel, QVector<double> const& times, QVector<float> const& values);
+    void recordBatch(TelemetryColumns const& batch);
+    void recordLowFreq(LowFreqDataPackage const& data);
+    void emitStats();
+    void emitDerived();
 
 public:
     explicit Adapter(QObject *parent = nullptr);
+    ~Adapter();
     void log(QString const& message);
+    QObject* getChannels();
+    void detachSerieses();
+    void setUpdateInterval(int msec);
 
 signals:
     //signals adapter -> network client
@@ -38,6 +104,7 @@ signals:
     void signalSettingsLoad(SetPackage const& set);
     void signalSettingsUpload();
     void signalControl(ControlPackage const& data);
+    void signalGoal(GoalPackage const& goal);
 
     //signals adapter -> UI
     void signalUILog(QString const& message);
@@ -47,17 +114,28 @@ signals:
     void signalUIConnectionError();
     void signalUIStatus(QString const& str);
     void signalUIUpdatePosition(float const& x, float const& y, float const& angle);
-    void signalUIUpdateHighFreqData(float const& encValue, float const& potValue, float const& speedValue);
-    void signalUIUpdateLowFreqData(quint32 const& firstBatteryValue, quint32 const& secondBatteryValue, float const& temp);
     void signalUISettings(float steering_p, float steering_i, float steering_d, float steering_zero,
                           float forward_p, float forward_i, float forward_d, float forward_int,
                           float backward_p, float backward_i, float backward_d, float backward_int);
-    void signalUIMap(int w, int h, QList<int> const& cellList);
+    void signalUIMap(int w, int h);
+    void signalUIDerived(QStringList const& names, int current);
+    void signalUIStats(QVariantList const& rows);
+    void signalUIExporting(bool exporting);
+    //the filtered history is computed from min/max pairs at this zoom
+    void signalUIHistoryApproximate(bool approximate);
 
 public slots:
     //slots UI -> adapter
     void slotUISetSerieses(QObject *speedSeries, QObject* speedSeiresFilter,
-                           QObject *potentiometerSeries, QObject *tempSeries, QObject *tempSeriesFilter);
+                           QObject *potentiometerSeries, QObject *tempSeries, QObject *tempSeriesFilter,
+                           QObject *derivedSeries);
+    void slotUISetMap(QObject *mapItem);
+    void slotUISelectDerived(int index);
+    void slotUISetStatsWindow(int seconds);
+    void slotUIExportStart(int formats);
+    void slotUIExportStop();
+    //replays a binary export into the charts and the history, the latest one of the documents if the path is empty
+    void slotUIReplay(QString path = QString());
     void slotUISearch();
     void slotUIConnect(QString address, QString port = "5556");
     void slotUIDisconnect();
@@ -67,8 +145,13 @@ public slots:
     void slotUISettingsUpload();
     void slotUIClearCharts();
     void slotUIControl(float const& xAxis, float const& yAxis);
+    void slotUIGoal(int x, int y);
     void slotUISetFilter(int filterType);
     void slotUISetFilterK(float k);
+    void slotUIRefresh();
+    void slotUIHistory(float position, float range);
+    void slotUILive();
+    void slotFrame();
 
     //slots network client -> adapter
     void slotAddresses(QList<QString> const& addresses);
@@ -77,6 +160,7 @@ public slots:
     void slotConnectionError(QString message);
     void slotData(LowFreqDataPackage const& data);
     void slotData(HighFreqDataPackage const& data);
+    void slotDataBatch(TelemetryColumns const& batch);
     void slotDone(qint8 const& answerCode);
     void slotSettings(SetPackage const& set);
     void slotMap(MapPackage const& map);
@@ -0,0 +1,132 @@
+#include "channelmodel.h"
+
+ChannelModel::ChannelModel(QObject *parent) : QAbstractListModel(parent)   {}
+
+ChannelModel::~ChannelModel()   {
+    for (Channel const& channel : channels) {
+        delete channel.series;
+        delete channel.filterSeries;
+    }
+}
+
+int ChannelModel::rowCount(QModelIndex const& parent) const {
+    if (parent.isValid())
+        return 0;
+    return channels.size();
+}
+
+QVariant ChannelModel::data(QModelIndex const& index, int role) const  {
+    if (!index.isValid() || index.row() >= channels.size())
+        return QVariant();
+
+    Channel const& channel = channels.at(index.row());
+    switch (role)   {
+    case NameRole:  {
+        return channel.name;
+    }
+    case Qt::DisplayRole:
+    case TitleRole: {
+        return channel.title;
+    }
+    case ValueRole: {
+        return channel.value;
+    }
+    case UnitRole:  {
+        return channel.unit;
+    }
+    }
+    return QVariant();
+}
+
+QHash<int, QByteArray> ChannelModel::roleNames() const  {
+    QHash<int, QByteArray> roles;
+    roles[NameRole] = "name";
+    roles[TitleRole] = "title";
+    roles[ValueRole] = "value";
+    roles[UnitRole] = "measure";
+    return roles;
+}
+
+int ChannelModel::addChannel(QString const& name, QString const& title, QString const& unit, bool filtered)  {
+    Channel channel;
+    channel.name = name;
+    channel.title = title;
+    channel.unit = unit;
+    channel.series = new SVSeries();
+    if (filtered)
+        channel.filterSeries = new SVSeries();
+
+    beginInsertRows(QModelIndex(), channels.size(), channels.size());
+    channels.append(channel);
+    endInsertRows();
+    return channels.size() - 1;
+}
+
+int ChannelModel::indexOf(QString const& name) const    {
+    for (int i = 0; i < channels.size(); i++)
+        if (channels.at(i).name == name)
+            return i;
+    return -1;
+}
+
+int ChannelModel::count() const {
+    return channels.size();
+}
+
+QString ChannelModel::name(int channel) const   {
+    return channels.at(channel).name;
+}
+
+QString ChannelModel::title(int channel) const  {
+    return channels.at(channel).title;
+}
+
+void ChannelModel::setValue(int channel, double value)  {
+    Channel &target = channels[channel];
+    target.value = value;
+    target.changed = true;
+    anyChanged = true;
+}
+
+double ChannelModel::value(int channel) const   {
+    return channels.at(channel).value;
+}
+
+SVSeries* ChannelModel::series(int channel) const   {
+    return channels.at(channel).series;
+}
+
+SVSeries* ChannelModel::filterSeries(int channel) const {
+    return channels.at(channel).filterSeries;
+}
+
+QList<SVSeries*> ChannelModel::serieses() const {
+    QList<SVSeries*> list;
+    for (Channel const& channel : channels) {
+        list.append(channel.series);
+        if (channel.filterSeries)
+            list.append(channel.filterSeries);
+    }
+    return list;
+}
+
+//contiguous changed rows are published by one signal
+void ChannelModel::flushChanges()   {
+    if (!anyChanged)
+        return;
+    anyChanged = false;
+
+    static const QVector<int> roles = { ValueRole };
+    int first = -1;
+    for (int i = 0; i <= channels.size(); i++)  {
+        bool changed = i < channels.size() && channels.at(i).changed;
+        if (changed)    {
+            channels[i].changed = false;
+            if (first < 0)
+                first = i;
+        }   else if (first >= 0)    {
+            emit dataChanged(index(first), index(i - 1), roles);
+            first = -1;
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef CHANNELMODEL_H
+#define CHANNELMODEL_H
+
+#include <QAbstractListModel>
+#include <QVector>
+#include <QList>
+#include "svseries.h"
+
+/*
+ * Registry of the telemetry channels: name, title, units, the latest value
+ * and the chart serieses of every channel.
+ * Values are set as they come and published to QML by flushChanges(),
+ * one dataChanged per range of changed rows.
+ */
+class ChannelModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    enum Roles {
+        NameRole = Qt::UserRole + 1,
+        TitleRole,
+        ValueRole,
+        UnitRole
+    };
+private:
+    struct Channel  {
+        QString name;
+        QString title;
+        QString unit;
+        double value = 0;
+        bool changed = false;
+        SVSeries *series = nullptr;
+        SVSeries *filterSeries = nullptr;
+    };
+
+    QVector<Channel> channels;
+    bool anyChanged = false;
+public:
+    explicit ChannelModel(QObject *parent = nullptr);
+    ~ChannelModel() override;
+
+    int rowCount(QModelIndex const& parent = QModelIndex()) const override;
+    QVariant data(QModelIndex const& index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    //registers the channel with its own series and optionally a filtered one,
+    //a series allocates its points when a chart attaches, see SVSeries::setSeriesObj()
+    int addChannel(QString const& name, QString const& title, QString const& unit, bool filtered = false);
+    int indexOf(QString const& name) const;
+    int count() const;
+    QString name(int channel) const;
+    QString title(int channel) const;
+
+    void setValue(int channel, double value);
+    double value(int channel) const;
+    SVSeries* series(int channel) const;
+    SVSeries* filterSeries(int channel) const;
+    //all serieses, raw and filtered
+    QList<SVSeries*> serieses() const;
+
+    //emits dataChanged for the changed rows since the last call
+    void flushChanges();
+};
+
+#endif // CHANNELMODEL_H
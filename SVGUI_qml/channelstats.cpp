@@ -0,0 +1,175 @@
+#include "channelstats.h"
+#include <cmath>
+#include <cstring>
+
+//quantile sketch
+
+QuantileSketch::QuantileSketch()    {
+    clear();
+}
+
+int QuantileSketch::bucket(double value)    {
+    static const double logGamma = std::log((1 + relativeAccuracy) / (1 - relativeAccuracy));
+    int index = static_cast<int>(std::ceil(std::log(value) / logGamma)) + bucketOffset;
+    return qBound(0, index, bucketCount - 1);
+}
+
+//center of the bucket in terms of the relative error
+double QuantileSketch::bucketValue(int index)   {
+    static const double gamma = (1 + relativeAccuracy) / (1 - relativeAccuracy);
+    return 2 * std::pow(gamma, index - bucketOffset) / (gamma + 1);
+}
+
+void QuantileSketch::add(double value)  {
+    if (!std::isfinite(value))
+        return;
+    if (value > minValue)
+        positive[bucket(value)]++;
+    else if (value < -minValue)
+        negative[bucket(-value)]++;
+    else
+        zero++;
+    total++;
+}
+
+void QuantileSketch::merge(QuantileSketch const& sketch)    {
+    for (int i = 0; i < bucketCount; i++)   {
+        positive[i] += sketch.positive[i];
+        negative[i] += sketch.negative[i];
+    }
+    zero += sketch.zero;
+    total += sketch.total;
+}
+
+//walks the buckets from the most negative value up to the rank
+double QuantileSketch::quantile(double q) const {
+    if (total == 0)
+        return 0;
+    quint64 rank = static_cast<quint64>(qBound(0.0, q, 1.0) * (total - 1));
+    quint64 seen = 0;
+    for (int i = bucketCount - 1; i >= 0; i--)  {
+        seen += negative[i];
+        if (seen > rank)
+            return -bucketValue(i);
+    }
+    seen += zero;
+    if (seen > rank)
+        return 0;
+    for (int i = 0; i < bucketCount; i++)   {
+        seen += positive[i];
+        if (seen > rank)
+            return bucketValue(i);
+    }
+    return bucketValue(bucketCount - 1);
+}
+
+quint64 QuantileSketch::count() const   {
+    return total;
+}
+
+void QuantileSketch::clear()    {
+    std::memset(positive, 0, sizeof(positive));
+    std::memset(negative, 0, sizeof(negative));
+    zero = 0;
+    total = 0;
+}
+
+//stream stats
+
+void StreamStats::add(double value) {
+    if (!std::isfinite(value))  {
+        rejected++;
+        return;
+    }
+    count++;
+    double delta = value - mean;
+    mean += delta / count;
+    m2 += delta * (value - mean);
+    min = qMin(min, value);
+    max = qMax(max, value);
+    sketch.add(value);
+}
+
+//parallel variant of Welford's update (Chan et al.)
+void StreamStats::merge(StreamStats const& stats)   {
+    rejected += stats.rejected;
+    if (stats.count == 0)
+        return;
+    quint64 total = count + stats.count;
+    double delta = stats.mean - mean;
+    mean += delta * stats.count / total;
+    m2 += stats.m2 + delta * delta * count * stats.count / total;
+    count = total;
+    min = qMin(min, stats.min);
+    max = qMax(max, stats.max);
+    sketch.merge(stats.sketch);
+}
+
+double StreamStats::variance() const    {
+    return count > 1 ? m2 / (count - 1) : 0;
+}
+
+void StreamStats::clear()   {
+    count = 0;
+    rejected = 0;
+    mean = 0;
+    m2 = 0;
+    min = std::numeric_limits<double>::max();
+    max = std::numeric_limits<double>::lowest();
+    sketch.clear();
+}
+
+//channel stats
+
+ChannelStats::ChannelStats(double windowLength)  {
+    setWindow(windowLength);
+}
+
+void ChannelStats::setWindow(double windowLength)   {
+    subWindowLength = qMax(windowLength, 1.0) / subWindows;
+    for (StreamStats &stats : windows)
+        stats.clear();
+    started = false;
+}
+
+double ChannelStats::window() const {
+    return subWindowLength * subWindows;
+}
+
+void ChannelStats::add(double time, double value)   {
+    session.add(value);
+
+    if (!started)   {
+        currentEnd = time + subWindowLength;
+        started = true;
+    }
+    //a gap longer than the window clears every sub-window once
+    for (int i = 0; i < subWindows && time >= currentEnd; i++)  {
+        current = (current + 1) % subWindows;
+        windows[current].clear();
+        currentEnd += subWindowLength;
+    }
+    if (time >= currentEnd)
+        currentEnd = time + subWindowLength;
+    windows[current].add(value);
+}
+
+StreamStats const& ChannelStats::sessionStats() const   {
+    return session;
+}
+
+//window statistics are merged on request, it's O(sub-windows * buckets)
+StreamStats ChannelStats::windowStats() const   {
+    StreamStats stats;
+    for (StreamStats const& subWindow : windows)
+        stats.merge(subWindow);
+    return stats;
+}
+
+void ChannelStats::clear()  {
+    session.clear();
+    for (StreamStats &stats : windows)
+        stats.clear();
+    current = 0;
+    started = false;
+}
@@ -0,0 +1,83 @@
+#ifndef CHANNELSTATS_H
+#define CHANNELSTATS_H
+
+#include <QtGlobal>
+#include <limits>
+
+/*
+ * Mergeable quantile sketch with relative accuracy.
+ * Values are counted in logarithmic buckets, a bucket covers values within
+ * relativeAccuracy of its center, so a quantile is off by at most 2% of its value.
+ * Memory is fixed, sketches of the same accuracy are merged by adding the buckets.
+ */
+class QuantileSketch
+{
+private:
+    static const int bucketCount = 1024;    //per sign, covers about 1e-9..1e9
+    static const int bucketOffset = bucketCount / 2;
+    static constexpr double relativeAccuracy = 0.02;
+    static constexpr double minValue = 1e-9;   //smaller values are counted as zero
+
+    quint32 positive[bucketCount];
+    quint32 negative[bucketCount];
+    quint32 zero = 0;
+    quint64 total = 0;
+
+    static int bucket(double value);
+    static double bucketValue(int index);
+public:
+    QuantileSketch();
+    void add(double value);
+    void merge(QuantileSketch const& sketch);
+    //q: 0..1
+    double quantile(double q) const;
+    quint64 count() const;
+    void clear();
+};
+
+//count, min/max, mean and variance (Welford) and quantiles of the samples
+//values come from the network, NaN and infinities are only counted as rejected
+struct StreamStats
+{
+    quint64 count = 0;
+    quint64 rejected = 0;
+    double mean = 0;
+    double m2 = 0;
+    double min = std::numeric_limits<double>::max();
+    double max = std::numeric_limits<double>::lowest();
+    QuantileSketch sketch;
+
+    void add(double value);
+    void merge(StreamStats const& stats);
+    double variance() const;
+    void clear();
+};
+
+/*
+ * Statistics of one channel over the whole session and over a sliding time window.
+ * The window is split into sub-windows, the oldest one is dropped as a whole,
+ * so every sample is O(1) and memory doesn't depend on the rate.
+ */
+class ChannelStats
+{
+private:
+    static const int subWindows = 6;
+
+    StreamStats session;
+    StreamStats windows[subWindows];
+    int current = 0;
+    double subWindowLength;
+    double currentEnd = 0;
+    bool started = false;
+public:
+    explicit ChannelStats(double windowLength = 60);
+    void setWindow(double windowLength);
+    double window() const;
+
+    void add(double time, double value);
+    StreamStats const& sessionStats() const;
+    StreamStats windowStats() const;
+    void clear();
+};
+
+#endif // CHANNELSTATS_H
@@ -0,0 +1,190 @@
+#include "derivedchannels.h"
+#include <QDebug>
+#include <cmath>
+
+DerivedChannels::DerivedChannels()  {}
+
+int DerivedChannels::addSource(QString const& name)    {
+    int index = channel(name);
+    if (index >= 0)
+        return index;
+    Channel source;
+    source.name = name;
+    channels.append(source);
+    return channels.size() - 1;
+}
+
+//the source must be declared before, so declaration order is evaluation order
+int DerivedChannels::declare(QString const& name, QString const& source, Operation operation,
+                             int window, double period)   {
+    int sourceIndex = channel(source);
+    if (sourceIndex < 0 || operation == SOURCE || channel(name) >= 0)   {
+        qDebug() << "Derived channels: can't declare " << name << " from " << source;
+        return -1;
+    }
+    Channel derived;
+    derived.name = name;
+    derived.operation = operation;
+    derived.source = sourceIndex;
+    derived.period = period;
+    derived.window.setCapacity(qMax(2, window));
+    channels.append(derived);
+    return channels.size() - 1;
+}
+
+int DerivedChannels::channel(QString const& name) const {
+    for (int i = 0; i < channels.size(); i++)
+        if (channels.at(i).name == name)
+            return i;
+    return -1;
+}
+
+int DerivedChannels::count() const  {
+    return channels.size();
+}
+
+QString DerivedChannels::name(int channel) const    {
+    return channels.at(channel).name;
+}
+
+bool DerivedChannels::isDerived(int channel) const  {
+    return channels.at(channel).operation != SOURCE;
+}
+
+QStringList DerivedChannels::derivedNames() const   {
+    QStringList names;
+    for (Channel const& channel : channels)
+        if (channel.operation != SOURCE)
+            names.append(channel.name);
+    return names;
+}
+
+void DerivedChannels::update(int source, double time, double value) {
+    for (Channel &channel : channels)
+        channel.updated = false;
+
+    Channel &input = channels[source];
+    input.value = value;
+    input.valid = true;
+    input.updated = true;
+
+    for (int i = source + 1; i < channels.size(); i++)  {
+        Channel &channel = channels[i];
+        if (channel.operation == SOURCE || !channels.at(channel.source).updated)
+            continue;
+        evaluate(channel, time, channels.at(channel.source).value);
+    }
+}
+
+void DerivedChannels::evaluate(Channel &channel, double time, double input)    {
+    switch (channel.operation)  {
+    case SOURCE:    {
+        return;
+    }
+    case DERIVATIVE:    {
+        slope(channel, time, input);
+        break;
+    }
+    case ANGLE_DERIVATIVE:  {
+        //the angle is unwrapped, so crossing the full turn isn't a jump
+        if (channel.hasLast)
+            channel.unwrapOffset -= channel.period * std::round((input - channel.last.value) / channel.period);
+        slope(channel, time, input + channel.unwrapOffset);
+        break;
+    }
+    case INTEGRAL:
+    case ABS_INTEGRAL:  {
+        double value = channel.operation == ABS_INTEGRAL ? qAbs(input) : input;
+        double lastValue = channel.operation == ABS_INTEGRAL ? qAbs(channel.last.value) : channel.last.value;
+        //trapezoids, samples going back in time add nothing
+        if (channel.hasLast && time > channel.last.time)
+            channel.value += (value + lastValue) / 2 * (time - channel.last.time);
+        channel.valid = true;
+        channel.updated = true;
+        break;
+    }
+    }
+    channel.last.time = time;
+    channel.last.value = input;
+    channel.hasLast = true;
+}
+
+//least squares slope of the window, running sums are updated by the new and the evicted sample
+void DerivedChannels::slope(Channel &channel, double time, double value)   {
+    if (channel.window.isEmpty())   {
+        channel.origin.time = time;
+        channel.origin.value = value;
+    }
+    if (channel.window.isFull())    {
+        Sample const& oldest = channel.window.first();
+        double t = oldest.time - channel.origin.time;
+        double v = oldest.value - channel.origin.value;
+        channel.sumT -= t;
+        channel.sumV -= v;
+        channel.sumTT -= t * t;
+        channel.sumTV -= t * v;
+    }
+    Sample sample;
+    sample.time = time;
+    sample.value = value;
+    channel.window.push(sample);
+    double t = time - channel.origin.time;
+    double v = value - channel.origin.value;
+    channel.sumT += t;
+    channel.sumV += v;
+    channel.sumTT += t * t;
+    channel.sumTV += t * v;
+
+    //the origin follows the window and the sums are recalculated to drop the accumulated error
+    if (++channel.sinceRebase >= rebaseInterval)
+        rebase(channel);
+
+    double n = channel.window.size();
+    double denominator = n * channel.sumTT - channel.sumT * channel.sumT;
+    //all the window samples have the same time: the last slope is kept
+    if (n < 2 || denominator <= 1e-9 * n * channel.sumTT)
+        return;
+    channel.value = (n * channel.sumTV - channel.sumT * channel.sumV) / denominator;
+    channel.valid = true;
+    channel.updated = true;
+}
+
+void DerivedChannels::rebase(Channel &channel)  {
+    channel.origin = channel.window.last();
+    channel.sumT = channel.sumV = channel.sumTT = channel.sumTV = 0;
+    for (int i = 0; i < channel.window.size(); i++) {
+        double t = channel.window.at(i).time - channel.origin.time;
+        double v = channel.window.at(i).value - channel.origin.value;
+        channel.sumT += t;
+        channel.sumV += v;
+        channel.sumTT += t * t;
+        channel.sumTV += t * v;
+    }
+    channel.sinceRebase = 0;
+}
+
+double DerivedChannels::value(int channel) const    {
+    return channels.at(channel).value;
+}
+
+bool DerivedChannels::isValid(int channel) const    {
+    return channels.at(channel).valid;
+}
+
+bool DerivedChannels::isUpdated(int channel) const  {
+    return channels.at(channel).updated;
+}
+
+//drops the state of all the channels, declarations are kept
+void DerivedChannels::reset()   {
+    for (Channel &channel : channels)   {
+        channel.window.clear();
+        channel.sumT = channel.sumV = channel.sumTT = channel.sumTV = 0;
+        channel.sinceRebase = 0;
+        channel.hasLast = false;
+        channel.unwrapOffset = 0;
+        channel.value = 0;
+        channel.valid = false;
+        channel.updated = false;
+    }
+}
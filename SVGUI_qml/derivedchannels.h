@@ -0,0 +1,77 @@
+#ifndef DERIVEDCHANNELS_H
+#define DERIVEDCHANNELS_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "ringbuffer.h"
+
+/*
+ * Channels computed from the telemetry channels or from other derived channels.
+ * Every channel is declared once by its source and operation. An input sample
+ * updates the dependent channels in declaration order, O(1) per channel.
+ * Derivatives are least squares slopes over a sliding window of samples, so noise,
+ * irregular and duplicate timestamps don't blow them up.
+ */
+class DerivedChannels
+{
+public:
+    enum Operation { SOURCE, DERIVATIVE, ANGLE_DERIVATIVE, INTEGRAL, ABS_INTEGRAL };
+private:
+    static const int rebaseInterval = 1024;
+
+    struct Sample   {
+        double time = 0;
+        double value = 0;
+    };
+
+    struct Channel  {
+        QString name;
+        Operation operation = SOURCE;
+        int source = -1;
+        double period = 0;  //angle period for unwrapping
+
+        //sliding window and its running sums relative to the origin
+        RingBuffer<Sample> window;
+        Sample origin;
+        double sumT = 0, sumV = 0, sumTT = 0, sumTV = 0;
+        int sinceRebase = 0;
+
+        bool hasLast = false;
+        Sample last;    //previous input
+        double unwrapOffset = 0;
+
+        double value = 0;
+        bool valid = false;
+        bool updated = false;
+    };
+
+    QVector<Channel> channels;
+
+    void evaluate(Channel &channel, double time, double input);
+    void slope(Channel &channel, double time, double value);
+    void rebase(Channel &channel);
+public:
+    DerivedChannels();
+
+    //input channel, its values are given by update()
+    int addSource(QString const& name);
+    //window: samples of the derivative fit, period: full turn of the angle
+    int declare(QString const& name, QString const& source, Operation operation,
+                int window = 9, double period = 360);
+    int channel(QString const& name) const;
+    int count() const;
+    QString name(int channel) const;
+    bool isDerived(int channel) const;
+    QStringList derivedNames() const;
+
+    //sets the source value and updates the channels which depend on it
+    void update(int source, double time, double value);
+    double value(int channel) const;
+    bool isValid(int channel) const;
+    //true if the channel got a new value by the last update()
+    bool isUpdated(int channel) const;
+    void reset();
+};
+
+#endif // DERIVEDCHANNELS_H
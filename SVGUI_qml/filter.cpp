@@ -1,57 +1,517 @@
 #include "filter.h"
+#include <QtMath>
+#include <algorithm>
+#include <cstring>
+
+Filter* Filter::create(FilterType type)    {
+    switch (type)   {
+    case NONE:  {
+        return nullptr;
+    }
+    case KALMAN:    {
+        return new FilterKalman(FilterKalman::SCALAR);
+    }
+    case GAF:   {
+        return new FilterGA();
+    }
+    case KALMAN_CV: {
+        return new FilterKalman(FilterKalman::CONSTANT_VELOCITY);
+    }
+    case LOWPASS:   {
+        return new FilterLowPass();
+    }
+    case MEDIAN:    {
+        return new FilterMedian();
+    }
+    case SAVGOL:    {
+        return new FilterSavitzkyGolay();
+    }
+    case CHAIN: {
+        //spikes are removed before smoothing
+        FilterChain *chain = new FilterChain();
+        chain->append(new FilterMedian());
+        chain->append(new FilterLowPass());
+        return chain;
+    }
+    }
+    return nullptr;
+}
+
+bool Filter::setK(float)    {
+    return false;
+}
 
 Filter::~Filter()   {}
 
-FilterKalman::FilterKalman(float K) : K(K) {}
+//window
+
+FilterWindow::FilterWindow(int length)  {
+    setLength(length);
+}
+
+void FilterWindow::setLength(int length)    {
+    this->length = qBound(1, length, maxSize);
+    clear();
+}
+
+int FilterWindow::getLength() const {
+    return length;
+}
+
+int FilterWindow::size() const  {
+    return count;
+}
+
+bool FilterWindow::isFull() const   {
+    return count == length;
+}
+
+void FilterWindow::clear()  {
+    pos = 0;
+    count = 0;
+}
+
+float FilterWindow::push(float sample)  {
+    float evicted = count == length ? data[pos] : 0;
+    data[pos] = sample;
+    data[pos + length] = sample;
+    pos = pos + 1 == length ? 0 : pos + 1;
+    if (count < length)
+        count++;
+    return evicted;
+}
+
+float const* FilterWindow::samples() const  {
+    return data + pos + length - count;
+}
+
+//Kalman
 
-void FilterKalman::setK(float K)    {
-    this->K = K;
+FilterKalman::FilterKalman(Model model, double measurementNoise, float K) :
+    model(model), processNoise(0), measurementNoise(measurementNoise)  {
+    setK(K);
+}
+
+//K is the steady state gain of the scalar model: q / r = K^2 / (1 - K)
+//the constant velocity model gets the same noise ratio
+bool FilterKalman::setK(float K)    {
+    this->K = qBound(0.01f, K, 0.99f);
+    double k = static_cast<double>(this->K);
+    processNoise = measurementNoise * k * k / (1 - k);
+    return true;
 }
 
 float FilterKalman::getK() const    {
     return K;
 }
 
-Filter::FilterType FilterKalman::getType() const    {
-    return type;
+void FilterKalman::setNoise(double processNoise, double measurementNoise)   {
+    this->processNoise = processNoise;
+    this->measurementNoise = measurementNoise;
+}
+
+inline float FilterKalman::step(float sample)  {
+    double z = static_cast<double>(sample);
+    if (!initialized)   {
+        x0 = z;
+        x1 = 0;
+        p00 = measurementNoise;
+        p01 = 0;
+        p11 = measurementNoise;
+        initialized = true;
+        return sample;
+    }
+
+    if (model == SCALAR)    {
+        p00 += processNoise;
+        double gain = p00 / (p00 + measurementNoise);
+        x0 += gain * (z - x0);
+        p00 *= 1 - gain;
+        return static_cast<float>(x0);
+    }
+
+    //predict: x = F x, P = F P F' + Q, F = [1 1; 0 1], white noise acceleration
+    x0 += x1;
+    p00 += 2 * p01 + p11 + processNoise / 3;
+    p01 += p11 + processNoise / 2;
+    p11 += processNoise;
+
+    //update by the value measurement
+    double s = p00 + measurementNoise;
+    double k0 = p00 / s;
+    double k1 = p01 / s;
+    double innovation = z - x0;
+    x0 += k0 * innovation;
+    x1 += k1 * innovation;
+    p11 -= k1 * p01;
+    p00 *= 1 - k0;
+    p01 *= 1 - k0;
+    return static_cast<float>(x0);
 }
 
-double FilterKalman::calculate(double prev, double current)    {
-    return K * current + (1 - K) * prev;
+float FilterKalman::process(float sample)   {
+    return step(sample);
+}
+
+void FilterKalman::process(float const* in, float* out, int n)  {
+    for (int i = 0; i < n; i++)
+        out[i] = step(in[i]);
+}
+
+void FilterKalman::reset()  {
+    initialized = false;
+}
+
+Filter* FilterKalman::clone() const {
+    return new FilterKalman(*this);
+}
+
+Filter::FilterType FilterKalman::getType() const    {
+    return model == SCALAR ? KALMAN : KALMAN_CV;
 }
 
 FilterKalman::~FilterKalman() {}
 
-FilterGA::FilterGA(int N) : N(N)  {}
+//gliding average
+
+FilterGA::FilterGA(int N) : window(N)  {}
 
 void FilterGA::setN(int N)    {
-    this->N = N;
+    window.setLength(N);
+    sum = 0;
 }
 
 int FilterGA::getN() const    {
-    return N;
+    return window.getLength();
+}
+
+inline float FilterGA::step(float sample)   {
+    bool full = window.isFull();
+    float evicted = window.push(sample);
+    sum += static_cast<double>(sample);
+    if (full)
+        sum -= static_cast<double>(evicted);
+    return static_cast<float>(sum / window.size());
+}
+
+float FilterGA::process(float sample)   {
+    return step(sample);
+}
+
+void FilterGA::process(float const* in, float* out, int n)  {
+    for (int i = 0; i < n; i++)
+        out[i] = step(in[i]);
+}
+
+void FilterGA::reset()  {
+    window.clear();
+    sum = 0;
+}
+
+Filter* FilterGA::clone() const {
+    return new FilterGA(*this);
 }
 
 Filter::FilterType FilterGA::getType() const    {
-    return type;
+    return GAF;
 }
 
-double FilterGA::calculate(double prev, double current) {
-    values.enqueue(current);
-    if (values.isEmpty())   {
-        return current;
+FilterGA::~FilterGA()   {}
+
+//low-pass
+
+FilterLowPass::FilterLowPass(double cutoff, double q) : cutoff(cutoff), q(q)  {
+    updateCoefficients();
+}
+
+//RBJ cookbook low-pass
+void FilterLowPass::updateCoefficients()    {
+    double w0 = 2 * M_PI * cutoff;
+    double alpha = sin(w0) / (2 * q);
+    double cosw = cos(w0);
+    double a0 = 1 + alpha;
+    b0 = (1 - cosw) / 2 / a0;
+    b1 = (1 - cosw) / a0;
+    b2 = b0;
+    a1 = -2 * cosw / a0;
+    a2 = (1 - alpha) / a0;
+}
+
+void FilterLowPass::setCutoff(double cutoff)    {
+    this->cutoff = qBound(0.001, cutoff, 0.499);
+    updateCoefficients();
+}
+
+double FilterLowPass::getCutoff() const {
+    return cutoff;
+}
+
+//bigger K lets more of the signal through
+bool FilterLowPass::setK(float K)   {
+    setCutoff(0.001 + 0.249 * static_cast<double>(qBound(0.0f, K, 1.0f)));
+    return true;
+}
+
+inline float FilterLowPass::step(float sample)  {
+    double x = static_cast<double>(sample);
+    if (!initialized)   {
+        //steady state for the constant input, so the output doesn't rise from zero
+        z1 = x * (1 - b0);
+        z2 = x * (b2 - a2);
+        initialized = true;
     }
+    double y = b0 * x + z1;
+    z1 = b1 * x - a1 * y + z2;
+    z2 = b2 * x - a2 * y;
+    return static_cast<float>(y);
+}
 
-    if (values.size() < N)  {
-        double sum = 0;
-        for (double &value : values)    {
-            sum += value;
+float FilterLowPass::process(float sample)  {
+    return step(sample);
+}
+
+void FilterLowPass::process(float const* in, float* out, int n) {
+    for (int i = 0; i < n; i++)
+        out[i] = step(in[i]);
+}
+
+void FilterLowPass::reset() {
+    initialized = false;
+    z1 = 0;
+    z2 = 0;
+}
+
+Filter* FilterLowPass::clone() const    {
+    return new FilterLowPass(*this);
+}
+
+Filter::FilterType FilterLowPass::getType() const   {
+    return LOWPASS;
+}
+
+FilterLowPass::~FilterLowPass() {}
+
+//median
+
+FilterMedian::FilterMedian(int N) : window(N)  {}
+
+void FilterMedian::setN(int N)  {
+    window.setLength(N);
+}
+
+int FilterMedian::getN() const  {
+    return window.getLength();
+}
+
+//window samples are kept sorted, one removal and one insertion per sample
+inline float FilterMedian::step(float sample)   {
+    int count = window.size();
+    if (window.isFull())    {
+        float evicted = window.push(sample);
+        float *position = std::lower_bound(sorted, sorted + count, evicted);
+        std::memmove(position, position + 1, static_cast<size_t>(sorted + count - position - 1) * sizeof(float));
+        count--;
+    }   else    {
+        window.push(sample);
+    }
+    float *position = std::upper_bound(sorted, sorted + count, sample);
+    std::memmove(position + 1, position, static_cast<size_t>(sorted + count - position) * sizeof(float));
+    *position = sample;
+    count++;
+
+    if (count % 2)
+        return sorted[count / 2];
+    return (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+}
+
+float FilterMedian::process(float sample)   {
+    return step(sample);
+}
+
+void FilterMedian::process(float const* in, float* out, int n)  {
+    for (int i = 0; i < n; i++)
+        out[i] = step(in[i]);
+}
+
+void FilterMedian::reset()  {
+    window.clear();
+}
+
+Filter* FilterMedian::clone() const {
+    return new FilterMedian(*this);
+}
+
+Filter::FilterType FilterMedian::getType() const    {
+    return MEDIAN;
+}
+
+FilterMedian::~FilterMedian()   {}
+
+//Savitzky-Golay
+
+FilterSavitzkyGolay::FilterSavitzkyGolay(int N, int order)  {
+    setWindow(N, order);
+}
+
+void FilterSavitzkyGolay::setWindow(int N, int order)   {
+    window.setLength(N);
+    this->order = qBound(0, order, qMin(maxOrder, window.getLength() - 1));
+    updateCoefficients();
+}
+
+int FilterSavitzkyGolay::getN() const   {
+    return window.getLength();
+}
+
+int FilterSavitzkyGolay::getOrder() const   {
+    return order;
+}
+
+//fit y = g0 + g1 t + ... over t = -(N-1)..0, the value at t = 0 is g0
+//so the coefficients are the first row of (A'A)^-1 A'
+void FilterSavitzkyGolay::updateCoefficients()  {
+    int n = window.getLength();
+    int size = order + 1;
+    double m[maxOrder + 1][maxOrder + 2] = {};
+    for (int j = 0; j < size; j++)  {
+        for (int k = 0; k < size; k++)
+            for (int i = 0; i < n; i++)
+                m[j][k] += pow(i - n + 1, j + k);
+        m[j][size] = j == 0 ? 1 : 0;
+    }
+
+    //(A'A) g = e0, Gaussian elimination with partial pivoting
+    for (int col = 0; col < size; col++)    {
+        int pivot = col;
+        for (int row = col + 1; row < size; row++)
+            if (qAbs(m[row][col]) > qAbs(m[pivot][col]))
+                pivot = row;
+        for (int k = 0; k <= size; k++)
+            std::swap(m[col][k], m[pivot][k]);
+        for (int row = 0; row < size; row++)    {
+            if (row == col)
+                continue;
+            double factor = m[row][col] / m[col][col];
+            for (int k = col; k <= size; k++)
+                m[row][k] -= factor * m[col][k];
         }
-        return 1.0 / values.size() * sum;
     }
 
-    double lastInFilterRange = values.dequeue();
-    return prev + 1.0 / N * (current - lastInFilterRange);
+    for (int i = 0; i < n; i++) {
+        double c = 0;
+        for (int k = 0; k < size; k++)
+            c += m[k][size] / m[k][k] * pow(i - n + 1, k);
+        coefficients[i] = static_cast<float>(c);
+    }
+}
+
+inline float FilterSavitzkyGolay::step(float sample)    {
+    window.push(sample);
+    if (!window.isFull())
+        return sample;
+
+    //window is contiguous, independent sums let the compiler use SIMD lanes
+    float const* samples = window.samples();
+    int n = window.getLength();
+    float sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+    int i = 0;
+    for (; i + 4 <= n; i += 4)  {
+        sum0 += coefficients[i] * samples[i];
+        sum1 += coefficients[i + 1] * samples[i + 1];
+        sum2 += coefficients[i + 2] * samples[i + 2];
+        sum3 += coefficients[i + 3] * samples[i + 3];
+    }
+    for (; i < n; i++)
+        sum0 += coefficients[i] * samples[i];
+    return (sum0 + sum1) + (sum2 + sum3);
 }
 
-FilterGA::~FilterGA()   {}
+float FilterSavitzkyGolay::process(float sample)    {
+    return step(sample);
+}
+
+void FilterSavitzkyGolay::process(float const* in, float* out, int n)   {
+    for (int i = 0; i < n; i++)
+        out[i] = step(in[i]);
+}
+
+void FilterSavitzkyGolay::reset()   {
+    window.clear();
+}
+
+Filter* FilterSavitzkyGolay::clone() const  {
+    return new FilterSavitzkyGolay(*this);
+}
+
+Filter::FilterType FilterSavitzkyGolay::getType() const {
+    return SAVGOL;
+}
+
+FilterSavitzkyGolay::~FilterSavitzkyGolay() {}
+
+//chain
+
+FilterChain::FilterChain()  {}
+
+FilterChain::FilterChain(FilterChain const& chain) : Filter()  {
+    for (int i = 0; i < chain.count; i++)
+        stages[i] = chain.stages[i]->clone();
+    count = chain.count;
+}
+
+//takes ownership of the stage, returns false if the chain is full
+bool FilterChain::append(Filter *stage) {
+    if (stage == nullptr || count == maxStages)   {
+        delete stage;
+        return false;
+    }
+    stages[count++] = stage;
+    return true;
+}
+
+int FilterChain::size() const   {
+    return count;
+}
+
+bool FilterChain::setK(float K) {
+    bool applied = false;
+    for (int i = 0; i < count; i++)
+        applied = stages[i]->setK(K) || applied;
+    return applied;
+}
+
+float FilterChain::process(float sample)    {
+    for (int i = 0; i < count; i++)
+        sample = stages[i]->process(sample);
+    return sample;
+}
+
+//every stage filters the whole block, so its state stays in registers
+void FilterChain::process(float const* in, float* out, int n)   {
+    if (count == 0)  {
+        if (in != out)
+            std::memmove(out, in, static_cast<size_t>(n) * sizeof(float));
+        return;
+    }
+    stages[0]->process(in, out, n);
+    for (int i = 1; i < count; i++)
+        stages[i]->process(out, out, n);
+}
+
+void FilterChain::reset()   {
+    for (int i = 0; i < count; i++)
+        stages[i]->reset();
+}
+
+Filter* FilterChain::clone() const  {
+    return new FilterChain(*this);
+}
+
+Filter::FilterType FilterChain::getType() const {
+    return CHAIN;
+}
+
+FilterChain::~FilterChain() {
+    for (int i = 0; i < count; i++)
+        delete stages[i];
+}
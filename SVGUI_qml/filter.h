@@ -1,30 +1,83 @@
 #ifndef FILTER_H
 #define FILTER_H
 
-#include <QQueue>
+#include <QtGlobal>
 
+/*
+ * Stateful sample filters.
+ * Memory is allocated only when a filter is created, processing doesn't allocate.
+ * process(in, out, n) filters a block of samples with one virtual call,
+ * in and out may point to the same buffer.
+ */
 class Filter
 {
 public:
-    enum FilterType { NONE , KALMAN , GAF };
+    enum FilterType { NONE , KALMAN , GAF , KALMAN_CV , LOWPASS , MEDIAN , SAVGOL , CHAIN };
 
-    virtual double calculate(double prev, double current) = 0;
+    //new filter of the type with default parameters
+    static Filter* create(FilterType type);
+
+    virtual float process(float sample) = 0;
+    virtual void process(float const* in, float* out, int n) = 0;
+    virtual void reset() = 0;
+    virtual Filter* clone() const = 0;
+    //smoothing parameter 0..1, returns false if the filter has no such parameter
+    virtual bool setK(float K);
     virtual FilterType getType() const = 0;
     virtual ~Filter();
+};
+
+//last samples of the filter window, every sample is stored twice
+//so the whole window is contiguous in memory
+class FilterWindow
+{
+public:
+    static const int maxSize = 64;
 private:
-    static const FilterType type = NONE;
+    float data[2 * maxSize];
+    int length = 1;
+    int pos = 0;    //next write index
+    int count = 0;
+public:
+    explicit FilterWindow(int length = 1);
+    void setLength(int length);
+    int getLength() const;
+    int size() const;
+    bool isFull() const;
+    void clear();
+
+    //returns the evicted sample if the window was full
+    float push(float sample);
+    //oldest sample first
+    float const* samples() const;
 };
 
-class FilterKalman : public Filter //is simple Kalman a low-pass filter or they are different??
+//Kalman filter of the noisy measurements, one measurement per sample
+//SCALAR models the value as a random walk, CONSTANT_VELOCITY tracks the value and its rate
+class FilterKalman : public Filter
 {
+public:
+    enum Model { SCALAR, CONSTANT_VELOCITY };
 private:
-    float K;
-    static const FilterType type = KALMAN;
+    Model model;
+    double processNoise;
+    double measurementNoise;
+    float K = 0.5;
+    bool initialized = false;
+    double x0 = 0;      //value
+    double x1 = 0;      //rate, per sample
+    double p00 = 0, p01 = 0, p11 = 0;   //covariance
+
+    float step(float sample);
 public:
-    FilterKalman(float K = 0.5);
-    void setK(float K);
+    FilterKalman(Model model = SCALAR, double measurementNoise = 1.0, float K = 0.5);
+    bool setK(float K) override;
     float getK() const;
-    double calculate(double prev, double current) override;
+    void setNoise(double processNoise, double measurementNoise);
+    float process(float sample) override;
+    void process(float const* in, float* out, int n) override;
+    void reset() override;
+    Filter* clone() const override;
     FilterType getType() const override;
     ~FilterKalman() override;
 };
@@ -32,16 +85,114 @@ public:
 class FilterGA : public Filter //filter of gliding average :3
 {
 private:
-    int N;
-    QQueue<double> values;
-    static const FilterType type = GAF;
+    FilterWindow window;
+    double sum = 0;
+
+    float step(float sample);
 public:
     FilterGA(int N = 5);
     void setN(int N);
     int getN() const;
+    float process(float sample) override;
+    void process(float const* in, float* out, int n) override;
+    void reset() override;
+    Filter* clone() const override;
     FilterType getType() const override;
-    double calculate(double prev, double current) override;
     ~FilterGA() override;
 };
 
+//second order Butterworth low-pass (biquad, transposed direct form II)
+class FilterLowPass : public Filter
+{
+private:
+    double cutoff;  //fraction of the sample rate, 0..0.5
+    double q;
+    double b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+    double z1 = 0, z2 = 0;
+    bool initialized = false;
+
+    void updateCoefficients();
+    float step(float sample);
+public:
+    FilterLowPass(double cutoff = 0.05, double q = 0.7071);
+    void setCutoff(double cutoff);
+    double getCutoff() const;
+    bool setK(float K) override;
+    float process(float sample) override;
+    void process(float const* in, float* out, int n) override;
+    void reset() override;
+    Filter* clone() const override;
+    FilterType getType() const override;
+    ~FilterLowPass() override;
+};
+
+//median of the last N samples, removes spikes without smoothing the edges
+class FilterMedian : public Filter
+{
+private:
+    FilterWindow window;
+    float sorted[FilterWindow::maxSize];
+
+    float step(float sample);
+public:
+    FilterMedian(int N = 5);
+    void setN(int N);
+    int getN() const;
+    float process(float sample) override;
+    void process(float const* in, float* out, int n) override;
+    void reset() override;
+    Filter* clone() const override;
+    FilterType getType() const override;
+    ~FilterMedian() override;
+};
+
+//least squares polynomial fit over the last N samples evaluated at the newest one,
+//so the filter has no delay
+class FilterSavitzkyGolay : public Filter
+{
+public:
+    static const int maxOrder = 3;
+private:
+    FilterWindow window;
+    int order;
+    float coefficients[FilterWindow::maxSize];
+
+    void updateCoefficients();
+    float step(float sample);
+public:
+    FilterSavitzkyGolay(int N = 15, int order = 2);
+    void setWindow(int N, int order);
+    int getN() const;
+    int getOrder() const;
+    float process(float sample) override;
+    void process(float const* in, float* out, int n) override;
+    void reset() override;
+    Filter* clone() const override;
+    FilterType getType() const override;
+    ~FilterSavitzkyGolay() override;
+};
+
+//filters applied one after another, the chain owns its stages
+class FilterChain : public Filter
+{
+public:
+    static const int maxStages = 4;
+private:
+    Filter* stages[maxStages];
+    int count = 0;
+public:
+    FilterChain();
+    FilterChain(FilterChain const& chain);
+    FilterChain& operator=(FilterChain const&) = delete;
+    bool append(Filter *stage);
+    int size() const;
+    bool setK(float K) override;
+    float process(float sample) override;
+    void process(float const* in, float* out, int n) override;
+    void reset() override;
+    Filter* clone() const override;
+    FilterType getType() const override;
+    ~FilterChain() override;
+};
+
 #endif // FILTER_H
@@ -0,0 +1,124 @@
+#include "lodpyramid.h"
+
+LodPyramid::LodPyramid(int rawCapacity)    {
+    setCapacity(rawCapacity);
+}
+
+//every level keeps as much time as the raw storage of the series
+void LodPyramid::setCapacity(int rawCapacity)   {
+    levels.clear();
+    for (int k = 1; k <= maxLevels && (rawCapacity >> k) > 0; k++)    {
+        Level level;
+        level.buckets.setCapacity(rawCapacity >> k);
+        levels.append(level);
+    }
+}
+
+LodPyramid::Bucket LodPyramid::merge(Bucket const& a, Bucket const& b)  {
+    Bucket bucket;
+    bucket.tMin = qMin(a.tMin, b.tMin);
+    bucket.tMax = qMax(a.tMax, b.tMax);
+    if (a.min <= b.min) {
+        bucket.min = a.min;
+        bucket.tAtMin = a.tAtMin;
+    }   else    {
+        bucket.min = b.min;
+        bucket.tAtMin = b.tAtMin;
+    }
+    if (a.max >= b.max) {
+        bucket.max = a.max;
+        bucket.tAtMax = a.tAtMax;
+    }   else    {
+        bucket.max = b.max;
+        bucket.tAtMax = b.tAtMax;
+    }
+    return bucket;
+}
+
+//adds a completed child bucket to the level, completed buckets go up to the next level
+void LodPyramid::push(int level, Bucket const& bucket)  {
+    if (level >= levels.size())
+        return;
+
+    Level &current = levels[level];
+    current.partial = current.partialCount ? merge(current.partial, bucket) : bucket;
+    current.partialCount++;
+    if (current.partialCount == 2)  {
+        Bucket completed = current.partial;
+        current.partialCount = 0;
+        current.buckets.push(completed);
+        push(level + 1, completed);
+    }
+}
+
+void LodPyramid::append(float time, float value)    {
+    Bucket point;
+    point.tMin = point.tMax = point.tAtMin = point.tAtMax = time;
+    point.min = point.max = value;
+    push(0, point);
+}
+
+void LodPyramid::clear()    {
+    for (Level &level : levels) {
+        level.buckets.clear();
+        level.partialCount = 0;
+    }
+}
+
+int LodPyramid::levelCount() const  {
+    return levels.size();
+}
+
+//binary search for the first bucket ending at or after the time
+int LodPyramid::firstBucketAfter(RingBuffer<Bucket> const& buckets, float time) const  {
+    int low = 0;
+    int high = buckets.size();
+    while (low < high)  {
+        int middle = (low + high) / 2;
+        if (buckets.at(middle).tMax < time)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+void LodPyramid::emitBucket(Bucket const& bucket, QVector<QPointF> &out)    {
+    if (bucket.tAtMin <= bucket.tAtMax) {
+        out.append(QPointF(bucket.tAtMin, bucket.min));
+        out.append(QPointF(bucket.tAtMax, bucket.max));
+    }   else    {
+        out.append(QPointF(bucket.tAtMax, bucket.max));
+        out.append(QPointF(bucket.tAtMin, bucket.min));
+    }
+}
+
+void LodPyramid::decimate(int level, float t0, float t1, QVector<QPointF> &out) const   {
+    out.clear();
+    if (levels.isEmpty())
+        return;
+    int index = qBound(0, level - 1, levels.size() - 1);
+
+    RingBuffer<Bucket> const& buckets = levels.at(index).buckets;
+    float covered = t0;
+    for (int i = firstBucketAfter(buckets, t0); i < buckets.size() && buckets.at(i).tMin <= t1; i++)   {
+        emitBucket(buckets.at(i), out);
+        covered = buckets.at(i).tMax;
+    }
+
+    //newest points are not in a completed bucket of this level yet,
+    //every lower level has at most one completed bucket after them
+    for (int lower = index - 1; lower >= 0; lower--)    {
+        RingBuffer<Bucket> const& lowerBuckets = levels.at(lower).buckets;
+        for (int i = firstBucketAfter(lowerBuckets, covered); i < lowerBuckets.size(); i++)  {
+            Bucket const& bucket = lowerBuckets.at(i);
+            if (bucket.tMin <= covered || bucket.tMin > t1)
+                continue;
+            emitBucket(bucket, out);
+            covered = bucket.tMax;
+        }
+    }
+    Level const& first = levels.first();
+    if (first.partialCount && first.partial.tMin > covered && first.partial.tMin <= t1)
+        out.append(QPointF(first.partial.tMin, first.partial.min));
+}
@@ -0,0 +1,53 @@
+#ifndef LODPYRAMID_H
+#define LODPYRAMID_H
+
+#include <QVector>
+#include <QPointF>
+#include "ringbuffer.h"
+
+/*
+ * Multi-resolution min/max pyramid of a chart series.
+ * Level k keeps buckets of 2^k raw points with the minimum and maximum of each bucket,
+ * level 0 (raw points) is stored by the series itself. Buckets are built incrementally
+ * as points arrive, O(1) amortized per point.
+ */
+class LodPyramid
+{
+public:
+    struct Bucket   {
+        float tMin = 0;     //time range of the bucket
+        float tMax = 0;
+        float min = 0;
+        float max = 0;
+        float tAtMin = 0;
+        float tAtMax = 0;
+    };
+private:
+    static const int maxLevels = 16;
+
+    struct Level    {
+        RingBuffer<Bucket> buckets;
+        Bucket partial;
+        int partialCount = 0;   //children in the partial bucket
+    };
+
+    QVector<Level> levels;  //levels[0] is the pyramid level 1
+
+    static Bucket merge(Bucket const& a, Bucket const& b);
+    static void emitBucket(Bucket const& bucket, QVector<QPointF> &out);
+    int firstBucketAfter(RingBuffer<Bucket> const& buckets, float time) const;
+    void push(int level, Bucket const& bucket);
+public:
+    explicit LodPyramid(int rawCapacity = 0);
+
+    void setCapacity(int rawCapacity);
+    void append(float time, float value);
+    void clear();
+    int levelCount() const;
+
+    //min/max points of the level buckets inside [t0, t1], the not yet completed tail
+    //is taken from lower levels; two points per bucket, in time order
+    void decimate(int level, float t0, float t1, QVector<QPointF> &out) const;
+};
+
+#endif // LODPYRAMID_H
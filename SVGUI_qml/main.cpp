@@ -1,30 +1,18 @@
 #include <QApplication>
 #include <QQmlApplicationEngine>
+#include <QQuickWindow>
+#include <QCommandLineParser>
 #include <QDebug>
 #include <QQmlContext>
-#include "svclient.h"
-#include "adapter.h"
-
-//Init signals/slots connecions between network client and adapter objects
-void initConnections(SVClient *client, Adapter *adapter)  {
-    QObject::connect(adapter, SIGNAL(signalConnect(QString const&, quint16 const&)), client, SLOT(slotUIConnect(QString const&, quint16 const&)));
-    QObject::connect(adapter, SIGNAL(signalDisconnect()), client, SLOT(slotUIDisconnect()));
-    QObject::connect(adapter, SIGNAL(signalSearch()), client, SLOT(slotUISearch()));
-    QObject::connect(adapter, SIGNAL(signalSettingsLoad(SetPackage const&)), client, SLOT(slotUISettingsLoad(SetPackage const&)));
-    QObject::connect(adapter, SIGNAL(signalSettingsUpload()), client, SLOT(slotUISettingsUpload()));
-    QObject::connect(adapter, SIGNAL(signalControl(ControlPackage const&)), client, SLOT(slotUIControl(ControlPackage const&)));
-
-    QObject::connect(client, SIGNAL(signalUIAddresses(QList<QString> const&)), adapter, SLOT(slotAddresses(QList<QString> const&)));
-    QObject::connect(client, SIGNAL(signalUIConnected(qint8 const&)), adapter, SLOT(slotConnected(qint8 const&)));
-    QObject::connect(client, SIGNAL(signalUIDisconnected()), adapter, SLOT(slotDisconnected()));
-    QObject::connect(client, SIGNAL(signalUIError(QString)), adapter, SLOT(slotConnectionError(QString)));
-    QObject::connect(client, SIGNAL(signalUIData(LowFreqDataPackage const&)), adapter, SLOT(slotData(LowFreqDataPackage const&)));
-    QObject::connect(client, SIGNAL(signalUIData(HighFreqDataPackage const&)), adapter, SLOT(slotData(HighFreqDataPackage const&)));
-    QObject::connect(client, SIGNAL(signalUIDone(qint8 const&)), adapter, SLOT(slotDone(qint8 const&)));
-    QObject::connect(client, SIGNAL(signalUISettings(SetPackage const&)), adapter, SLOT(slotSettings(SetPackage const&)));
-    QObject::connect(client, SIGNAL(signalUIMap(MapPackage const&)), adapter, SLOT(slotMap(MapPackage const&)));
-    QObject::connect(client, SIGNAL(signalUIBrokenPackage()), adapter, SLOT(slotBrokenPackage()));
-}
+#include <QtQml>
+#include "sessionmanager.h"
+#include "svchartitem.h"
+#include "svmapitem.h"
+#include "svtrace.h"
+#include "svmetrics.h"
+
+//start of the render pass, set and read on the render thread only
+static qint64 renderStart = 0;
 
 int main(int argc, char *argv[])
 {
@@ -32,19 +20,46 @@ int main(int argc, char *argv[])
     QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
     QApplication guiApp(argc, argv);
 
-    SVClient *client = new SVClient();
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption metricsOption("metrics-port", "Serve Prometheus metrics on the local port.", "port", "0");
+    parser.addOption(metricsOption);
+    parser.process(guiApp);
 
-    Adapter *adapter = new Adapter();
+    SVMetricsServer metricsServer;
+    quint16 metricsPort = static_cast<quint16>(parser.value(metricsOption).toUInt());
+    if (metricsPort)
+        metricsServer.start(QHostAddress::LocalHost, metricsPort);
 
-    initConnections(client, adapter);
+    //network clients of all the vehicles share one I/O thread
+    SessionManager *sessions = new SessionManager(&guiApp);
+    sessions->slotUIAddSession();
 
     qDebug() << "User interface initializing...";
+    qmlRegisterType<SVChartItem>("SmartVehicle", 1, 0, "SVChart");
+    qmlRegisterType<SVMapItem>("SmartVehicle", 1, 0, "SVMap");
     QQmlApplicationEngine engine;
-    engine.rootContext()->setContextProperty("adapter", adapter);
+    engine.rootContext()->setContextProperty("sessions", sessions);
+    engine.rootContext()->setContextProperty("adapter", sessions->currentAdapter());
+    //QML is always bound to the adapter of the current vehicle
+    QObject::connect(sessions, &SessionManager::signalCurrentChanged, [&engine](Adapter *adapter) {
+        engine.rootContext()->setContextProperty("adapter", adapter);
+    });
     engine.load(QUrl(QStringLiteral("qrc:/main.qml")));
     if (engine.rootObjects().isEmpty())
         return -1;
 
+    //render passes of the scene graph go to the trace of the render thread
+    if (QQuickWindow *window = qobject_cast<QQuickWindow*>(engine.rootObjects().first()))  {
+        QObject::connect(window, &QQuickWindow::beforeRendering, window, [] {
+            renderStart = SVTrace::isEnabled() ? SVTrace::now() : 0;
+        }, Qt::DirectConnection);
+        QObject::connect(window, &QQuickWindow::afterRendering, window, [] {
+            if (renderStart)
+                SVTrace::record("QQuickWindow render", renderStart, SVTrace::now());
+        }, Qt::DirectConnection);
+    }
+
     qDebug() << "Done. User interface is ready.";
 
     qDebug() << "Done. Aplication has been initialized and ready to work.";
@@ -59,22 +59,32 @@ ApplicationWindow {
                                  forward_p, forward_i, forward_d, forward_int,
                                  backward_p, backward_i, backward_d, backward_int);
         }
-        onSignalUIUpdateHighFreqData:   {
-            content_item.encoderSet(encValue);
-            content_item.potentiometerSet(potValue);
-            content_item.speedSet(speedValue);
-        }
-        onSignalUIUpdateLowFreqData:   {
-            content_item.batterySet(1, firstBatteryValue);
-            content_item.batterySet(2, secondBatteryValue);
-            content_item.tempSet(temp);
-        }
         onSignalUIMap:  {
-            map_item.setMap(w, h, cellList);
+            map_item.setMap(w, h);
         }
         onSignalUIUpdatePosition: {
             map_item.setPos(x, y, angle);
         }
+        onSignalUIExporting:    {
+            content_item.exportingSet(exporting);
+        }
+        onSignalUIHistoryApproximate:   {
+            content_item.historyApproximateSet(approximate);
+        }
+        onSignalUIStats:    {
+            content_item.statsSet(rows);
+        }
+        onSignalUIDerived:  {
+            content_item.derivedSet(names, current);
+        }
+    }
+
+    Connections {
+        target: sessions
+        onSignalCurrentChanged: {
+            console.log("Vehicle switched.");
+            adapter.slotUIRefresh();
+        }
     }
 
     footer: Rectangle {
@@ -93,6 +103,47 @@ ApplicationWindow {
             anchors.margins: 2
             anchors.leftMargin: 10
         }
+        Row {
+            id: statusBar_sessions
+            anchors.right: parent.right
+            anchors.top: parent.top
+            anchors.bottom: parent.bottom
+            anchors.rightMargin: 10
+            spacing: 5
+            Label   {
+                text: qsTr("Vehicle:")
+                anchors.verticalCenter: parent.verticalCenter
+            }
+            ComboBox    {
+                id: statusBar_sessions_comboBox
+                height: parent.height
+                model: sessions.count
+                displayText: qsTr("Vehicle ") + (currentIndex + 1)
+                delegate: ItemDelegate  {
+                    width: statusBar_sessions_comboBox.width
+                    text: qsTr("Vehicle ") + (index + 1)
+                }
+                currentIndex: sessions.currentIndex
+                onActivated: {
+                    sessions.currentIndex = index;
+                }
+            }
+            Button  {
+                height: parent.height
+                text: "+"
+                onClicked: {
+                    sessions.currentIndex = sessions.slotUIAddSession();
+                }
+            }
+            Button  {
+                height: parent.height
+                text: "-"
+                enabled: sessions.count > 1
+                onClicked: {
+                    sessions.slotUIRemoveSession(sessions.currentIndex);
+                }
+            }
+        }
     }
 
     SwipeView   {
@@ -134,8 +185,9 @@ ApplicationWindow {
     }
     Component.onCompleted: {
         console.log("Ready.");
-        adapter.slotUISetSerieses(content_item.speedSeries, content_item.speedSeriesFilter, content_item.steeringSeries,
-                                  content_item.tempSeries, content_item.tempSeriesFilter);
+        sessions.slotUISetSerieses(content_item.speedSeries, content_item.speedSeriesFilter, content_item.steeringSeries,
+                                   content_item.tempSeries, content_item.tempSeriesFilter, content_item.derivedSeries);
+        sessions.slotUISetMap(map_item.mapView);
     }
 }
 
@@ -0,0 +1,98 @@
+#include "refilter.h"
+
+namespace   {
+
+struct RefilterTask {
+    typedef RefilterChunk result_type;
+
+    QSharedPointer<Filter const> prototype;
+    QVector<float> raw;
+    int warmUp = 0;
+
+    RefilterChunk operator()(RefilterChunk chunk) const {
+        Filter *filter = prototype->clone();
+        filter->reset();
+
+        int start = qMax(0, chunk.begin - warmUp);
+        if (start < chunk.begin)    {
+            QVector<float> discarded(chunk.begin - start);
+            filter->process(raw.constData() + start, discarded.data(), discarded.size());
+        }
+        chunk.values.resize(chunk.end - chunk.begin);
+        filter->process(raw.constData() + chunk.begin, chunk.values.data(), chunk.values.size());
+
+        if (chunk.end == raw.size())
+            chunk.state = QSharedPointer<Filter>(filter);
+        else
+            delete filter;
+        return chunk;
+    }
+};
+
+}
+
+Refilter::Refilter()    {}
+
+Refilter::~Refilter()   {
+    cancel();
+}
+
+void Refilter::start(Filter const* filter, QVector<float> const& raw, qint64 end)  {
+    cancel();
+    if (filter == nullptr)
+        return;
+
+    QVector<RefilterChunk> chunks;
+    for (int begin = 0; begin < raw.size(); begin += chunkSize)  {
+        RefilterChunk chunk;
+        chunk.begin = begin;
+        chunk.end = qMin(raw.size(), begin + chunkSize);
+        chunks.append(chunk);
+    }
+    if (chunks.isEmpty())
+        return;
+
+    RefilterTask task;
+    task.prototype = QSharedPointer<Filter const>(filter->clone());
+    task.raw = raw;
+    task.warmUp = warmUp;
+    future = QtConcurrent::mapped(chunks, task);
+    snapshotEnd = end;
+    running = true;
+}
+
+//drops the running job without waiting, chunks which are not started yet are skipped
+//the job owns its data, so running chunks finish on their own
+void Refilter::cancel() {
+    if (!running)
+        return;
+    future.cancel();
+    future = QFuture<RefilterChunk>();
+    running = false;
+}
+
+bool Refilter::isRunning() const    {
+    return running;
+}
+
+bool Refilter::isReady() const  {
+    return running && future.isFinished();
+}
+
+Filter* Refilter::take(QVector<float> &filtered, qint64 &end)  {
+    if (!isReady())
+        return nullptr;
+    running = false;
+
+    QList<RefilterChunk> chunks = future.results();
+    future = QFuture<RefilterChunk>();
+    if (chunks.isEmpty() || chunks.last().state.isNull())
+        return nullptr;
+
+    filtered.clear();
+    filtered.reserve(chunks.last().end);
+    for (RefilterChunk const& chunk : chunks)
+        filtered += chunk.values;
+    end = snapshotEnd;
+    return chunks.last().state->clone();
+}
@@ -0,0 +1,47 @@
+#ifndef REFILTER_H
+#define REFILTER_H
+
+#include <QVector>
+#include <QSharedPointer>
+#include <QFuture>
+#include <QtConcurrent>
+#include "filter.h"
+
+//part of the history filtered by one worker
+struct RefilterChunk    {
+    int begin = 0;
+    int end = 0;
+    QVector<float> values;
+    QSharedPointer<Filter> state;   //filter after the last sample, only for the last chunk
+};
+
+/*
+ * Filters a snapshot of raw samples by a new filter in the thread pool.
+ * The snapshot is split into chunks filtered in parallel, every chunk starts
+ * warmUp samples earlier so the filter state settles before the chunk begins
+ * (filters with a finite window are exact, Kalman and low-pass converge).
+ * The result is taken as a whole when all chunks are done.
+ */
+class Refilter
+{
+private:
+    static const int chunkSize = 16384;
+    static const int warmUp = 1024;
+
+    QFuture<RefilterChunk> future;
+    qint64 snapshotEnd = 0;
+    bool running = false;
+public:
+    Refilter();
+    ~Refilter();
+
+    //end: index of the sample after the snapshot, in the caller's numbering
+    void start(Filter const* filter, QVector<float> const& raw, qint64 end);
+    void cancel();
+    bool isRunning() const;
+    bool isReady() const;
+    //returns the filter with the state after the last snapshot sample, the caller owns it
+    Filter* take(QVector<float> &filtered, qint64 &end);
+};
+
+#endif // REFILTER_H
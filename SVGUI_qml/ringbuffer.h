@@ -0,0 +1,94 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <QVector>
+
+/*
+ * Fixed-capacity FIFO storage.
+ * Memory is allocated once by setCapacity(), pushing into the full buffer
+ * overwrites the oldest element. Index 0 is the oldest element.
+ */
+template <typename T>
+class RingBuffer
+{
+private:
+    QVector<T> buffer;
+    int head = 0;   //index of the oldest element
+    int count = 0;
+public:
+    explicit RingBuffer(int capacity = 0)   {
+        setCapacity(capacity);
+    }
+
+    //reallocates the storage, the newest elements are kept
+    void setCapacity(int capacity)  {
+        QVector<T> newBuffer(capacity);
+        int kept = qMin(count, capacity);
+        for (int i = 0; i < kept; i++)
+            newBuffer[i] = at(count - kept + i);
+        buffer.swap(newBuffer);
+        head = 0;
+        count = kept;
+    }
+
+    int capacity() const    {
+        return buffer.size();
+    }
+
+    int size() const    {
+        return count;
+    }
+
+    bool isEmpty() const    {
+        return count == 0;
+    }
+
+    bool isFull() const {
+        return count == buffer.size();
+    }
+
+    //returns true if the oldest element has been overwritten
+    bool push(T const& value)   {
+        if (buffer.isEmpty())
+            return false;
+        if (isFull())   {
+            buffer[head] = value;
+            head = (head + 1) % buffer.size();
+            return true;
+        }
+        buffer[(head + count) % buffer.size()] = value;
+        count++;
+        return false;
+    }
+
+    void popFront(int n = 1)    {
+        n = qMin(n, count);
+        if (n <= 0)
+            return;
+        head = (head + n) % buffer.size();
+        count -= n;
+    }
+
+    T const& at(int i) const    {
+        return buffer.at((head + i) % buffer.size());
+    }
+
+    T& operator[](int i)    {
+        return buffer[(head + i) % buffer.size()];
+    }
+
+    T const& first() const  {
+        return at(0);
+    }
+
+    T const& last() const   {
+        return at(count - 1);
+    }
+
+    void clear()    {
+        head = 0;
+        count = 0;
+    }
+};
+
+#endif // RINGBUFFER_H
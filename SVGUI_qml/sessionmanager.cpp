@@ -0,0 +1,227 @@
+#include "sessionmanager.h"
+#include <QStandardPaths>
+#include <QDateTime>
+#include <QDir>
+#include "svtrace.h"
+
+SessionManager::SessionManager(QObject *parent) : QObject(parent)    {
+    qDebug() << "Session manager initializing...";
+
+    //packages are passing between I/O and GUI threads by queued connections
+    qRegisterMetaType<qint8>("qint8");
+    qRegisterMetaType<quint16>("quint16");
+    qRegisterMetaType<QList<QString>>("QList<QString>");
+    qRegisterMetaType<SetPackage>("SetPackage");
+    qRegisterMetaType<ControlPackage>("ControlPackage");
+    qRegisterMetaType<GoalPackage>("GoalPackage");
+    qRegisterMetaType<HighFreqDataPackage>("HighFreqDataPackage");
+    qRegisterMetaType<TelemetryColumns>("TelemetryColumns");
+    qRegisterMetaType<LowFreqDataPackage>("LowFreqDataPackage");
+    qRegisterMetaType<MapPackage>("MapPackage");
+
+    ioThread.setObjectName("SVClient I/O");
+    ioThread.start();
+
+    //how long events wait in the loops of the GUI and the I/O threads
+    guiLag = new SVLoopLag("svgui_event_loop_lag_seconds", SVMetrics::label("thread", "gui"), this);
+    guiLag->slotStart();
+    ioLag = new SVLoopLag("svgui_event_loop_lag_seconds", SVMetrics::label("thread", "io"));
+    ioLag->moveToThread(&ioThread);
+    connect(&ioThread, &QThread::finished, ioLag, &QObject::deleteLater);
+    QMetaObject::invokeMethod(ioLag, "slotStart", Qt::QueuedConnection);
+
+    frameTimer.setTimerType(Qt::PreciseTimer);
+    frameTimer.start(frameInterval);
+
+    qDebug() << "Done. Session manager is ready.";
+}
+
+SessionManager::~SessionManager()   {
+    //clients are deleted by the I/O thread on its finish
+    ioThread.quit();
+    ioThread.wait();
+
+    for (Session const& session : sessions)
+        delete session.adapter;
+}
+
+//Init signals/slots connecions between network client and adapter objects
+void SessionManager::initConnections(SVClient *client, Adapter *adapter)  {
+    QObject::connect(adapter, SIGNAL(signalConnect(QString const&, quint16 const&)), client, SLOT(slotUIConnect(QString const&, quint16 const&)));
+    QObject::connect(adapter, SIGNAL(signalDisconnect()), client, SLOT(slotUIDisconnect()));
+    QObject::connect(adapter, SIGNAL(signalSearch()), client, SLOT(slotUISearch()));
+    QObject::connect(adapter, SIGNAL(signalSettingsLoad(SetPackage const&)), client, SLOT(slotUISettingsLoad(SetPackage const&)));
+    QObject::connect(adapter, SIGNAL(signalSettingsUpload()), client, SLOT(slotUISettingsUpload()));
+    QObject::connect(adapter, SIGNAL(signalControl(ControlPackage const&)), client, SLOT(slotUIControl(ControlPackage const&)));
+    QObject::connect(adapter, SIGNAL(signalGoal(GoalPackage const&)), client, SLOT(slotUIGoal(GoalPackage const&)));
+
+    QObject::connect(client, SIGNAL(signalUIAddresses(QList<QString> const&)), adapter, SLOT(slotAddresses(QList<QString> const&)));
+    QObject::connect(client, SIGNAL(signalUIConnected(qint8 const&)), adapter, SLOT(slotConnected(qint8 const&)));
+    QObject::connect(client, SIGNAL(signalUIDisconnected()), adapter, SLOT(slotDisconnected()));
+    QObject::connect(client, SIGNAL(signalUIError(QString)), adapter, SLOT(slotConnectionError(QString)));
+    QObject::connect(client, SIGNAL(signalUIData(LowFreqDataPackage const&)), adapter, SLOT(slotData(LowFreqDataPackage const&)));
+    QObject::connect(client, SIGNAL(signalUIData(HighFreqDataPackage const&)), adapter, SLOT(slotData(HighFreqDataPackage const&)));
+    QObject::connect(client, SIGNAL(signalUIDataBatch(TelemetryColumns const&)), adapter, SLOT(slotDataBatch(TelemetryColumns const&)));
+    QObject::connect(client, SIGNAL(signalUIDone(qint8 const&)), adapter, SLOT(slotDone(qint8 const&)));
+    QObject::connect(client, SIGNAL(signalUISettings(SetPackage const&)), adapter, SLOT(slotSettings(SetPackage const&)));
+    QObject::connect(client, SIGNAL(signalUIMap(MapPackage const&)), adapter, SLOT(slotMap(MapPackage const&)));
+    QObject::connect(client, SIGNAL(signalUIBrokenPackage()), adapter, SLOT(slotBrokenPackage()));
+}
+
+int SessionManager::count() const   {
+    return sessions.size();
+}
+
+int SessionManager::currentIndex() const    {
+    return current;
+}
+
+Adapter* SessionManager::currentAdapter() const {
+    if (current < 0 || current >= sessions.size())
+        return nullptr;
+    return sessions.at(current).adapter;
+}
+
+//lives in the I/O thread
+SVClient* SessionManager::currentClient() const {
+    if (current < 0 || current >= sessions.size())
+        return nullptr;
+    return sessions.at(current).client;
+}
+
+//switches the QML scene to another vehicle
+//chart serieses are detached from the previous adapter and filled by the new one
+void SessionManager::setCurrentIndex(int index) {
+    if (index < 0 || index >= sessions.size() || index == current)
+        return;
+
+    if (Adapter *previous = currentAdapter())
+        previous->detachSerieses();
+
+    current = index;
+    Adapter *adapter = currentAdapter();
+    if (speedSeries)
+        adapter->slotUISetSerieses(speedSeries, speedSeriesFilter, steeringSeries, tempSeries, tempSeriesFilter,
+                                   derivedSeries);
+    if (mapItem)
+        adapter->slotUISetMap(mapItem);
+
+    qDebug() << "Current vehicle session: " << current;
+    emit signalCurrentIndexChanged();
+    emit signalCurrentChanged(adapter);
+}
+
+//creates a new vehicle session and returns its index
+int SessionManager::slotUIAddSession()  {
+    Session session;
+    session.client = new SVClient();
+    session.client->slotUISetRates(highFreqRate, lowFreqRate);
+    session.client->moveToThread(&ioThread);
+    connect(&ioThread, &QThread::finished, session.client, &QObject::deleteLater);
+
+    session.adapter = new Adapter();
+    initConnections(session.client, session.adapter);
+    session.adapter->setUpdateInterval(updateInterval);
+    connect(&frameTimer, SIGNAL(timeout()), session.adapter, SLOT(slotFrame()));
+
+    sessions.append(session);
+    qDebug() << "Vehicle session added: " << sessions.size() - 1;
+    emit signalCountChanged();
+
+    if (current < 0)
+        setCurrentIndex(0);
+
+    return sessions.size() - 1;
+}
+
+//closes the vehicle session, the last session is always kept
+void SessionManager::slotUIRemoveSession(int index)   {
+    if (index < 0 || index >= sessions.size() || sessions.size() == 1)
+        return;
+
+    Session session = sessions.at(index);
+    if (index == current)   {
+        session.adapter->detachSerieses();
+        current = -1;
+    }   else if (index < current)   {
+        current--;
+    }
+    sessions.remove(index);
+
+    //the client is closed in its own thread
+    session.client->deleteLater();
+    session.adapter->deleteLater();
+
+    qDebug() << "Vehicle session removed: " << index;
+    emit signalCountChanged();
+
+    if (current < 0)
+        setCurrentIndex(qMin(index, sessions.size() - 1));
+    else
+        emit signalCurrentIndexChanged();
+}
+
+//gets a QLineSeries* from QML context and passes them to the current adapter
+void SessionManager::slotUISetSerieses(QObject *speedSeries, QObject* speedSeriesFilter, QObject *steeringSeries,
+                                       QObject *tempSeries, QObject* tempSeriesFilter, QObject *derivedSeries)  {
+    this->speedSeries = speedSeries;
+    this->speedSeriesFilter = speedSeriesFilter;
+    this->steeringSeries = steeringSeries;
+    this->tempSeries = tempSeries;
+    this->tempSeriesFilter = tempSeriesFilter;
+    this->derivedSeries = derivedSeries;
+
+    if (Adapter *adapter = currentAdapter())
+        adapter->slotUISetSerieses(speedSeries, speedSeriesFilter, steeringSeries, tempSeries, tempSeriesFilter,
+                                   derivedSeries);
+}
+
+//gets the map view from QML context and passes it to the current adapter
+void SessionManager::slotUISetMap(QObject *mapItem) {
+    this->mapItem = mapItem;
+    if (Adapter *adapter = currentAdapter())
+        adapter->slotUISetMap(mapItem);
+}
+
+//sets how many times per second the values list and the map are updated,
+//the rate is limited by the frame rate
+void SessionManager::slotUISetUpdateRate(int rate)  {
+    if (rate <= 0)
+        return;
+    updateInterval = 1000 / rate;
+    if (updateInterval <= frameInterval)
+        updateInterval = 0;
+    for (Session const& session : sessions)
+        session.adapter->setUpdateInterval(updateInterval);
+    qDebug() << "UI update interval: " << updateInterval << " msec";
+}
+
+void SessionManager::slotUISetTelemetryRates(int highFreqRate, int lowFreqRate) {
+    this->highFreqRate = static_cast<quint16>(qBound(0, highFreqRate, 65535));
+    this->lowFreqRate = static_cast<quint16>(qBound(0, lowFreqRate, 65535));
+    //clients live in the I/O thread
+    for (Session const& session : sessions)
+        QMetaObject::invokeMethod(session.client, "slotUISetRates", Qt::QueuedConnection,
+                                  Q_ARG(quint16, this->highFreqRate), Q_ARG(quint16, this->lowFreqRate));
+    qDebug() << "Telemetry rates: " << this->highFreqRate << " / " << this->lowFreqRate << " per second";
+}
+
+void SessionManager::slotUITraceStart() {
+    SVTrace::clear();
+    SVTrace::setEnabled(true);
+    qDebug() << "Tracing started";
+}
+
+QString SessionManager::slotUITraceStop()   {
+    SVTrace::setEnabled(false);
+    QString directory = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
+    QString fileName = QDir(directory).filePath("smart_vehicle_trace_" +
+                                                QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + ".json");
+    if (!SVTrace::dump(fileName))
+        return QString();
+    return fileName;
+}
+
+QString SessionManager::slotUIMetrics() const   {
+    return SVMetrics::global().toText();
+}
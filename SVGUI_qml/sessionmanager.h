@@ -0,0 +1,84 @@
+#ifndef SESSIONMANAGER_H
+#define SESSIONMANAGER_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include <QDebug>
+#include "svclient.h"
+#include "adapter.h"
+#include "svmetrics.h"
+
+/*
+ * Holds all vehicle sessions of the GUI process.
+ * Every session is a pair of network client and adapter. All the clients are
+ * multiplexed on one shared I/O thread, the adapters (telemetry models) live in
+ * the GUI thread. Only the current adapter is shown in the single QML scene.
+ */
+class SessionManager : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY signalCountChanged)
+    Q_PROPERTY(int currentIndex READ currentIndex WRITE setCurrentIndex NOTIFY signalCurrentIndexChanged)
+private:
+    struct Session  {
+        SVClient *client = nullptr;
+        Adapter *adapter = nullptr;
+    };
+
+    static const int frameInterval = 16; //msec, ~60 fps
+
+    QThread ioThread;
+    QTimer frameTimer;  //shared render loop of all the sessions
+    int updateInterval = 0; //msec, values and position updates of the adapters
+    quint16 highFreqRate = 0;   //telemetry rates asked by the clients, 0 - the server's
+    quint16 lowFreqRate = 0;
+    QVector<Session> sessions;
+    int current = -1;
+    SVLoopLag *guiLag;
+    SVLoopLag *ioLag;
+
+    //chart serieses from QML, attached to the current adapter only
+    QObject *speedSeries = nullptr;
+    QObject *speedSeriesFilter = nullptr;
+    QObject *steeringSeries = nullptr;
+    QObject *tempSeries = nullptr;
+    QObject *tempSeriesFilter = nullptr;
+    QObject *derivedSeries = nullptr;
+    QObject *mapItem = nullptr;
+
+    void initConnections(SVClient *client, Adapter *adapter);
+public:
+    explicit SessionManager(QObject *parent = nullptr);
+    ~SessionManager();
+
+    int count() const;
+    int currentIndex() const;
+    void setCurrentIndex(int index);
+    Adapter* currentAdapter() const;
+    SVClient* currentClient() const;
+
+public slots:
+    //slots UI -> session manager
+    int slotUIAddSession();
+    void slotUIRemoveSession(int index);
+    void slotUISetSerieses(QObject *speedSeries, QObject* speedSeriesFilter,
+                           QObject *steeringSeries, QObject *tempSeries, QObject *tempSeriesFilter,
+                           QObject *derivedSeries);
+    void slotUISetMap(QObject *mapItem);
+    void slotUISetUpdateRate(int rate);
+    //packages per second asked from the vehicles in the next handshakes, 0 - any
+    void slotUISetTelemetryRates(int highFreqRate, int lowFreqRate);
+    //pipeline tracing, the trace is written to Documents, returns its path
+    void slotUITraceStart();
+    QString slotUITraceStop();
+    //current values of all the metrics of the process, for the metrics panel
+    QString slotUIMetrics() const;
+signals:
+    void signalCountChanged();
+    void signalCurrentIndexChanged();
+    void signalCurrentChanged(Adapter *adapter);
+};
+
+#endif // SESSIONMANAGER_H
@@ -0,0 +1,200 @@
+#include "svchartitem.h"
+#include "svtrace.h"
+
+SVChartItem::SVChartItem(QQuickItem *parent) : QQuickItem(parent)   {
+    setFlag(QQuickItem::ItemHasContents);
+    setClip(true);
+}
+
+namespace   {
+
+//indices of the chart count the removed points before the source points
+class ChartPoints : public SVLinePoints
+{
+private:
+    SVLinePoints const* source;
+    int first;
+    int shown;
+public:
+    ChartPoints(SVLinePoints const* source, int first, int shown) :
+        source(source), first(first), shown(source ? qMin(shown, source->size()) : 0)   {}
+
+    int size() const override   {
+        return first + shown;
+    }
+
+    QPointF at(int index) const override    {
+        return source->at(index - first);
+    }
+};
+
+}
+
+//maps data coordinates into the item coordinates
+QMatrix4x4 SVChartItem::dataTransform() const   {
+    QMatrix4x4 matrix;
+    qreal xRange = xMax() - xMin();
+    qreal yRange = yMax() - yMin();
+    if (xRange <= 0 || yRange <= 0)
+        return matrix;
+
+    matrix.translate(0, static_cast<float>(height()));
+    matrix.scale(static_cast<float>(width() / xRange), static_cast<float>(-height() / yRange));
+    matrix.translate(static_cast<float>(-xMin()), static_cast<float>(-yMin()));
+    return matrix;
+}
+
+void SVChartItem::setPointSource(SVLinePoints const* source)    {
+    this->source = source;
+    replace(0);
+}
+
+SVLinePoints const* SVChartItem::pointSource() const {
+    return source;
+}
+
+void SVChartItem::replace(int count)    {
+    shown = qMax(count, 0);
+    first = 0;
+    synced = 0;
+    rebuild = true;
+    update();
+}
+
+void SVChartItem::append(int count) {
+    if (count <= 0)
+        return;
+    shown += count;
+    update();
+}
+
+//removing from the front is incremental, the node hides the removed segments
+void SVChartItem::removeFront(int count)    {
+    count = qMin(count, shown);
+    if (count <= 0)
+        return;
+    first += count;
+    shown -= count;
+    update();
+}
+
+int SVChartItem::count() const  {
+    return shown;
+}
+
+void SVChartItem::clear()   {
+    replace(0);
+}
+
+void SVChartItem::setXRange(qreal min, qreal max)   {
+    if (qFuzzyCompare(_xMin, min) && qFuzzyCompare(_xMax, max))
+        return;
+    _xMin = min;
+    _xMax = max;
+    emit signalRangeChanged();
+    update();
+}
+
+void SVChartItem::setYRange(qreal min, qreal max)   {
+    if (qFuzzyCompare(_yMin, min) && qFuzzyCompare(_yMax, max))
+        return;
+    _yMin = min;
+    _yMax = max;
+    emit signalRangeChanged();
+    update();
+}
+
+qreal SVChartItem::xMin() const {
+    return source ? source->xMin() : _xMin;
+}
+
+qreal SVChartItem::xMax() const {
+    return source ? source->xMax() : _xMax;
+}
+
+qreal SVChartItem::yMin() const {
+    return source ? source->yMin() : _yMin;
+}
+
+qreal SVChartItem::yMax() const {
+    return source ? source->yMax() : _yMax;
+}
+
+void SVChartItem::setXMin(qreal value)  {
+    setXRange(value, _xMax);
+}
+
+void SVChartItem::setXMax(qreal value)  {
+    setXRange(_xMin, value);
+}
+
+void SVChartItem::setYMin(qreal value)  {
+    setYRange(value, _yMax);
+}
+
+void SVChartItem::setYMax(qreal value)  {
+    setYRange(_yMin, value);
+}
+
+QColor SVChartItem::color() const   {
+    return _color;
+}
+
+void SVChartItem::setColor(QColor const& color) {
+    if (_color == color)
+        return;
+    _color = color;
+    emit signalColorChanged();
+    update();
+}
+
+SVChartItem* SVChartItem::rangeSource() const   {
+    return source;
+}
+
+void SVChartItem::setRangeSource(SVChartItem *source)   {
+    if (this->source == source)
+        return;
+    if (this->source)
+        disconnect(this->source, SIGNAL(signalRangeChanged()), this, SIGNAL(signalRangeChanged()));
+    this->source = source;
+    if (source)
+        connect(source, SIGNAL(signalRangeChanged()), this, SIGNAL(signalRangeChanged()));
+    connect(this, SIGNAL(signalRangeChanged()), this, SLOT(update()), Qt::UniqueConnection);
+    emit signalRangeSourceChanged();
+    emit signalRangeChanged();
+}
+
+//called on the render thread while the GUI thread is blocked
+QSGNode* SVChartItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)  {
+    SV_TRACE("SVChartItem::updatePaintNode");
+    Q_UNUSED(data)
+
+    if (oldNode == nullptr) {
+        lineNode = SVLineNode::create(window());
+        rebuild = true;
+    }
+
+    //the source is read here, the GUI thread doesn't change it during the sync
+    ChartPoints points(source, first, shown);
+    //appending starts from the last uploaded point, it must be still in the source
+    if (rebuild || synced <= first) {
+        lineNode->setLine(points, first);
+        rebuild = false;
+    }   else if (synced < points.size())    {
+        if (!lineNode->appendLine(points, synced))
+            lineNode->setLine(points, first);
+    }
+    lineNode->removeFront(first);
+    synced = points.size();
+
+    lineNode->setColor(_color);
+    lineNode->setDataTransform(dataTransform());
+    lineNode->setSize(QSizeF(width(), height()));
+    return lineNode->node();
+}
+
+void SVChartItem::geometryChanged(QRectF const& newGeometry, QRectF const& oldGeometry)  {
+    QQuickItem::geometryChanged(newGeometry, oldGeometry);
+    update();
+}
@@ -0,0 +1,82 @@
+#ifndef SVCHARTITEM_H
+#define SVCHARTITEM_H
+
+#include <QQuickItem>
+#include <QVector>
+#include <QList>
+#include <QPointF>
+#include <QColor>
+#include "svlinenode.h"
+
+/*
+ * Line chart item rendered by the Qt Quick scene graph.
+ * The item keeps no points: they are read from the source (the storage of SVSeries)
+ * into the vertex buffer of the scene graph node while the GUI thread is blocked.
+ * Appended points are uploaded incrementally, scrolling and rescaling change only the node matrix.
+ * Feeding API follows QLineSeries, but only counts of the replaced, appended and removed points are passed.
+ */
+class SVChartItem : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(qreal xMin READ xMin WRITE setXMin NOTIFY signalRangeChanged)
+    Q_PROPERTY(qreal xMax READ xMax WRITE setXMax NOTIFY signalRangeChanged)
+    Q_PROPERTY(qreal yMin READ yMin WRITE setYMin NOTIFY signalRangeChanged)
+    Q_PROPERTY(qreal yMax READ yMax WRITE setYMax NOTIFY signalRangeChanged)
+    Q_PROPERTY(QColor color READ color WRITE setColor NOTIFY signalColorChanged)
+    //chart to share axes ranges with, e.g. filtered line over the raw one
+    Q_PROPERTY(SVChartItem* rangeSource READ rangeSource WRITE setRangeSource NOTIFY signalRangeSourceChanged)
+private:
+    SVLinePoints const* source = nullptr;   //shown points, index 0 is the first not removed point
+    int shown = 0;          //points of the source shown
+    int first = 0;          //removed points since the last replace
+    int synced = 0;         //points uploaded into the node
+    bool rebuild = true;
+    SVLineNode *lineNode = nullptr;
+
+    qreal _xMin = 0;
+    qreal _xMax = 60;
+    qreal _yMin = -10;
+    qreal _yMax = 10;
+    QColor _color = QColor("#4fc622");
+    SVChartItem *source = nullptr;
+
+    QMatrix4x4 dataTransform() const;
+public:
+    explicit SVChartItem(QQuickItem *parent = nullptr);
+
+    //the source must outlive the item or be replaced before it is destroyed
+    void setPointSource(SVLinePoints const* source);
+    SVLinePoints const* pointSource() const;
+    //the source has been changed, it has count points now
+    void replace(int count);
+    //count points have been appended to the source
+    void append(int count);
+    //count points have been removed from the source front
+    void removeFront(int count);
+    int count() const;
+    void clear();
+    void setXRange(qreal min, qreal max);
+    void setYRange(qreal min, qreal max);
+
+    qreal xMin() const;
+    qreal xMax() const;
+    qreal yMin() const;
+    qreal yMax() const;
+    void setXMin(qreal value);
+    void setXMax(qreal value);
+    void setYMin(qreal value);
+    void setYMax(qreal value);
+    QColor color() const;
+    void setColor(QColor const& color);
+    SVChartItem* rangeSource() const;
+    void setRangeSource(SVChartItem *source);
+protected:
+    QSGNode* updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+    void geometryChanged(QRectF const& newGeometry, QRectF const& oldGeometry) override;
+signals:
+    void signalRangeChanged();
+    void signalColorChanged();
+    void signalRangeSourceChanged();
+};
+
+#endif // SVCHARTITEM_H
@@ -1,15 +1,40 @@
 #include "svclient.h"
+#include "svtrace.h"
 
-SVClient::SVClient()
+int SVClient::clients = 0;
+
+QString SVClient::nextLabels()  {
+    return SVMetrics::label("client", QString::number(++clients));
+}
+
+SVClient::SVClient() :
+    labels(nextLabels()), received("svclient", "received", labels), sent("svclient", "sent", labels)
 {
     qDebug() << "Network client initializing...";
 
-    socket = new QTcpSocket();
+    SVMetrics &metrics = SVMetrics::global();
+    decodeErrors = metrics.counter("svclient_decode_errors_total", "Packages of unknown type.", labels);
+    receiveQueue = metrics.gauge("svclient_receive_queue_bytes", "Bytes received but not read yet.", labels);
+    sendQueue = metrics.gauge("svclient_send_queue_bytes", "Bytes not written to the socket yet.", labels);
+    handshakeTime = metrics.histogram("svclient_handshake_seconds", "Time from the connection to the auth answer.",
+                                      SVMetrics::timeBounds(), labels);
+
+    //socket is a child to be moved with the client into the I/O thread
+    socket = new QTcpSocket(this);
     //socket signal/slot connetions init
     connect(socket, SIGNAL(connected()), this, SLOT(slotConnected()));
     connect(socket, SIGNAL(disconnected()), this, SLOT(slotDisconnected()));
     connect(socket, SIGNAL(readyRead()), this, SLOT(slotReadyRead()));
     connect(socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(slotError(QAbstractSocket::SocketError)));
+    connect(socket, &QTcpSocket::bytesWritten, this, [this] {
+        sendQueue->set(socket->bytesToWrite());
+    });
+
+    //child of the client, so it follows it into the I/O thread
+    timeoutTimer.setParent(this);
+    timeoutTimer.setSingleShot(true);
+    timeoutTimer.setInterval(timeout);
+    connect(&timeoutTimer, SIGNAL(timeout()), this, SLOT(slotTimeout()));
 
     qDebug() << "Done. Network client is ready.";
 }
@@ -17,18 +42,23 @@ SVClient::SVClient()
 SVClient::~SVClient() {
     socket->close();
     delete socket;
+    SVMetrics &metrics = SVMetrics::global();
+    metrics.remove(decodeErrors);
+    metrics.remove(receiveQueue);
+    metrics.remove(sendQueue);
+    metrics.remove(handshakeTime);
 }
 
 void SVClient::connectToHost(QString const& adress, quint16 port) {
     qDebug() << "connecting to " + adress + "...";
     socket->connectToHost(adress, port);
-    if (!socket->waitForConnected(3000))    {
-        emit signalUIError("Connection timeout");
-    }
+    //waiting without blocking, the I/O thread is shared by all vehicle sessions
+    timeoutTimer.start();
 }
 
 void SVClient::disconnectFromHost() {
     qDebug() << "disconnecting...";
+    timeoutTimer.stop();
     if (connected)  {
         socket->disconnectFromHost();
     }   else
@@ -36,37 +66,49 @@ void SVClient::disconnectFromHost() {
 }
 
 void SVClient::sendData(QString data)   {
-    if (connected)  {
-        qDebug() << "sending " + data + "...";
-
-        char *bytes = new char[static_cast<size_t>(data.length()) + 2];
-        bytes[0] = static_cast<char>(data.length());
-        for (int i = 0; i < data.length(); i++)    {
-            bytes[i + 1] = static_cast<char>(data.data()[i].toLatin1());
-        }
-        bytes[data.length() + 1] = '\0';
-        socket->write(bytes);
-        delete[] bytes;
+    sendData(data.toLatin1());
+}
 
+//packages of authorized connections only: the server switches to the agreed framing
+//when it answers, so anything sent before the answer could be read in the wrong one
+void SVClient::sendData(QByteArray data)    {
+    if (gotAuthPackage) {
+        sendFrame(data);
+    }   else if (connected)  {
+        qDebug() << "the connection isn't authorized yet, package is dropped";
     }   else {
         qDebug() << "there is no active connections";
     }
 }
 
-void SVClient::sendData(QByteArray data)    {
-    if (connected)  {
-        qDebug() << "sending " + data + " / sz " + QString::number(data.size()) + "...";
-        data.push_front(static_cast<uint8_t>(data.size()));
-        socket->write(data);
-        qDebug() << "send done";
-    }   else {
-        qDebug() << "there is no active connections";
+//in the framing agreed with the server
+void SVClient::sendFrame(QByteArray const& data)    {
+    qCDebug(svPackages) << "sending " + data + " / sz " + QString::number(data.size()) + "...";
+    if (data.size() > capabilities.maxFrameSize)    {
+        qDebug() << "package is too long for the server";
+        return;
     }
+    qint8 type = data.isEmpty() ? 0 : static_cast<qint8>(data.at(0));
+    QByteArray bytes = PackageFrame::wrap(data, capabilities.longFrames());
+    socket->write(bytes);
+    sent.count(type, bytes.size());
+    sendQueue->set(socket->bytesToWrite());
+    qCDebug(svPackages) << "send done";
 }
 
+//the only package before the answer, in the version 1 framing
 void SVClient::sendAuthPackage()    {
+    if (!connected) {
+        qDebug() << "there is no active connections";
+        return;
+    }
     AuthPackage authPackage;
-    sendData(authPackage.toBytes());
+    authPackage.capabilities = offered;
+    sendFrame(authPackage.toBytes());
+}
+
+Capabilities const& SVClient::getCapabilities() const  {
+    return capabilities;
 }
 
 bool SVClient::isConnected() const    {
@@ -76,16 +118,27 @@ bool SVClient::isConnected() const    {
 void SVClient::slotConnected()  {
     qDebug() << "Connected";
     connected = true;
+    capabilities = Capabilities();
+    handshakeTimer.start();
     //sending special package and wait for correct response
     sendAuthPackage();
-    QTimer::singleShot(3000, [this] {
-        if (!gotAuthPackage)
-            this->disconnectFromHost();
-    });
+    timeoutTimer.start();
+}
+
+//the connection or the auth answer of the current attempt is late
+void SVClient::slotTimeout()    {
+    if (socket->state() == QAbstractSocket::ConnectingState ||
+            socket->state() == QAbstractSocket::HostLookupState)   {
+        socket->abort();
+        emit signalUIError("Connection timeout");
+    }   else if (connected && !gotAuthPackage)  {
+        disconnectFromHost();
+    }
 }
 
 void SVClient::slotDisconnected()   {
     qDebug() << "Disconnected";
+    timeoutTimer.stop();
     connected = false;
     gotAuthPackage = false;
     emit signalUIDisconnected();
@@ -93,53 +146,152 @@ void SVClient::slotDisconnected()   {
 
 void SVClient::slotError(QAbstractSocket::SocketError socketError)  {
     qDebug() << socketError;
+    if (!connected) {
+        timeoutTimer.stop();
+        emit signalUIError(socket->errorString());
+    }
 }
 
 void SVClient::slotReadyRead()  {
-    qDebug() << "----------------------------------------------------------------------";
-    qDebug() << "Incomming data...";
-    if (socket->bytesAvailable())   {
-        //read first byte = size of the incoming package
-        char blockSize = 0;
-        socket->read(&blockSize, 1);
-
-        QByteArray bytes = socket->read(blockSize);
-
-        qDebug() << "Data(" << static_cast<int>(blockSize) << "): " << QString(bytes);
-
-        if (bytes.at(0) == AuthAnswerPackage::packageType)    {     //authorization correct response
-            qDebug() << "Valid answer code.";
-            qDebug() << "Device type: " << QString::number(bytes[1]);
-            qDebug() << "Device id: " << QString::number(bytes[2]);
-            qDebug() << "State: " << QString::number(bytes[3]);
-
-            gotAuthPackage = true;
-            emit signalUIConnected(bytes[3]);
-        }   else if (bytes.at(0) == AnswerPackage::packageType)   { //result of settings applying
-            AnswerPackage answer(bytes);
-            emit signalUIDone(answer.answerType);
-        }   else if (bytes.at(0) == LowFreqDataPackage::packageType) {  //data: location, temperature, batteries...
-            LowFreqDataPackage data(bytes);
-            emit signalUIData(data);
-        }   else if (bytes.at(0) == HighFreqDataPackage::packageType)  {    //data: encoder, angles
-            HighFreqDataPackage data(bytes);
-            emit signalUIData(data);
-        }   else if (bytes.at(0) == SetPackage::packageType) {  //uploading Smart Vehicle settings
-            qDebug() << "Uploading settings...";
-            SetPackage set(bytes);
-            emit signalUISettings(set);
-        }   else if (bytes.at(0) == MapPackage::packageType) {  //map data
-            MapPackage map(bytes);
-            emit signalUIMap(map);
-        }   else {                      //undefined package
-            brokenPackages++;
+    SV_TRACE("SVClient::slotReadyRead");
+    qCDebug(svPackages) << "----------------------------------------------------------------------";
+    qCDebug(svPackages) << "Incomming data...";
+    //all the packages received completely, the rest waits for the next readyRead
+    QByteArray bytes;
+    while (true)    {
+        if (decodeBatch())
+            continue;
+        {
+            SV_TRACE("SVClient socket read");
+            if (!PackageFrame::read(socket, capabilities.longFrames(), bytes))
+                break;
+        }
+        handlePackage(bytes);
+    }
+    qCDebug(svPackages) << "----------------------------------------------------------------------";
+    receiveQueue->set(socket->bytesAvailable());
+}
+
+//the leading run of high freq telemetry of a long receive queue (after a stall) as one batch,
+//false if there is none
+bool SVClient::decodeBatch()    {
+    TelemetryColumns batch;
+    bool decoded = capabilities.encoding() == Capabilities::DELTA ? decodeDeltaRun(batch) : decodePlainRun(batch);
+    if (!decoded)
+        return false;
+    qCDebug(svPackages) << "Batch of" << batch.size() << "samples";
+    if (batch.size())
+        emit signalUIDataBatch(batch);
+    return true;
+}
+
+//plain HighFreqDataPackage frames, all the fields of the run are decoded at once
+bool SVClient::decodePlainRun(TelemetryColumns &batch)  {
+    int prefix = capabilities.longFrames() ? 2 : 1;
+    int frameSize = TelemetryBatchDecoder::frameSize(capabilities.layout());
+    if (socket->bytesAvailable() < batchFrames * (prefix + frameSize))
+        return false;
+    QByteArray header = socket->peek(prefix + 1);
+    if (header.at(prefix) != HighFreqDataPackage::packageType)
+        return false;
+
+    SV_TRACE("SVClient batch decode");
+    QByteArray buffered = socket->peek(socket->bytesAvailable());
+    int size = TelemetryBatchDecoder::decode(buffered.constData(), buffered.size(), capabilities.longFrames(),
+                                             capabilities.layout(), batch);
+    if (!size)
+        return false;
+    socket->read(size);
+    received.count(HighFreqDataPackage::packageType, prefix + frameSize, batch.size());
+    return true;
+}
+
+//compressed frames depend on the previous ones, so they are decoded one by one,
+//only the samples are delivered together
+bool SVClient::decodeDeltaRun(TelemetryColumns &batch)  {
+    int prefix = capabilities.longFrames() ? 2 : 1;
+    if (socket->bytesAvailable() < batchFrames * (prefix + TelemetryEncoder::minFrameSize))
+        return false;
+
+    SV_TRACE("SVClient batch decode");
+    QByteArray bytes;
+    int frames = 0;
+    while (true)    {
+        QByteArray header = socket->peek(prefix + 1);
+        if (header.size() < prefix + 1 || header.at(prefix) != TelemetryEncoder::packageType)
+            break;
+        if (!PackageFrame::read(socket, capabilities.longFrames(), bytes))
+            break;
+        frames++;
+        received.count(TelemetryEncoder::packageType, bytes.size() + prefix);
+        HighFreqDataPackage data;
+        if (decoder.decode(bytes, data))    {
+            batch.append(data);
+        }   else    {
+            decodeErrors->add();
             emit signalUIBrokenPackage();
         }
-        qDebug() << "----------------------------------------------------------------------";
-    }   else {
-        qDebug() << "Nothing to read. Maybe this device is not supporting.";
     }
+    return frames > 0;
+}
+
+void SVClient::handlePackage(QByteArray &bytes) {
+    Package::Layout layout = capabilities.layout();
+    qCDebug(svPackages) << "Data(" << bytes.size() << "): " << QString(bytes);
+    received.count(bytes.isEmpty() ? 0 : static_cast<qint8>(bytes.at(0)), bytes.size() + 1);
+
+    SV_TRACE("SVClient decode");
 
+    if (bytes.isEmpty())    {
+        decodeErrors->add();
+        emit signalUIBrokenPackage();
+    }   else if (bytes.at(0) == AuthAnswerPackage::packageType)    {     //authorization correct response
+        AuthAnswerPackage answer(bytes);
+        qDebug() << "Valid answer code.";
+        qDebug() << "Device type: " << QString::number(answer.deviceType);
+        qDebug() << "Device id: " << QString::number(answer.deviceID);
+        qDebug() << "State: " << QString::number(answer.stateType);
+        //the next packages are in the agreed framing
+        capabilities = answer.capabilities;
+        qDebug() << "Protocol version: " << QString::number(capabilities.version);
+        qDebug() << "Max frame size: " << QString::number(capabilities.maxFrameSize);
+        qDebug() << "Layout: " << QString::number(capabilities.layout());
+        qDebug() << "Telemetry encoding: " << QString::number(capabilities.encoding());
+        qDebug() << "Telemetry rates: " << QString::number(capabilities.highFreqRate) << " / " << QString::number(capabilities.lowFreqRate);
+
+        gotAuthPackage = true;
+        timeoutTimer.stop();
+        decoder.reset();
+        handshakeTime->observe(handshakeTimer.nsecsElapsed() / 1e9);
+        emit signalUIConnected(answer.stateType);
+    }   else if (bytes.at(0) == AnswerPackage::packageType)   { //result of settings applying
+        AnswerPackage answer(bytes);
+        emit signalUIDone(answer.answerType);
+    }   else if (bytes.at(0) == LowFreqDataPackage::packageType) {  //data: location, temperature, batteries...
+        LowFreqDataPackage data(bytes, layout);
+        emit signalUIData(data);
+    }   else if (bytes.at(0) == HighFreqDataPackage::packageType)  {    //data: encoder, angles
+        HighFreqDataPackage data(bytes, layout);
+        emit signalUIData(data);
+    }   else if (bytes.at(0) == TelemetryEncoder::packageType)  {   //data: compressed encoder, angles
+        HighFreqDataPackage data;
+        if (decoder.decode(bytes, data))    {
+            emit signalUIData(data);
+        }   else    {
+            decodeErrors->add();
+            emit signalUIBrokenPackage();
+        }
+    }   else if (bytes.at(0) == SetPackage::packageType) {  //uploading Smart Vehicle settings
+        qDebug() << "Uploading settings...";
+        SetPackage set(bytes, layout);
+        emit signalUISettings(set);
+    }   else if (bytes.at(0) == MapPackage::packageType) {  //map data
+        MapPackage map(bytes, layout);
+        emit signalUIMap(map);
+    }   else {                      //undefined package
+        decodeErrors->add();
+        emit signalUIBrokenPackage();
+    }
 }
 
 //search for available networks and sends a list of them to UI
@@ -174,7 +326,7 @@ void SVClient::slotUIDisconnect()   {
 }
 
 void SVClient::slotUISettingsLoad(SetPackage const& set)    {
-    sendData(set.toBytes());
+    sendData(set.toBytes(capabilities.layout()));
 }
 
 void SVClient::slotUISettingsUpload()   {
@@ -183,5 +335,15 @@ void SVClient::slotUISettingsUpload()   {
 }
 
 void SVClient::slotUIControl(ControlPackage const& data)    {
-    sendData(data.toBytes());
+    sendData(data.toBytes(capabilities.layout()));
+}
+
+void SVClient::slotUIGoal(GoalPackage const& goal)  {
+    sendData(goal.toBytes(capabilities.layout()));
+}
+
+//0 accepts any rate of the server
+void SVClient::slotUISetRates(quint16 const& highFreqRate, quint16 const& lowFreqRate)  {
+    offered.highFreqRate = highFreqRate;
+    offered.lowFreqRate = lowFreqRate;
 }
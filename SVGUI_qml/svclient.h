@@ -8,16 +8,44 @@
 #include <QTime>
 #include <QTimer>
 #include <QNetworkInterface>
+#include <QElapsedTimer>
 #include "datapackage.h"
+#include "svmetrics.h"
+#include "telemetrycodec.h"
+#include "telemetrybatch.h"
 
 class SVClient : public QObject
 {
     Q_OBJECT
 private:
     QTcpSocket* socket;
+    //connect and auth timeouts of the current attempt, stopped when it completes
+    static const int timeout = 3000;    //msec
+    QTimer timeoutTimer;
     bool connected = false;
     bool gotAuthPackage = false; //true for authorized connections
-    unsigned brokenPackages = 0;
+    TelemetryDecoder decoder;   //compressed telemetry, if the server has chosen it
+    Capabilities offered = Capabilities::local();
+    Capabilities capabilities;  //agreed by the auth answer, version 1 before it
+    static const int batchFrames = 16;  //queued telemetry decoded at once
+
+    //metrics of the client are labeled by its number in the process
+    static int clients;
+    QString labels;
+    SVPackageCounters received;
+    SVPackageCounters sent;
+    SVCounter *decodeErrors;
+    SVGauge *receiveQueue;
+    SVGauge *sendQueue;
+    SVHistogram *handshakeTime;
+    QElapsedTimer handshakeTimer;
+
+    static QString nextLabels();
+    void sendFrame(QByteArray const& data);
+    void handlePackage(QByteArray &bytes);
+    bool decodeBatch();
+    bool decodePlainRun(TelemetryColumns &batch);
+    bool decodeDeltaRun(TelemetryColumns &batch);
 public:
     SVClient();
     ~SVClient();
@@ -29,6 +57,7 @@ public:
     void sendData(QByteArray data);
     void sendAuthPackage();
     bool isConnected() const;
+    Capabilities const& getCapabilities() const;
 
 private slots:
     //socket slots
@@ -36,6 +65,7 @@ private slots:
     void slotDisconnected();
     void slotError(QAbstractSocket::SocketError socketError);
     void slotReadyRead();
+    void slotTimeout();
 public slots:
     //slots adapter -> network client
     void slotUISearch();
@@ -44,6 +74,9 @@ public slots:
     void slotUISettingsLoad(SetPackage const& set);
     void slotUISettingsUpload();
     void slotUIControl(ControlPackage const& data);
+    void slotUIGoal(GoalPackage const& goal);
+    //asked in the next handshakes
+    void slotUISetRates(quint16 const& highFreqRate, quint16 const& lowFreqRate);
 signals:
     //signals network client -> adapter
     void signalUIAddresses(QList<QString> const& addresses);
@@ -52,6 +85,8 @@ signals:
     void signalUIError(QString message);
     void signalUIData(LowFreqDataPackage const& data);
     void signalUIData(HighFreqDataPackage const& data);
+    //a run of queued high freq samples, in one event instead of one per sample
+    void signalUIDataBatch(TelemetryColumns const& batch);
     void signalUIDone(qint8 const& answerCode);
     void signalUISettings(SetPackage const& set);
     void signalUIMap(MapPackage const& map);
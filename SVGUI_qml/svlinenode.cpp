@@ -0,0 +1,203 @@
+#include "svlinenode.h"
+
+SVLinePoints::~SVLinePoints()   {}
+
+SVVectorPoints::SVVectorPoints(QVector<QPointF> const& points) : points(points) {}
+
+int SVVectorPoints::size() const    {
+    return points.size();
+}
+
+QPointF SVVectorPoints::at(int index) const {
+    return points.at(index);
+}
+
+SVLineNode::~SVLineNode()   {}
+
+SVLineNode* SVLineNode::create(QQuickWindow *window)  {
+    if (window->rendererInterface()->graphicsApi() == QSGRendererInterface::Software)
+        return new SVSoftwareLineNode(window);
+    return new SVGeometryLineNode();
+}
+
+//line segments are stored as separate vertex pairs, so unused and removed segments
+//are just degenerated and appending never touches already uploaded vertices
+SVGeometryLineNode::SVGeometryLineNode()    {
+    geometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), 0);
+    geometry->setDrawingMode(QSGGeometry::DrawLines);
+    geometry->setVertexDataPattern(QSGGeometry::StreamPattern);
+    geometry->setLineWidth(1);
+
+    material = new QSGFlatColorMaterial();
+
+    lineNode = new QSGGeometryNode();
+    lineNode->setGeometry(geometry);
+    lineNode->setFlag(QSGNode::OwnsGeometry);
+    lineNode->setMaterial(material);
+    lineNode->setFlag(QSGNode::OwnsMaterial);
+    appendChildNode(lineNode);
+}
+
+void SVGeometryLineNode::setSegment(int segment, QPointF const& from, QPointF const& to)  {
+    QSGGeometry::Point2D *vertices = geometry->vertexDataAsPoint2D();
+    vertices[segment * 2].set(static_cast<float>(from.x()), static_cast<float>(from.y()));
+    vertices[segment * 2 + 1].set(static_cast<float>(to.x()), static_cast<float>(to.y()));
+}
+
+void SVGeometryLineNode::setLine(SVLinePoints const& points, int first) {
+    int count = qMax(points.size() - first - 1, 0);
+    int capacity = qMax(minCapacity, count * 2);
+
+    geometry->allocate(capacity * 2);
+    memset(geometry->vertexData(), 0, static_cast<size_t>(capacity * 2) * sizeof(QSGGeometry::Point2D));
+    for (int i = 0; i < count; i++)
+        setSegment(i, points.at(first + i), points.at(first + i + 1));
+
+    base = first;
+    segments = count;
+    hidden = 0;
+    lineNode->markDirty(QSGNode::DirtyGeometry);
+}
+
+bool SVGeometryLineNode::appendLine(SVLinePoints const& points, int from)   {
+    int start = qMax(from, base + segments + 1);
+    if (points.size() - base - 1 > geometry->vertexCount() / 2)
+        return false;
+
+    for (int i = start; i < points.size(); i++)
+        setSegment(i - base - 1, points.at(i - 1), points.at(i));
+    segments = qMax(segments, points.size() - base - 1);
+    lineNode->markDirty(QSGNode::DirtyGeometry);
+    return true;
+}
+
+void SVGeometryLineNode::removeFront(int first) {
+    QPointF none;
+    int count = qMin(first - base, segments);
+    if (count <= hidden)
+        return;
+    for (int i = hidden; i < count; i++)
+        setSegment(i, none, none);
+    hidden = count;
+    lineNode->markDirty(QSGNode::DirtyGeometry);
+}
+
+void SVGeometryLineNode::moveLast(QPointF const& point) {
+    if (segments <= hidden)
+        return;
+    geometry->vertexDataAsPoint2D()[segments * 2 - 1].set(static_cast<float>(point.x()), static_cast<float>(point.y()));
+    lineNode->markDirty(QSGNode::DirtyGeometry);
+}
+
+void SVGeometryLineNode::setColor(QColor const& color)  {
+    if (material->color() == color)
+        return;
+    material->setColor(color);
+    lineNode->markDirty(QSGNode::DirtyMaterial);
+}
+
+void SVGeometryLineNode::setDataTransform(QMatrix4x4 const& matrix) {
+    setMatrix(matrix);
+}
+
+//the geometry is clipped by the scene graph
+void SVGeometryLineNode::setSize(QSizeF const& size)  {
+    Q_UNUSED(size)
+}
+
+QSGNode* SVGeometryLineNode::node() {
+    return this;
+}
+
+//the software renderer doesn't draw custom geometry, the polyline is painted by QPainter
+SVSoftwareLineNode::SVSoftwareLineNode(QQuickWindow *window) :
+    window(window)  {}
+
+void SVSoftwareLineNode::setLine(SVLinePoints const& points, int first)   {
+    polyline.clear();
+    for (int i = first; i < points.size(); i++)
+        polyline.append(points.at(i));
+    base = first;
+    this->first = 0;
+    markDirty(QSGNode::DirtyMaterial);
+}
+
+bool SVSoftwareLineNode::appendLine(SVLinePoints const& points, int from) {
+    //removed points are dropped only when they are the most of the buffer
+    if (first > 1024 && first > polyline.size() / 2)   {
+        polyline.remove(0, first);
+        base += first;
+        first = 0;
+    }
+    for (int i = qMax(from, base + polyline.size()); i < points.size(); i++)
+        polyline.append(points.at(i));
+    markDirty(QSGNode::DirtyMaterial);
+    return true;
+}
+
+void SVSoftwareLineNode::removeFront(int first)  {
+    this->first = qBound(0, first - base, polyline.size());
+    markDirty(QSGNode::DirtyMaterial);
+}
+
+void SVSoftwareLineNode::moveLast(QPointF const& point)   {
+    if (polyline.isEmpty())
+        return;
+    polyline.last() = point;
+    markDirty(QSGNode::DirtyMaterial);
+}
+
+void SVSoftwareLineNode::setColor(QColor const& color)  {
+    this->color = color;
+    markDirty(QSGNode::DirtyMaterial);
+}
+
+void SVSoftwareLineNode::setDataTransform(QMatrix4x4 const& matrix)   {
+    dataTransform = matrix.toTransform();
+    markDirty(QSGNode::DirtyMaterial);
+}
+
+void SVSoftwareLineNode::setSize(QSizeF const& size)  {
+    if (this->size == size)
+        return;
+    this->size = size;
+    markDirty(QSGNode::DirtyMaterial);
+}
+
+QSGNode* SVSoftwareLineNode::node() {
+    return this;
+}
+
+void SVSoftwareLineNode::render(RenderState const* state) {
+    QSGRendererInterface *rif = window->rendererInterface();
+    QPainter *painter = static_cast<QPainter*>(rif->getResource(window, QSGRendererInterface::PainterResource));
+    if (painter == nullptr || polyline.size() - first < 2)
+        return;
+
+    painter->save();
+    QRegion const* clipRegion = state->clipRegion();
+    if (clipRegion && !clipRegion->isEmpty())
+        painter->setClipRegion(*clipRegion, Qt::ReplaceClip);
+    painter->setTransform(matrix()->toTransform());
+    painter->setClipRect(rect(), Qt::IntersectClip);
+    painter->setOpacity(inheritedOpacity());
+    painter->setTransform(dataTransform, true);
+
+    QPen pen(color);
+    pen.setCosmetic(true);
+    painter->setPen(pen);
+    painter->drawPolyline(polyline.constData() + first, polyline.size() - first);
+    painter->restore();
+}
+
+QSGRenderNode::StateFlags SVSoftwareLineNode::changedStates() const {
+    return StateFlags();
+}
+
+QSGRenderNode::RenderingFlags SVSoftwareLineNode::flags() const {
+    return BoundedRectRendering;
+}
+
+QRectF SVSoftwareLineNode::rect() const  {
+    return QRectF(QPointF(0, 0), size);
+}
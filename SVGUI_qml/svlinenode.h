@@ -0,0 +1,119 @@
+#ifndef SVLINENODE_H
+#define SVLINENODE_H
+
+#include <QQuickWindow>
+#include <QSGNode>
+#include <QSGGeometryNode>
+#include <QSGFlatColorMaterial>
+#include <QSGRenderNode>
+#include <QSGRendererInterface>
+#include <QMatrix4x4>
+#include <QPainter>
+#include <QColor>
+#include <QVector>
+#include <QPointF>
+#include <QSizeF>
+
+//points of a line by index, e.g. the storage of a series, indices are kept between updates
+class SVLinePoints
+{
+public:
+    virtual ~SVLinePoints();
+    //index after the last point
+    virtual int size() const = 0;
+    virtual QPointF at(int index) const = 0;
+};
+
+class SVVectorPoints : public SVLinePoints
+{
+private:
+    QVector<QPointF> const& points;
+public:
+    explicit SVVectorPoints(QVector<QPointF> const& points);
+    int size() const override;
+    QPointF at(int index) const override;
+};
+
+/*
+ * Scene graph polyline in data coordinates.
+ * Points are uploaded once, appending writes only the new segments and
+ * the mapping data -> item coordinates (scroll, zoom) is a single matrix.
+ */
+class SVLineNode
+{
+public:
+    virtual ~SVLineNode();
+
+    //uploads points [first, end) into a new buffer
+    virtual void setLine(SVLinePoints const& points, int first) = 0;
+    //uploads points [from, end), returns false if the buffer is full and setLine() is required
+    virtual bool appendLine(SVLinePoints const& points, int from) = 0;
+    //hides points before the index
+    virtual void removeFront(int first) = 0;
+    //moves the last uploaded point, e.g. the live end of a trail
+    virtual void moveLast(QPointF const& point) = 0;
+    virtual void setColor(QColor const& color) = 0;
+    virtual void setDataTransform(QMatrix4x4 const& matrix) = 0;
+    //item size, set while the GUI thread is blocked so the node never reads the item on the render thread
+    virtual void setSize(QSizeF const& size) = 0;
+    virtual QSGNode* node() = 0;
+
+    //geometry node for OpenGL and QPainter based node for the software renderer
+    static SVLineNode* create(QQuickWindow *window);
+};
+
+class SVGeometryLineNode : public QSGTransformNode, public SVLineNode
+{
+private:
+    static const int minCapacity = 1024;   //segments
+
+    QSGGeometryNode *lineNode;
+    QSGGeometry *geometry;
+    QSGFlatColorMaterial *material;
+    int base = 0;       //point index of the first segment in the buffer
+    int segments = 0;   //used segments
+    int hidden = 0;     //removed segments at the buffer start
+
+    void setSegment(int segment, QPointF const& from, QPointF const& to);
+public:
+    SVGeometryLineNode();
+
+    void setLine(SVLinePoints const& points, int first) override;
+    bool appendLine(SVLinePoints const& points, int from) override;
+    void removeFront(int first) override;
+    void moveLast(QPointF const& point) override;
+    void setColor(QColor const& color) override;
+    void setDataTransform(QMatrix4x4 const& matrix) override;
+    void setSize(QSizeF const& size) override;
+    QSGNode* node() override;
+};
+
+class SVSoftwareLineNode : public QSGRenderNode, public SVLineNode
+{
+private:
+    QQuickWindow *window;
+    QSizeF size;
+    QPolygonF polyline;
+    int first = 0;      //index in the polyline of the first visible point
+    int base = 0;       //point index of polyline[0]
+    QColor color;
+    QTransform dataTransform;
+public:
+    explicit SVSoftwareLineNode(QQuickWindow *window);
+
+    void setLine(SVLinePoints const& points, int first) override;
+    bool appendLine(SVLinePoints const& points, int from) override;
+    void removeFront(int first) override;
+    void moveLast(QPointF const& point) override;
+    void setColor(QColor const& color) override;
+    void setDataTransform(QMatrix4x4 const& matrix) override;
+    void setSize(QSizeF const& size) override;
+    QSGNode* node() override;
+
+    void render(RenderState const* state) override;
+    StateFlags changedStates() const override;
+    RenderingFlags flags() const override;
+    QRectF rect() const override;
+};
+
+#endif // SVLINENODE_H
@@ -0,0 +1,544 @@
+#include "svmapitem.h"
+#include "svtrace.h"
+#include <QtMath>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <cstring>
+#include "datapackage.h"
+#include "svlinenode.h"
+
+const int SVMapItem::tileSize;
+const int SVMapItem::maxTiles;
+const int SVMapItem::maxJobs;
+const int SVMapItem::gridMinCell;
+constexpr qreal SVMapItem::minZoom;
+constexpr qreal SVMapItem::maxZoom;
+
+//root node of the map, keeps uploaded tile textures and pools of the image and line nodes
+class SVMapNode : public QSGNode
+{
+public:
+    struct Texture {
+        QSGTexture *texture = nullptr;
+        quint32 serial = 0;
+    };
+
+    QHash<quint64, Texture> textures;
+    QVector<QSGImageNode*> images;
+    QVector<QSGRectangleNode*> lines;
+    SVLineNode *trail = nullptr;
+
+    ~SVMapNode() override  {
+        removeAllChildNodes();
+        qDeleteAll(images);
+        qDeleteAll(lines);
+        delete trail;
+        for (Texture const& texture : textures)
+            delete texture.texture;
+    }
+};
+
+SVMapItem::SVMapItem(QQuickItem *parent) : QQuickItem(parent)   {
+    setFlag(QQuickItem::ItemHasContents);
+    setAcceptedMouseButtons(Qt::LeftButton | Qt::RightButton);
+    setClip(true);
+}
+
+quint64 SVMapItem::tileKey(int level, int tx, int ty)   {
+    return (static_cast<quint64>(level) << 48) | (static_cast<quint64>(ty) << 24) | static_cast<quint64>(tx);
+}
+
+//fills the tile image by the cells, one pixel per texel, runs in the thread pool
+QImage SVMapItem::buildTile(SVMapTileJob const& job)    {
+    QImage image(job.width, job.height, QImage::Format_RGB32);
+    for (int y = 0; y < job.height; y++)    {
+        QRgb *line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        char const* row = job.cells.constData() + y * job.width;
+        for (int x = 0; x < job.width; x++)
+            line[x] = row[x] == MapPackage::WALL ? job.wall : job.empty;
+    }
+    return image;
+}
+
+//every next level is a half of the previous one until the whole map fits one tile
+void SVMapItem::buildLevels()   {
+    while (levels.last().width > tileSize || levels.last().height > tileSize)  {
+        Level const& fine = levels.last();
+        Level coarse;
+        coarse.width = (fine.width + 1) / 2;
+        coarse.height = (fine.height + 1) / 2;
+        coarse.cells = QByteArray(coarse.width * coarse.height, static_cast<char>(MapPackage::EMPTY));
+        for (int y = 0; y < fine.height; y++)   {
+            char const* row = fine.cells.constData() + y * fine.width;
+            char *coarseRow = coarse.cells.data() + (y / 2) * coarse.width;
+            for (int x = 0; x < fine.width; x++)
+                if (row[x] == MapPackage::WALL)
+                    coarseRow[x / 2] = static_cast<char>(MapPackage::WALL);
+        }
+        levels.append(coarse);
+    }
+    for (Level &level : levels) {
+        level.tilesX = (level.width + tileSize - 1) / tileSize;
+        level.tilesY = (level.height + tileSize - 1) / tileSize;
+    }
+}
+
+//replaces the whole map, cells are row by row
+//the view is kept if the map size is the same
+void SVMapItem::setMap(int width, int height, QByteArray const& cells)  {
+    if (width <= 0 || height <= 0 || cells.size() < width * height)    {
+        clear();
+        return;
+    }
+
+    bool resized = width != mapWidth() || height != mapHeight();
+    generation++;
+    jobs.clear();   //running jobs finish by themselves, their results are dropped
+    tiles.clear();
+    versions.clear();
+    levels.clear();
+    Level level;
+    level.width = width;
+    level.height = height;
+    level.cells = cells.left(width * height);
+    levels.append(level);
+    buildLevels();
+
+    emit signalMapChanged();
+    if (resized)
+        fit();
+    else
+        updateView();
+}
+
+//changes one cell on every level, only the tiles with the cell are rebuilt in background
+void SVMapItem::setCell(int x, int y, qint8 cell)   {
+    if (x < 0 || y < 0 || x >= mapWidth() || y >= mapHeight())
+        return;
+    levels[0].cells[y * levels.at(0).width + x] = static_cast<char>(cell);
+    for (int index = 0; index < levels.size(); index++) {
+        Level &level = levels[index];
+        if (index > 0)  {
+            //the texel is a wall if any of its 4 cells on the finer level is a wall
+            Level const& fine = levels.at(index - 1);
+            bool wall = false;
+            for (int fy = y * 2; fy < qMin(y * 2 + 2, fine.height); fy++)
+                for (int fx = x * 2; fx < qMin(x * 2 + 2, fine.width); fx++)
+                    wall |= fine.cells.at(fy * fine.width + fx) == MapPackage::WALL;
+            level.cells[y * level.width + x] = static_cast<char>(wall ? MapPackage::WALL : MapPackage::EMPTY);
+        }
+        quint64 key = tileKey(index, x / tileSize, y / tileSize);
+        versions[key]++;
+        auto tile = tiles.find(key);
+        if (tile != tiles.end())
+            tile->stale = true;
+        x /= 2;
+        y /= 2;
+    }
+    updateView();
+}
+
+qint8 SVMapItem::cell(int x, int y) const   {
+    if (x < 0 || y < 0 || x >= mapWidth() || y >= mapHeight())
+        return MapPackage::EMPTY;
+    return static_cast<qint8>(levels.at(0).cells.at(y * levels.at(0).width + x));
+}
+
+void SVMapItem::clear() {
+    generation++;
+    jobs.clear();
+    tiles.clear();
+    versions.clear();
+    levels.clear();
+    emit signalMapChanged();
+    fit();
+}
+
+int SVMapItem::mapWidth() const {
+    return levels.isEmpty() ? 0 : levels.at(0).width;
+}
+
+int SVMapItem::mapHeight() const    {
+    return levels.isEmpty() ? 0 : levels.at(0).height;
+}
+
+//tiles building now
+int SVMapItem::pendingTiles() const {
+    return jobs.size();
+}
+
+void SVMapItem::setTrail(TrajectoryTrail const* trail)   {
+    this->trail = trail;
+    trailRebuild = true;
+    update();
+}
+
+void SVMapItem::updateTrail()   {
+    if (trail)
+        update();
+}
+
+//starts building of the tile image if there is a free worker
+void SVMapItem::requestTile(int level, int tx, int ty)  {
+    quint64 key = tileKey(level, tx, ty);
+    if (jobs.contains(key) || jobs.size() >= maxJobs)
+        return;
+
+    //only the tile window is copied, sharing the level would make the next setCell() copy all of it
+    Level const& source = levels.at(level);
+    SVMapTileJob job;
+    int x0 = tx * tileSize;
+    int y0 = ty * tileSize;
+    job.width = qMin(tileSize, source.width - x0);
+    job.height = qMin(tileSize, source.height - y0);
+    job.cells.resize(job.width * job.height);
+    for (int y = 0; y < job.height; y++)
+        std::memcpy(job.cells.data() + y * job.width, source.cells.constData() + (y0 + y) * source.width + x0,
+               static_cast<size_t>(job.width));
+    job.empty = emptyColor.rgb();
+    job.wall = wallColor.rgb();
+
+    int generation = this->generation;
+    quint32 version = versions.value(key);
+    QFutureWatcher<QImage> *watcher = new QFutureWatcher<QImage>(this);
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, watcher, key, generation, version]()  {
+        if (jobs.value(key) == watcher)
+            jobs.remove(key);
+        tileReady(key, generation, version, watcher->result());
+        watcher->deleteLater();
+    });
+    jobs.insert(key, watcher);
+    watcher->setFuture(QtConcurrent::run(&SVMapItem::buildTile, job));
+}
+
+void SVMapItem::tileReady(quint64 key, int generation, quint32 version, QImage const& image)    {
+    if (generation != this->generation)
+        return;
+    Tile &tile = tiles[key];
+    tile.image = image;
+    tile.serial = ++serials;
+    tile.lastUsed = frame;
+    //cells of the tile changed while it was building
+    tile.stale = version != versions.value(key);
+    updateView();
+}
+
+//drops the least recently drawn tiles, tiles of the current frame are kept
+void SVMapItem::evictTiles()    {
+    while (tiles.size() > maxTiles) {
+        auto oldest = tiles.end();
+        for (auto tile = tiles.begin(); tile != tiles.end(); ++tile)
+            if (tile->lastUsed < frame && (oldest == tiles.end() || tile->lastUsed < oldest->lastUsed))
+                oldest = tile;
+        if (oldest == tiles.end())
+            return;
+        tiles.erase(oldest);
+    }
+}
+
+//returns the tile if its image is ready, otherwise requests it
+SVMapItem::Tile* SVMapItem::readyTile(int level, int tx, int ty)   {
+    auto tile = tiles.find(tileKey(level, tx, ty));
+    if (tile == tiles.end() || tile->stale)
+        requestTile(level, tx, ty);
+    if (tile == tiles.end())
+        return nullptr;
+    tile->lastUsed = frame;
+    return &tile.value();
+}
+
+void SVMapItem::updateView()    {
+    polish();
+    update();
+}
+
+//keeps the view center on the map
+void SVMapItem::clampCenter()   {
+    center.setX(qBound(0.0, center.x(), static_cast<qreal>(mapWidth())));
+    center.setY(qBound(0.0, center.y(), static_cast<qreal>(mapHeight())));
+}
+
+//px per cell when the whole map fits the item
+qreal SVMapItem::fitScale() const   {
+    if (levels.isEmpty())
+        return 0;
+    return qMin(width() / mapWidth(), height() / mapHeight());
+}
+
+qreal SVMapItem::zoom() const   {
+    return _zoom;
+}
+
+void SVMapItem::setZoom(qreal zoom) {
+    zoom = qBound(minZoom, zoom, maxZoom);
+    if (qFuzzyCompare(_zoom, zoom))
+        return;
+    _zoom = zoom;
+    emit signalViewChanged();
+    updateView();
+}
+
+qreal SVMapItem::cellSize() const   {
+    return fitScale() * _zoom;
+}
+
+QPointF SVMapItem::mapToView(qreal x, qreal y) const    {
+    qreal scale = cellSize();
+    return QPointF((x - center.x()) * scale + width() / 2, (y - center.y()) * scale + height() / 2);
+}
+
+QPointF SVMapItem::viewToMap(qreal x, qreal y) const    {
+    qreal scale = cellSize();
+    if (scale <= 0)
+        return QPointF();
+    return QPointF((x - width() / 2) / scale + center.x(), (y - height() / 2) / scale + center.y());
+}
+
+//zooms keeping the map point under the item point (x, y)
+void SVMapItem::zoomAt(qreal factor, qreal x, qreal y)  {
+    if (levels.isEmpty())
+        return;
+    QPointF anchor = viewToMap(x, y);
+    _zoom = qBound(minZoom, _zoom * factor, maxZoom);
+    center = anchor - QPointF(x - width() / 2, y - height() / 2) / cellSize();
+    clampCenter();
+    emit signalViewChanged();
+    updateView();
+}
+
+void SVMapItem::pan(qreal dx, qreal dy)  {
+    qreal scale = cellSize();
+    if (scale <= 0)
+        return;
+    center -= QPointF(dx, dy) / scale;
+    clampCenter();
+    emit signalViewChanged();
+    updateView();
+}
+
+//whole map in the item
+void SVMapItem::fit()   {
+    _zoom = 1;
+    center = QPointF(mapWidth() / 2.0, mapHeight() / 2.0);
+    emit signalViewChanged();
+    updateView();
+}
+
+//part of the item which is not clipped by the ancestors and the window
+QRectF SVMapItem::visibleRect() const   {
+    QRectF visible = boundingRect();
+    for (QQuickItem *item = parentItem(); item; item = item->parentItem())
+        if (item->clip())
+            visible &= mapRectFromItem(item, item->boundingRect());
+    if (window())
+        visible &= mapRectFromScene(QRectF(0, 0, window()->width(), window()->height()));
+    return visible;
+}
+
+//chooses the level and the tiles for the current view, runs in the GUI thread before the sync
+void SVMapItem::updatePolish()  {
+    SV_TRACE("SVMapItem::updatePolish");
+    frame++;
+    draws.clear();
+    gridLines.clear();
+
+    QRectF visible = visibleRect();
+    qreal scale = cellSize();
+    if (levels.isEmpty() || visible.isEmpty() || scale <= 0)
+        return;
+
+    //coarsest level with a texel not smaller than a pixel
+    int level = 0;
+    while (level + 1 < levels.size() && scale * (1 << level) < 1)
+        level++;
+    int texel = 1 << level;     //cells
+    Level const& current = levels.at(level);
+
+    //visible texels [x0, x1) x [y0, y1)
+    QPointF topLeft = viewToMap(visible.left(), visible.top());
+    QPointF bottomRight = viewToMap(visible.right(), visible.bottom());
+    int x0 = qBound(0, qFloor(topLeft.x() / texel), current.width);
+    int x1 = qBound(0, qCeil(bottomRight.x() / texel), current.width);
+    int y0 = qBound(0, qFloor(topLeft.y() / texel), current.height);
+    int y1 = qBound(0, qCeil(bottomRight.y() / texel), current.height);
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    for (int ty = y0 / tileSize; ty <= (y1 - 1) / tileSize; ty++)   {
+        for (int tx = x0 / tileSize; tx <= (x1 - 1) / tileSize; tx++)   {
+            //only the visible texels of the tile
+            int cx0 = qMax(x0, tx * tileSize);
+            int cx1 = qMin(x1, (tx + 1) * tileSize);
+            int cy0 = qMax(y0, ty * tileSize);
+            int cy1 = qMin(y1, (ty + 1) * tileSize);
+            Draw draw;
+            draw.target = QRectF(mapToView(cx0 * texel, cy0 * texel), mapToView(cx1 * texel, cy1 * texel));
+
+            if (readyTile(level, tx, ty))   {
+                draw.key = tileKey(level, tx, ty);
+                draw.source = QRectF(cx0 - tx * tileSize, cy0 - ty * tileSize, cx1 - cx0, cy1 - cy0);
+                draws.append(draw);
+                continue;
+            }
+            //coarser tile until this one is ready
+            for (int coarse = level + 1; coarse < levels.size(); coarse++)  {
+                int shift = coarse - level;
+                int ctx = tx >> shift;
+                int cty = ty >> shift;
+                auto tile = tiles.find(tileKey(coarse, ctx, cty));
+                if (tile == tiles.end())
+                    continue;
+                tile->lastUsed = frame;
+                qreal ratio = 1 << shift;
+                draw.key = tile.key();
+                draw.source = QRectF(cx0 / ratio - ctx * tileSize, cy0 / ratio - cty * tileSize,
+                                     (cx1 - cx0) / ratio, (cy1 - cy0) / ratio);
+                draws.append(draw);
+                break;
+            }
+        }
+    }
+    evictTiles();
+
+    if (level > 0 || scale < gridMinCell)
+        return;
+    //grid lines of the visible cells
+    for (int x = x0; x <= x1; x++)  {
+        QPointF from = mapToView(x, y0);
+        gridLines.append(QRectF(from.x(), from.y(), 1, (y1 - y0) * scale));
+    }
+    for (int y = y0; y <= y1; y++)  {
+        QPointF from = mapToView(x0, y);
+        gridLines.append(QRectF(from.x(), from.y(), (x1 - x0) * scale, 1));
+    }
+}
+
+//called on the render thread while the GUI thread is blocked
+QSGNode* SVMapItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)   {
+    SV_TRACE("SVMapItem::updatePaintNode");
+    Q_UNUSED(data)
+
+    SVMapNode *node = static_cast<SVMapNode*>(oldNode);
+    if (node == nullptr)
+        node = new SVMapNode();
+    node->removeAllChildNodes();
+
+    //textures of evicted and rebuilt tiles
+    for (auto texture = node->textures.begin(); texture != node->textures.end();)   {
+        auto tile = tiles.constFind(texture.key());
+        if (tile == tiles.constEnd() || tile->serial != texture->serial)    {
+            delete texture->texture;
+            texture = node->textures.erase(texture);
+        }   else    {
+            ++texture;
+        }
+    }
+
+    int images = 0;
+    for (Draw const& draw : draws)  {
+        auto tile = tiles.constFind(draw.key);
+        if (tile == tiles.constEnd())
+            continue;
+        SVMapNode::Texture &texture = node->textures[draw.key];
+        if (texture.texture == nullptr) {
+            texture.texture = window()->createTextureFromImage(tile->image);
+            texture.serial = tile->serial;
+        }
+        if (images == node->images.size()) {
+            QSGImageNode *image = window()->createImageNode();
+            image->setFiltering(QSGTexture::Nearest);
+            node->images.append(image);
+        }
+        QSGImageNode *image = node->images.at(images++);
+        image->setTexture(texture.texture);
+        image->setSourceRect(draw.source);
+        image->setRect(draw.target);
+        node->appendChildNode(image);
+    }
+
+    while (node->lines.size() < gridLines.size())   {
+        QSGRectangleNode *line = window()->createRectangleNode();
+        line->setColor(gridColor);
+        node->lines.append(line);
+    }
+    for (int i = 0; i < gridLines.size(); i++)  {
+        node->lines.at(i)->setRect(gridLines.at(i));
+        node->appendChildNode(node->lines.at(i));
+    }
+
+    if (trail == nullptr || trail->getPoints().size() < 2 || cellSize() <= 0)
+        return node;
+    SVVectorPoints points(trail->getPoints());
+    if (node->trail == nullptr) {
+        node->trail = SVLineNode::create(window());
+        trailRebuild = true;
+    }
+    //only new vertices are uploaded, the previous last point is a vertex now
+    if (trailRebuild || trailSerial != trail->getSerial())  {
+        node->trail->setLine(points, 0);
+    }   else    {
+        node->trail->moveLast(points.at(trailSynced - 1));
+        if (!node->trail->appendLine(points, trailSynced))
+            node->trail->setLine(points, 0);
+    }
+    trailRebuild = false;
+    trailSynced = points.size();
+    trailSerial = trail->getSerial();
+    node->trail->setColor(trailColor);
+    node->trail->setDataTransform(trailTransform());
+    node->trail->setSize(QSizeF(width(), height()));
+    node->appendChildNode(node->trail->node());
+    return node;
+}
+
+//cells -> item coordinates, the same as mapToView()
+QMatrix4x4 SVMapItem::trailTransform() const    {
+    qreal scale = cellSize();
+    QMatrix4x4 matrix;
+    matrix.translate(static_cast<float>(width() / 2 - center.x() * scale),
+                     static_cast<float>(height() / 2 - center.y() * scale));
+    matrix.scale(static_cast<float>(scale));
+    return matrix;
+}
+
+void SVMapItem::geometryChanged(QRectF const& newGeometry, QRectF const& oldGeometry)  {
+    QQuickItem::geometryChanged(newGeometry, oldGeometry);
+    emit signalViewChanged();
+    updateView();
+}
+
+void SVMapItem::mousePressEvent(QMouseEvent *event) {
+    pressPos = event->localPos();
+    //the swipe view of the pages shouldn't take the drag
+    setKeepMouseGrab(true);
+    event->accept();
+}
+
+//drags the map
+void SVMapItem::mouseMoveEvent(QMouseEvent *event)  {
+    if (!(event->buttons() & Qt::LeftButton))
+        return;
+    QPointF delta = event->localPos() - pressPos;
+    pressPos = event->localPos();
+    pan(delta.x(), delta.y());
+}
+
+void SVMapItem::mouseReleaseEvent(QMouseEvent *event)  {
+    if (event->button() != Qt::RightButton)
+        return;
+    QPointF cell = viewToMap(event->localPos().x(), event->localPos().y());
+    int x = qFloor(cell.x());
+    int y = qFloor(cell.y());
+    if (x >= 0 && y >= 0 && x < mapWidth() && y < mapHeight())
+        emit signalCellClicked(x, y);
+}
+
+void SVMapItem::mouseDoubleClickEvent(QMouseEvent *event)   {
+    if (event->button() == Qt::LeftButton)
+        fit();
+}
+
+void SVMapItem::wheelEvent(QWheelEvent *event)  {
+    zoomAt(qPow(2.0, event->angleDelta().y() / 480.0), event->posF().x(), event->posF().y());
+    event->accept();
+}
@@ -0,0 +1,150 @@
+#ifndef SVMAPITEM_H
+#define SVMAPITEM_H
+
+#include <QQuickItem>
+#include <QQuickWindow>
+#include <QSGNode>
+#include <QSGImageNode>
+#include <QSGRectangleNode>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+#include <QImage>
+#include <QColor>
+#include <QVector>
+#include <QHash>
+#include <QByteArray>
+#include <QMatrix4x4>
+#include "trajectorytrail.h"
+
+//cells of one tile to fill the tile image in a worker thread
+struct SVMapTileJob {
+    QByteArray cells;   //copy of the tile cells row by row, the level may change meanwhile
+    int width = 0;
+    int height = 0;
+    QRgb empty = 0;
+    QRgb wall = 0;
+};
+
+/*
+ * Occupancy grid map rendered by the Qt Quick scene graph, with pan and zoom.
+ * Cells are kept as a pyramid of levels, every level is half of the previous one
+ * and a texel is a wall if any of its cells is a wall, so thin walls stay visible.
+ * Only the level and the tiles visible at the current pan and zoom are drawn,
+ * tile images (tileSize x tileSize texels) are built lazily in the thread pool
+ * and kept in a LRU cache of maxTiles, a coarser tile is shown until the tile is ready.
+ * The vehicle trail is one polyline node in cells, pan and zoom change only its matrix.
+ */
+class SVMapItem : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(int mapWidth READ mapWidth NOTIFY signalMapChanged)
+    Q_PROPERTY(int mapHeight READ mapHeight NOTIFY signalMapChanged)
+    Q_PROPERTY(qreal zoom READ zoom WRITE setZoom NOTIFY signalViewChanged)
+    Q_PROPERTY(qreal cellSize READ cellSize NOTIFY signalViewChanged)
+private:
+    static const int tileSize = 256;    //texels
+    static const int maxTiles = 192;    //cached tile images, 256 KB each
+    static const int maxJobs = 8;       //tiles building at once
+    static const int gridMinCell = 6;   //px, grid lines are drawn for larger cells only
+    static constexpr qreal minZoom = 0.5;
+    static constexpr qreal maxZoom = 64;
+
+    struct Level {
+        int width = 0;
+        int height = 0;
+        int tilesX = 0;
+        int tilesY = 0;
+        QByteArray cells;   //row by row, one byte per texel
+    };
+    struct Tile {
+        QImage image;
+        quint32 serial = 0;     //changes with the image, the texture is uploaded again
+        quint64 lastUsed = 0;   //frame when the tile was drawn
+        bool stale = false;     //cells changed, the image is shown until the new one is ready
+    };
+
+    //tile texels drawn into the item rect, made by updatePolish() for updatePaintNode()
+    struct Draw {
+        quint64 key;
+        QRectF source;
+        QRectF target;
+    };
+
+    QVector<Level> levels;
+    QHash<quint64, Tile> tiles;
+    QHash<quint64, QFutureWatcher<QImage>*> jobs;
+    quint32 serials = 0;
+    QHash<quint64, quint32> versions;   //changes with the cells of the tile
+    quint64 frame = 0;
+    int generation = 0;     //changes with the map, results of old jobs are dropped
+    QVector<Draw> draws;
+    QVector<QRectF> gridLines;
+
+    qreal _zoom = 1;        //1 - the whole map fits the item
+    QPointF center;         //cells
+    QPointF pressPos;
+
+    //trail is owned by the adapter of the shown session
+    TrajectoryTrail const* trail = nullptr;
+    bool trailRebuild = true;
+    int trailSynced = 0;        //points uploaded into the node
+    quint32 trailSerial = 0;
+
+    QColor emptyColor = QColor("white");
+    QColor wallColor = QColor("lightgray");
+    QColor gridColor = QColor("gray");
+    QColor trailColor = QColor("#4fc622");
+
+    static quint64 tileKey(int level, int tx, int ty);
+    static QImage buildTile(SVMapTileJob const& job);
+    void buildLevels();
+    void requestTile(int level, int tx, int ty);
+    void tileReady(quint64 key, int generation, quint32 version, QImage const& image);
+    void evictTiles();
+    Tile* readyTile(int level, int tx, int ty);
+    void updateView();
+    void clampCenter();
+    qreal fitScale() const;
+    QRectF visibleRect() const;
+    QMatrix4x4 trailTransform() const;
+public:
+    explicit SVMapItem(QQuickItem *parent = nullptr);
+
+    void setMap(int width, int height, QByteArray const& cells);
+    void setCell(int x, int y, qint8 cell);
+    qint8 cell(int x, int y) const;
+    void clear();
+    int mapWidth() const;
+    int mapHeight() const;
+    int pendingTiles() const;
+    void setTrail(TrajectoryTrail const* trail);
+    //new trail samples are shown with the next frame
+    void updateTrail();
+
+    qreal zoom() const;
+    void setZoom(qreal zoom);
+    qreal cellSize() const;
+    //map point (cells) -> item point (px) and back
+    Q_INVOKABLE QPointF mapToView(qreal x, qreal y) const;
+    Q_INVOKABLE QPointF viewToMap(qreal x, qreal y) const;
+    Q_INVOKABLE void zoomAt(qreal factor, qreal x, qreal y);
+    //moves the map by (dx, dy) px
+    Q_INVOKABLE void pan(qreal dx, qreal dy);
+    Q_INVOKABLE void fit();
+protected:
+    void updatePolish() override;
+    QSGNode* updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+    void geometryChanged(QRectF const& newGeometry, QRectF const& oldGeometry) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+signals:
+    void signalMapChanged();
+    void signalViewChanged();
+    //right click on the map cell
+    void signalCellClicked(int x, int y);
+};
+
+#endif // SVMAPITEM_H
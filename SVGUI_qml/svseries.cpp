@@ -1,92 +1,309 @@
 #include "svseries.h"
+#include "svtrace.h"
 
-SVSeries::SVSeries()
-{
+SVSeries::ShownPoints::ShownPoints(SVSeries const* owner) : owner(owner)  {}
 
+int SVSeries::ShownPoints::size() const {
+    return owner->shownVector ? owner->shownVector->size() : owner->points.size();
 }
 
-SVSeries::SVSeries(QObject *series, Filter::FilterType type) {
-    this->series = dynamic_cast<QtCharts::QLineSeries*>(series);
-    switch (type)   {
-    case Filter::NONE:   {
-        break;
-    }
-    case Filter::KALMAN:    {
-        filter = new FilterKalman();
-        break;
-    }
-    case Filter::GAF:   {
-        filter = new FilterGA();
-        break;
-    }
-    }
+QPointF SVSeries::ShownPoints::at(int index) const  {
+    if (owner->shownVector)
+        return owner->shownVector->at(index);
+    SVPoint const& point = owner->points.at(index);
+    return QPointF(static_cast<double>(point.x), static_cast<double>(point.y));
+}
+
+SVSeries::SVSeries() : shown(this) {}
+
+SVSeries::SVSeries(QObject *series, Filter::FilterType type) : shown(this)  {
+    setSeriesObj(series);
+    setFilter(type);
 }
 
 SVSeries::~SVSeries()   {
+    setSeriesObj(nullptr);
     delete filter;
 }
 
+//attaches a chart series (QLineSeries or SVChartItem) and fills it by already collected points
+//the storage is kept after detaching, so the chart gets its points back when it is shown again
 void SVSeries::setSeriesObj(QObject *series)    {
-    this->series = dynamic_cast<QtCharts::QLineSeries*>(series);
+    //the chart may be attached to a series of another vehicle already
+    if (chart && chart->pointSource() == &shown)
+        chart->setPointSource(nullptr);
+    this->series = qobject_cast<QtCharts::QLineSeries*>(series);
+    this->chart = qobject_cast<SVChartItem*>(series);
+    if (!isAttached())
+        return;
+    allocate();
+
+    if (chart)
+        chart->setPointSource(&shown);
+    sinkReplace();
+    decimated = false;
+    if (autoScale)
+        setAxisY(-chartAmp, chartAmp);
+    int axisStart = points.isEmpty() || points.last().x <= chartTimeRange ? 0 : chartAxisStart;
+    setAxisX(axisStart, axisStart + chartTimeRange);
+}
+
+void SVSeries::allocate()   {
+    if (allocated)
+        return;
+    allocated = true;
+    points.setCapacity(capacity);
+    raw.setCapacity(capacity);
+    pending.setCapacity(pendingCapacity);
+    pyramid.setCapacity(capacity);
+    filterBuffer.resize(pendingCapacity);
+}
+
+bool SVSeries::isAttached() const   {
+    return series || chart;
+}
+
+//shows the vector or the storage (nullptr), the scene graph chart reads the points itself
+void SVSeries::sinkReplace(QVector<QPointF> const* vector)   {
+    shownVector = vector;
+    if (series)
+        series->replace(vector ? *vector : toVector());
+    else if (chart)
+        chart->replace(shown.size());
+}
+
+//appends the last count points of the flush
+void SVSeries::sinkAppend(int count)    {
+    if (series) {
+        flushPoints.erase(flushPoints.begin(), flushPoints.end() - qMin(count, flushPoints.size()));
+        series->append(flushPoints);
+    }   else if (chart) {
+        chart->append(count);
+    }
+}
+
+void SVSeries::sinkRemoveFront(int count)   {
+    if (series)
+        series->removePoints(0, count);
+    else if (chart)
+        chart->removeFront(count);
+}
+
+int SVSeries::sinkCount() const {
+    if (series)
+        return series->count();
+    if (chart)
+        return chart->count();
+    return 0;
+}
+
+void SVSeries::setAxisX(qreal min, qreal max)   {
+    if (chart)  {
+        chart->setXRange(min, max);
+    }   else if (series && series->attachedAxes().size() > 0)   {
+        series->attachedAxes().at(0)->setMax(max);
+        series->attachedAxes().at(0)->setMin(min);
+    }
+}
+
+void SVSeries::setAxisY(qreal min, qreal max)   {
+    if (chart)  {
+        chart->setYRange(min, max);
+    }   else if (series && series->attachedAxes().size() > 1)   {
+        series->attachedAxes().at(1)->setMax(max);
+        series->attachedAxes().at(1)->setMin(min);
+    }
+}
+
+//visible time range and the plot width in pixels
+bool SVSeries::visibleWindow(float &t0, float &t1, int &columns) const  {
+    if (chart)  {
+        t0 = static_cast<float>(chart->xMin());
+        t1 = static_cast<float>(chart->xMax());
+        columns = static_cast<int>(chart->width());
+        return columns > 0;
+    }
+    if (series == nullptr || series->chart() == nullptr || series->attachedAxes().isEmpty())
+        return false;
+    QtCharts::QValueAxis *axisX = qobject_cast<QtCharts::QValueAxis*>(series->attachedAxes().first());
+    if (axisX == nullptr)
+        return false;
+    t0 = static_cast<float>(axisX->min());
+    t1 = static_cast<float>(axisX->max());
+    columns = static_cast<int>(series->chart()->plotArea().width());
+    return columns > 0;
 }
 
 QtCharts::QLineSeries* SVSeries::getSeriesPtr() {
     return series;
 }
 
+QVector<QPointF> SVSeries::toVector() const  {
+    QVector<QPointF> vector;
+    vector.reserve(points.size());
+    for (int i = 0; i < points.size(); i++)
+        vector.append(QPointF(points.at(i).x, points.at(i).y));
+    return vector;
+}
+
+//binary search for the first stored point at or after the time
+int SVSeries::lowerBound(float time) const  {
+    int low = 0;
+    int high = points.size();
+    while (low < high)  {
+        int middle = (low + high) / 2;
+        if (points.at(middle).x < time)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+//chooses the pyramid level for the visible window and the plot width
+//decimated window is replaced as a whole, it has about 2 points per pixel column
+//returns false if raw points should be shown
+bool SVSeries::updateDecimation()   {
+    float t0 = 0;
+    float t1 = 0;
+    int columns = 0;
+    if (!visibleWindow(t0, t1, columns))
+        return false;
+
+    int rawCount = lowerBound(t1) - lowerBound(t0);
+    int level = 0;
+    while ((rawCount >> level) > columns)
+        level++;
+    if (level == 0)
+        return false;
+
+    pyramid.decimate(level, t0, t1, lodPoints);
+    sinkReplace(&lodPoints);
+    return true;
+}
+
+//drops points which are older than the visible window with margin
+//returns count of dropped points
+int SVSeries::evictOld()    {
+    int evicted = 0;
+    float minTime = chartAxisStart - marginTime;
+    while (evicted < points.size() && points.at(evicted).x < minTime)
+        evicted++;
+    points.popFront(evicted);
+    raw.popFront(evicted);
+    return evicted;
+}
+
+//stages the point until the next frame
 void SVSeries::addPoint(QPointF const &point)  {
-    double time = point.x();
-    double value = point.y();
-
-    if (filter && !points.empty()) {
-        value = filter->calculate(points.last().y(), value);
-        points.append(QPointF(time, value));
-    }   else {
-        points.append(point);
+    SV_TRACE("SVSeries::addPoint");
+    if (!allocated)
+        return;
+    SVPoint newPoint;
+    newPoint.x = static_cast<float>(point.x());
+    newPoint.y = static_cast<float>(point.y());
+    pending.push(newPoint);
+}
+
+//moves staged points into the storage and pushes only them (and evicted points) into the chart series
+//called once per frame, so chart relayouts don't depend on the telemetry rate
+void SVSeries::flush()  {
+    SV_TRACE("SVSeries::flush");
+    if (refilter.isReady())
+        applyRefilter();
+    if (pending.isEmpty())
+        return;
+
+    if (filter) {
+        for (int i = 0; i < pending.size(); i++)
+            filterBuffer[i] = pending.at(i).y;
+        filter->process(filterBuffer.constData(), filterBuffer.data(), pending.size());
+    }
+
+    int evicted = 0;
+    float maxAbs = 0;
+    int appended = pending.size();
+    flushPoints.clear();
+    for (int i = 0; i < pending.size(); i++)    {
+        SVPoint point = pending.at(i);
+        if (filter)
+            point.y = filterBuffer.at(i);
+        raw.push(pending.at(i).y);
+        pushed++;
+        if (points.push(point))
+            evicted++;
+        pyramid.append(point.x, point.y);
+        maxAbs = qMax(maxAbs, qAbs(point.y));
+        if (series)
+            flushPoints.append(QPointF(point.x, point.y));
     }
+    float time = pending.last().x;
+    pending.clear();
 
-    if (time > chartTimeRange + chartAxisStart)
+    while (time > chartTimeRange + chartAxisStart)
         chartAxisStart += chartTimeInc;
+    evicted += evictOld();
+
+    bool ampChanged = false;
+    if (maxAbs >= chartAmp && autoScale) {
+        chartAmp = static_cast<int>(maxAbs) + chartAmpInc;
+        ampChanged = true;
+    }
+
+    if (isAttached() && live)   {
+        if (time > chartTimeRange)
+            setAxisX(chartAxisStart, chartAxisStart + chartTimeRange);
+        if (ampChanged)
+            setAxisY(-chartAmp, chartAmp);
 
-    if (series)  {
-        series->replace(points);
-        if (time > chartTimeRange) {
-            series->attachedAxes().first()->setMax(chartAxisStart + chartTimeRange);
-            series->attachedAxes().first()->setMin(chartAxisStart);
+        if (updateDecimation()) {
+            decimated = true;
+            return;
         }
-        if (abs(value) >= chartAmp && autoScale) {
-            chartAmp = static_cast<int>(abs(value)) + chartAmpInc;
-            series->attachedAxes().at(1)->setMax(chartAmp);
-            series->attachedAxes().at(1)->setMin(-chartAmp);
+        if (decimated)  {
+            //back to the raw points, the series shows the storage again
+            sinkReplace();
+            decimated = false;
+            return;
         }
+
+        //points evicted in this flush may be not in the series yet
+        int removed = qMin(evicted, sinkCount());
+        if (removed)
+            sinkRemoveFront(removed);
+        sinkAppend(appended - qMin(evicted - removed, appended));
     }
 }
 
 QPointF SVSeries::at(long pos) const    {
-    return points.at(pos);
+    SVPoint const& point = points.at(static_cast<int>(pos));
+    return QPointF(point.x, point.y);
 }
 
 QPointF SVSeries::last() const  {
-    return points.last();
+    return QPointF(points.last().x, points.last().y);
 }
 
 void SVSeries::clear()    {
-    if (series != nullptr)
-        series->clear();
-
+    refilter.cancel();
     points.clear();
+    raw.clear();
+    pending.clear();
+    pyramid.clear();
+    decimated = false;
+    if (filter)
+        filter->reset();
 
     chartAxisStart = 0;
     chartStartTime = 0;
     chartAmp = chartStartAmp;
-    if (autoScale)  {
-        series->attachedAxes().at(1)->setMax(chartAmp);
-        series->attachedAxes().at(1)->setMin(-chartAmp);
-    }
+    if (!isAttached())
+        return;
 
-
-    series->attachedAxes().at(0)->setMax(chartTimeRange);
-    series->attachedAxes().at(0)->setMin(0);
+    sinkReplace();
+    if (autoScale)
+        setAxisY(-chartAmp, chartAmp);
+    setAxisX(0, chartTimeRange);
 }
 
 int SVSeries::size() const    {
@@ -97,42 +314,141 @@ void SVSeries::setAutoScale(bool autoScale) {
     this->autoScale = autoScale;
 }
 
-void SVSeries::setFilter(Filter::FilterType type)   {
-    delete filter;
+//sets max count of stored points
+void SVSeries::setCapacity(int capacity)    {
+    this->capacity = capacity;
+    if (!allocated)
+        return;
+    points.setCapacity(capacity);
+    raw.setCapacity(capacity);
+    pyramid.setCapacity(capacity);
+    refresh();
+}
 
-    switch (type)   {
-    case Filter::NONE:   {
-        break;
-    }
-    case Filter::KALMAN:    {
-        filter = new FilterKalman();
-        break;
-    }
-    case Filter::GAF:   {
-        filter = new FilterGA();
-        break;
+//rebuilds the pyramid and the chart series from the stored points
+void SVSeries::refresh()    {
+    pyramid.clear();
+    for (int i = 0; i < points.size(); i++)
+        pyramid.append(points.at(i).x, points.at(i).y);
+    decimated = false;
+    if (isAttached() && live)
+        sinkReplace();
+}
+
+//recomputes the stored points by the current filter in background,
+//the chart keeps the old values until the whole result is ready
+void SVSeries::startRefilter()  {
+    if (filter == nullptr)  {
+        refilter.cancel();
+        for (int i = 0; i < points.size(); i++)
+            points[i].y = raw.at(i);
+        refresh();
+        return;
     }
+
+    QVector<float> snapshot(raw.size());
+    for (int i = 0; i < raw.size(); i++)
+        snapshot[i] = raw.at(i);
+    refilter.start(filter, snapshot, pushed);
+}
+
+//publishes the re-filtered points at once, points stored while the job was running
+//are filtered by the job's filter which continues from the end of the snapshot
+void SVSeries::applyRefilter()  {
+    QVector<float> filtered;
+    qint64 end = 0;
+    Filter *state = refilter.take(filtered, end);
+    if (state == nullptr)
+        return;
+
+    qint64 snapshotBegin = end - filtered.size();
+    qint64 firstStored = pushed - points.size();
+    for (int i = 0; i < points.size(); i++) {
+        qint64 index = firstStored + i;
+        if (index < snapshotBegin)
+            continue;
+        if (index < end)
+            points[i].y = filtered.at(static_cast<int>(index - snapshotBegin));
+        else
+            points[i].y = state->process(raw.at(i));
     }
+    delete filter;
+    filter = state;
+    refresh();
 }
 
-bool SVSeries::setFilterK(float k)    {
+int SVSeries::plotColumns() const   {
+    float t0 = 0;
+    float t1 = 0;
+    int columns = 0;
+    visibleWindow(t0, t1, columns);
+    return columns;
+}
+
+//shows the stored history instead of the live window, new points are still collected
+//history is filtered by a fresh copy of the current filter; a reduced history (min/max pairs)
+//is filtered as it is, so the filtered history of a wide range is approximate
+void SVSeries::showHistory(QVector<QPointF> const& history, float t0, float t1) {
+    live = false;
+    if (!isAttached())
+        return;
+
     if (filter) {
-        switch (filter->getType())  {
-        case Filter::NONE:  {
-            return false;
-        }
-        case Filter::KALMAN: {
-            dynamic_cast<FilterKalman*>(filter)->setK(k);
-            return true;
-        }
-        case Filter::GAF:   {
-            return false;
-        }
-    }
+        Filter *historyFilter = filter->clone();
+        historyFilter->reset();
+        historyPoints = history;
+        for (QPointF &point : historyPoints)
+            point.setY(static_cast<double>(historyFilter->process(static_cast<float>(point.y()))));
+        delete historyFilter;
+    }   else    {
+        historyPoints = history;
     }
-    return false;
+    sinkReplace(&historyPoints);
+    setAxisX(t0, t1);
+    decimated = true;
+}
+
+//returns to the live window
+void SVSeries::showLive()   {
+    if (live)
+        return;
+    live = true;
+    historyPoints.clear();
+    if (!isAttached())
+        return;
+    sinkReplace();
+    decimated = false;
+    int axisStart = points.isEmpty() || points.last().x <= chartTimeRange ? 0 : chartAxisStart;
+    setAxisX(axisStart, axisStart + chartTimeRange);
+}
+
+bool SVSeries::isLive() const   {
+    return live;
+}
+
+//sets how long points are kept after leaving the visible window
+void SVSeries::setMargin(int seconds)   {
+    marginTime = seconds;
+}
+
+//replaces the filter, stored points are re-filtered by the new one
+void SVSeries::setFilter(Filter::FilterType type)   {
+    delete filter;
+    filter = Filter::create(type);
+    if (filter)
+        filter->setK(filterK);
+    startRefilter();
+}
+
+//sets the smoothing parameter of the filter, returns false if the filter has no such parameter
+bool SVSeries::setFilterK(float k)    {
+    filterK = k;
+    if (filter == nullptr || !filter->setK(k))
+        return false;
+    startRefilter();
+    return true;
 }
 
 Filter::FilterType SVSeries::filterType() const {
-    return filter->getType();
+    return filter ? filter->getType() : Filter::NONE;
 }
@@ -2,26 +2,94 @@
 #define SVSERIES_H
 
 #include <QObject>
+#include <QPointer>
 #include <QPointF>
 #include <QLineSeries>
+#include <QValueAxis>
+#include <QChart>
 #include "filter.h"
+#include "ringbuffer.h"
+#include "lodpyramid.h"
+#include "svchartitem.h"
+#include "refilter.h"
+
+//compact chart point, time in seconds from the chart start
+struct SVPoint  {
+    float x = 0;
+    float y = 0;
+};
 
 class SVSeries
 {
 private:
+    //points shown by the scene graph chart, it reads them instead of keeping a copy
+    class ShownPoints : public SVLinePoints
+    {
+    private:
+        SVSeries const* owner;
+    public:
+        explicit ShownPoints(SVSeries const* owner);
+        int size() const override;
+        QPointF at(int index) const override;
+    };
+
     static const int chartTimeRange = 60;
     static const int chartTimeInc = 10;
     static const int chartStartAmp = 10;
     static const int chartAmpInc = 2;
+    static const int defaultCapacity = 65536;
+    static const int pendingCapacity = 4096;
     bool autoScale = true;
+    //storage is allocated when a chart attaches for the first time,
+    //serieses which are never shown keep no points
+    int capacity = defaultCapacity;
+    bool allocated = false;
 
-    QtCharts::QLineSeries *series;
-    QVector<QPointF> points;
+    //points are shown either by QtCharts series or by the scene graph chart item
+    QtCharts::QLineSeries *series = nullptr;
+    QPointer<SVChartItem> chart;    //QML items may be destroyed before the series
+    ShownPoints shown;
+    QVector<QPointF> const* shownVector = nullptr;  //decimated or history points, nullptr - the storage
+    //only visible window and margin are stored, the chart series mirrors this buffer
+    RingBuffer<SVPoint> points;
+    //raw values of the stored points to re-filter them when the filter changes
+    RingBuffer<float> raw;
+    qint64 pushed = 0;  //count of points ever stored
+    //points are staged here between frames and flushed all at once
+    RingBuffer<SVPoint> pending;
+    QList<QPointF> flushPoints;
+    //min/max levels to show about 2 points per pixel column when the window is too dense
+    LodPyramid pyramid;
+    QVector<QPointF> lodPoints;
+    QVector<QPointF> historyPoints;
+    bool decimated = false;
+    int marginTime = chartTimeInc;  //sec
     int chartAmp = chartStartAmp;
     int chartAxisStart = 0;
     quint32 chartStartTime = 0; //msec
 
     Filter* filter = nullptr;
+    float filterK = 0.5;
+    QVector<float> filterBuffer;    //staged values filtered as one block
+    Refilter refilter;
+    bool live = true;   //false while the history is shown
+
+    void allocate();
+    int evictOld();
+    int lowerBound(float time) const;
+    QVector<QPointF> toVector() const;
+    bool updateDecimation();
+    void refresh();
+    void startRefilter();
+    void applyRefilter();
+
+    void sinkReplace(QVector<QPointF> const* vector = nullptr);
+    void sinkAppend(int count);
+    void sinkRemoveFront(int count);
+    int sinkCount() const;
+    void setAxisX(qreal min, qreal max);
+    void setAxisY(qreal min, qreal max);
+    bool visibleWindow(float &t0, float &t1, int &columns) const;
 public:
     SVSeries();
     SVSeries(QObject *series, Filter::FilterType type = Filter::NONE);
@@ -30,11 +98,20 @@ public:
     void setSeriesObj(QObject *series);
     QtCharts::QLineSeries* getSeriesPtr();
     void addPoint(QPointF const& point);
+    void flush();
     QPointF at(long pos) const;
     QPointF last() const;
     void clear();
     int size() const;
     void setAutoScale(bool autoScale);
+    void setCapacity(int capacity);
+    void setMargin(int seconds);
+    int plotColumns() const;
+
+    bool isAttached() const;
+    void showHistory(QVector<QPointF> const& history, float t0, float t1);
+    void showLive();
+    bool isLive() const;
 
     void setFilter(Filter::FilterType type);
     bool setFilterK(float k);
@@ -0,0 +1,252 @@
+#include "telemetryexporter.h"
+#include <cstring>
+
+TelemetryExporter::TelemetryExporter(QObject *parent) : QThread(parent), queue(queueCapacity)  {
+    highBlock.reserve(blockRecords);
+    lowBlock.reserve(blockRecords);
+}
+
+TelemetryExporter::~TelemetryExporter() {
+    stopExport();
+}
+
+bool TelemetryExporter::startExport(QString const& basePath, int formats) {
+    if (isRunning() || !(formats & (CSV | BINARY)))
+        return false;
+
+    if (formats & CSV)  {
+        csvFile.setFileName(basePath + ".csv");
+        if (!csvFile.open(QIODevice::WriteOnly | QIODevice::Truncate))  {
+            qDebug() << "Exporter: can't open " << csvFile.fileName();
+            return false;
+        }
+        csvFile.write("type,timestamp,encoder,steering,x,y,angle,state,motor_battery,comp_battery,temperature\n");
+    }
+    if (formats & BINARY)   {
+        binaryFile.setFileName(basePath + ".svtx");
+        if (!binaryFile.open(QIODevice::WriteOnly | QIODevice::Truncate))   {
+            qDebug() << "Exporter: can't open " << binaryFile.fileName();
+            csvFile.close();
+            return false;
+        }
+        binaryStream.setDevice(&binaryFile);
+        binaryStream.setByteOrder(QDataStream::LittleEndian);
+        binaryStream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+        binaryStream.writeRawData("SVTX", 4);
+        binaryStream << binaryVersion;
+    }
+
+    queue.clear();
+    stopping = false;
+    dropped = 0;
+    written = 0;
+    start(QThread::LowPriority);
+    return true;
+}
+
+void TelemetryExporter::stopExport()    {
+    if (!isRunning())
+        return;
+    mutex.lock();
+    stopping = true;
+    queueNotEmpty.wakeOne();
+    mutex.unlock();
+    wait();
+}
+
+bool TelemetryExporter::isExporting() const {
+    return isRunning();
+}
+
+//called by the receiving thread, never blocks on the writer
+void TelemetryExporter::push(HighFreqDataPackage const& data)  {
+    if (!isRunning())
+        return;
+    Record record;
+    record.type = HighFreqDataPackage::packageType;
+    record.timeStamp = data.timeStamp;
+    record.values[0] = data.m_encoderValue;
+    record.values[1] = data.m_steeringAngle;
+    record.values[2] = data.x;
+    record.values[3] = data.y;
+    record.values[4] = data.angle;
+
+    QMutexLocker locker(&mutex);
+    if (queue.isFull()) {
+        dropped.ref();
+        return;
+    }
+    queue.push(record);
+    queueNotEmpty.wakeOne();
+}
+
+void TelemetryExporter::push(LowFreqDataPackage const& data)   {
+    if (!isRunning())
+        return;
+    Record record;
+    record.type = LowFreqDataPackage::packageType;
+    record.timeStamp = data.timeStamp;
+    record.state = data.stateType;
+    record.values[0] = data.m_temp;
+    record.batteries[0] = data.m_motorBatteryPerc;
+    record.batteries[1] = data.m_compBatteryPerc;
+
+    QMutexLocker locker(&mutex);
+    if (queue.isFull()) {
+        dropped.ref();
+        return;
+    }
+    queue.push(record);
+    queueNotEmpty.wakeOne();
+}
+
+int TelemetryExporter::droppedCount() const {
+    return dropped.load();
+}
+
+quint64 TelemetryExporter::writtenCount() const {
+    return written;
+}
+
+//takes records by batches, so the lock is held only for copying
+void TelemetryExporter::run()   {
+    QVector<Record> batch;
+    batch.reserve(batchSize);
+    forever {
+        batch.clear();
+        mutex.lock();
+        while (queue.isEmpty() && !stopping)
+            queueNotEmpty.wait(&mutex);
+        int count = qMin(queue.size(), static_cast<int>(batchSize));
+        for (int i = 0; i < count; i++)
+            batch.append(queue.at(i));
+        queue.popFront(count);
+        bool finished = stopping && queue.isEmpty();
+        mutex.unlock();
+
+        if (csvFile.isOpen())
+            writeCsv(batch);
+        if (binaryFile.isOpen())
+            writeBinary(batch);
+        written += static_cast<quint64>(batch.size());
+        if (finished)
+            break;
+    }
+
+    if (binaryFile.isOpen())    {
+        writeBlock(highBlock);
+        writeBlock(lowBlock);
+        binaryFile.close();
+    }
+    if (csvFile.isOpen())
+        csvFile.close();
+    qDebug() << "Exporter: written " << written << " records, dropped " << dropped.load();
+}
+
+void TelemetryExporter::writeCsv(QVector<Record> const& batch) {
+    QByteArray text;
+    text.reserve(batch.size() * 96);
+    for (Record const& record : batch)  {
+        text += QByteArray::number(record.type) + ',' + QByteArray::number(record.timeStamp) + ',';
+        if (record.type == HighFreqDataPackage::packageType)   {
+            for (int i = 0; i < 5; i++)
+                text += QByteArray::number(static_cast<double>(record.values[i]), 'g', 7) + ',';
+            text += ",,,\n";
+        }   else    {
+            text += ",,,,,";
+            text += QByteArray::number(record.state) + ',' + QByteArray::number(record.batteries[0]) + ',' +
+                    QByteArray::number(record.batteries[1]) + ',' +
+                    QByteArray::number(static_cast<double>(record.values[0]), 'g', 7) + '\n';
+        }
+    }
+    csvFile.write(text);
+}
+
+void TelemetryExporter::writeBinary(QVector<Record> const& batch)  {
+    for (Record const& record : batch)  {
+        QVector<Record> &block = record.type == HighFreqDataPackage::packageType ? highBlock : lowBlock;
+        block.append(record);
+        if (block.size() == blockRecords)
+            writeBlock(block);
+    }
+}
+
+//one column after another, so every field is contiguous in the file
+void TelemetryExporter::writeBlock(QVector<Record> &block)  {
+    if (block.isEmpty())
+        return;
+    qint8 type = block.first().type;
+    binaryStream << type << static_cast<quint32>(block.size());
+    for (Record const& record : block)
+        binaryStream << record.timeStamp;
+    if (type == HighFreqDataPackage::packageType)  {
+        for (int column = 0; column < 5; column++)
+            for (Record const& record : block)
+                binaryStream << record.values[column];
+    }   else    {
+        for (Record const& record : block)
+            binaryStream << record.state;
+        for (int column = 0; column < 2; column++)
+            for (Record const& record : block)
+                binaryStream << record.batteries[column];
+        for (Record const& record : block)
+            binaryStream << record.values[0];
+    }
+    block.clear();
+}
+
+bool TelemetryExporter::readBinary(QString const& path, TelemetryColumns &highFreq, QVector<LowFreqDataPackage> &lowFreq) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))    {
+        qDebug() << "Exporter: can't open " << path;
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    char magic[4];
+    quint16 version = 0;
+    if (stream.readRawData(magic, 4) != 4 || std::memcmp(magic, "SVTX", 4) != 0)
+        return false;
+    stream >> version;
+    if (version != binaryVersion)
+        return false;
+
+    while (!stream.atEnd()) {
+        qint8 type = 0;
+        quint32 count = 0;
+        stream >> type >> count;
+        //blocks are never longer, a larger count is a broken file
+        if (stream.status() != QDataStream::Ok || count > static_cast<quint32>(blockRecords))
+            return false;
+        int size = static_cast<int>(count);
+        if (type == HighFreqDataPackage::packageType)  {
+            int first = highFreq.size();
+            highFreq.resize(first + size);
+            for (int i = 0; i < size; i++)
+                stream >> highFreq.timeStamps[first + i];
+            QVector<float> *columns[5] = {&highFreq.encoder, &highFreq.steering, &highFreq.x, &highFreq.y, &highFreq.angle};
+            for (QVector<float> *column : columns)
+                for (int i = 0; i < size; i++)
+                    stream >> (*column)[first + i];
+        }   else if (type == LowFreqDataPackage::packageType)   {
+            int first = lowFreq.size();
+            lowFreq.resize(first + size);
+            for (int i = 0; i < size; i++)
+                stream >> lowFreq[first + i].timeStamp;
+            for (int i = 0; i < size; i++)
+                stream >> lowFreq[first + i].stateType;
+            for (int i = 0; i < size; i++)
+                stream >> lowFreq[first + i].m_motorBatteryPerc;
+            for (int i = 0; i < size; i++)
+                stream >> lowFreq[first + i].m_compBatteryPerc;
+            for (int i = 0; i < size; i++)
+                stream >> lowFreq[first + i].m_temp;
+        }   else    {
+            return false;
+        }
+        if (stream.status() != QDataStream::Ok)
+            return false;
+    }
+    return true;
+}
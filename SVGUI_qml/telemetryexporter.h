@@ -0,0 +1,82 @@
+#ifndef TELEMETRYEXPORTER_H
+#define TELEMETRYEXPORTER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QFile>
+#include <QVector>
+#include <QDataStream>
+#include <QDebug>
+#include "datapackage.h"
+#include "telemetrybatch.h"
+#include "ringbuffer.h"
+
+/*
+ * Writes received telemetry packages to CSV and/or columnar binary files.
+ * Packages are queued by the receiving thread and written by the exporter thread.
+ * The queue is bounded: if the writer falls behind, new packages are dropped and
+ * counted, so the export never stalls the receiving.
+ *
+ * Binary format (little endian): "SVTX", quint16 version, then blocks of
+ * quint8 package type, quint32 count and one column per field:
+ * high freq - timeStamp (u32), encoder, steering, x, y, angle (f32);
+ * low freq - timeStamp (u32), state (i8), motor battery, comp battery (u32), temperature (f32).
+ */
+class TelemetryExporter : public QThread
+{
+    Q_OBJECT
+public:
+    enum Format { CSV = 1, BINARY = 2 };
+
+    struct Record   {
+        qint8 type = 0;
+        quint32 timeStamp = 0;
+        qint8 state = 0;
+        float values[5] = {};    //high freq: encoder, steering, x, y, angle; low freq: temperature
+        quint32 batteries[2] = {};
+    };
+private:
+    static const int queueCapacity = 65536;
+    static const int batchSize = 1024;     //records taken from the queue at once
+    static const int blockRecords = 4096;  //records of a binary block
+    static const quint16 binaryVersion = 1;
+
+    QMutex mutex;
+    QWaitCondition queueNotEmpty;
+    RingBuffer<Record> queue;
+    bool stopping = false;
+    QAtomicInt dropped;
+    quint64 written = 0;
+
+    QFile csvFile;
+    QFile binaryFile;
+    QDataStream binaryStream;
+    QVector<Record> highBlock;
+    QVector<Record> lowBlock;
+
+    void run() override;
+    void writeCsv(QVector<Record> const& batch);
+    void writeBinary(QVector<Record> const& batch);
+    void writeBlock(QVector<Record> &block);
+public:
+    explicit TelemetryExporter(QObject *parent = nullptr);
+    ~TelemetryExporter() override;
+
+    //opens basePath.csv and/or basePath.svtx and starts the writer thread
+    bool startExport(QString const& basePath, int formats);
+    //writes everything queued and closes the files
+    void stopExport();
+    bool isExporting() const;
+
+    void push(HighFreqDataPackage const& data);
+    void push(LowFreqDataPackage const& data);
+    int droppedCount() const;
+    quint64 writtenCount() const;
+
+    //reads a binary export back, by blocks: the samples of a type keep their order, the types are not interleaved
+    static bool readBinary(QString const& path, TelemetryColumns &highFreq, QVector<LowFreqDataPackage> &lowFreq);
+};
+
+#endif // TELEMETRYEXPORTER_H
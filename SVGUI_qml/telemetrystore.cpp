@@ -0,0 +1,264 @@
+#include "telemetrystore.h"
+
+//by default every store gets its own directory in the cache location
+TelemetryStore::TelemetryStore(QString const& path)  {
+    QString storePath = path;
+    if (storePath.isEmpty())    {
+        storePath = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/telemetry/" +
+                QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss-zzz") + "-" +
+                QString::number(reinterpret_cast<quintptr>(this), 16);
+    }
+    directory = QDir(storePath);
+    if (!directory.mkpath("."))
+        qDebug() << "Telemetry store: can't create directory " << storePath;
+}
+
+TelemetryStore::~TelemetryStore()   {
+    for (Channel *channel : channels)   {
+        unmapReadChunks(channel);
+        if (channel->writeChunk)
+            channel->file->unmap(channel->writeChunk);
+        channel->file->remove();
+        delete channel->file;
+        delete channel;
+    }
+    directory.removeRecursively();
+}
+
+double* TelemetryStore::times(uchar *chunk) {
+    return reinterpret_cast<double*>(chunk);
+}
+
+float* TelemetryStore::values(uchar *chunk) {
+    return reinterpret_cast<float*>(chunk + chunkRecords * sizeof(double));
+}
+
+int TelemetryStore::channel(QString const& name)    {
+    for (int i = 0; i < channels.size(); i++)
+        if (channels.at(i)->name == name)
+            return i;
+
+    Channel *channel = new Channel();
+    channel->name = name;
+    channel->file = new QFile(directory.filePath(name + ".svt"));
+    if (!channel->file->open(QIODevice::ReadWrite | QIODevice::Truncate))
+        qDebug() << "Telemetry store: can't open " << channel->file->fileName();
+    channels.append(channel);
+    return channels.size() - 1;
+}
+
+int TelemetryStore::channelCount() const   {
+    return channels.size();
+}
+
+QString TelemetryStore::channelName(int id) const   {
+    return channels.at(id)->name;
+}
+
+void TelemetryStore::unmapReadChunks(Channel *channel)  {
+    for (MappedChunk const& mapped : channel->readChunks)
+        channel->file->unmap(mapped.data);
+    channel->readChunks.clear();
+}
+
+//records in the chunk, only the last chunk may be incomplete
+int TelemetryStore::chunkSize(Channel const* channel, int chunk) const {
+    if (chunk < channel->chunkStart.size() - 1)
+        return chunkRecords;
+    return static_cast<int>(channel->count - static_cast<qint64>(chunk) * chunkRecords);
+}
+
+//returns the mapped chunk, old chunks are unmapped to keep resident memory bounded
+//the last chunk is the write chunk unless mapping of the next one has failed
+uchar* TelemetryStore::mapChunk(Channel *channel, int chunk)    {
+    if (chunk == channel->chunkStart.size() - 1 && channel->writeChunk)
+        return channel->writeChunk;
+
+    useCounter++;
+    for (MappedChunk &mapped : channel->readChunks)  {
+        if (mapped.chunk == chunk)  {
+            mapped.lastUse = useCounter;
+            return mapped.data;
+        }
+    }
+
+    if (channel->readChunks.size() >= maxMappedChunks)  {
+        int oldest = 0;
+        for (int i = 1; i < channel->readChunks.size(); i++)
+            if (channel->readChunks.at(i).lastUse < channel->readChunks.at(oldest).lastUse)
+                oldest = i;
+        channel->file->unmap(channel->readChunks.at(oldest).data);
+        channel->readChunks.remove(oldest);
+    }
+
+    MappedChunk mapped;
+    mapped.chunk = chunk;
+    mapped.lastUse = useCounter;
+    mapped.data = channel->file->map(static_cast<qint64>(chunk) * chunkBytes, chunkBytes, QFileDevice::MapPrivateOption);
+    if (mapped.data == nullptr)
+        return nullptr;
+    channel->readChunks.append(mapped);
+    return mapped.data;
+}
+
+void TelemetryStore::append(int id, double time, float value)   {
+    Channel *channel = channels.at(id);
+    int index = static_cast<int>(channel->count % chunkRecords);
+
+    if (index == 0) {
+        //starting a new chunk: the file grows by one chunk and only this chunk is mapped for writing
+        if (channel->writeChunk)
+            channel->file->unmap(channel->writeChunk);
+        unmapReadChunks(channel);
+        qint64 offset = static_cast<qint64>(channel->chunkStart.size()) * chunkBytes;
+        channel->writeChunk = nullptr;
+        if (channel->file->resize(offset + chunkBytes))
+            channel->writeChunk = channel->file->map(offset, chunkBytes);
+        if (channel->writeChunk == nullptr) {
+            qDebug() << "Telemetry store: can't map " << channel->file->fileName();
+            return;
+        }
+        channel->chunkStart.append(time);
+    }
+
+    times(channel->writeChunk)[index] = time;
+    values(channel->writeChunk)[index] = value;
+    if (channel->count % blockRecords == 0) {
+        Block block;
+        block.tAtMin = block.tAtMax = time;
+        block.min = block.max = value;
+        channel->blocks.append(block);
+    }   else    {
+        Block &block = channel->blocks.last();
+        if (value < block.min)  {
+            block.min = value;
+            block.tAtMin = time;
+        }
+        if (value > block.max)  {
+            block.max = value;
+            block.tAtMax = time;
+        }
+    }
+    channel->count++;
+}
+
+qint64 TelemetryStore::count(int id) const  {
+    return channels.at(id)->count;
+}
+
+bool TelemetryStore::timeRange(int id, double &first, double &last)  {
+    Channel *channel = channels.at(id);
+    if (channel->count == 0)
+        return false;
+    int lastChunk = channel->chunkStart.size() - 1;
+    uchar *data = mapChunk(channel, lastChunk);
+    if (data == nullptr)
+        return false;
+    first = channel->chunkStart.first();
+    last = times(data)[chunkSize(channel, lastChunk) - 1];
+    return true;
+}
+
+//index of the first record at or after the time
+qint64 TelemetryStore::lowerBound(Channel *channel, double time)   {
+    if (channel->count == 0)
+        return 0;
+
+    //the last chunk starting at or before the time
+    auto next = std::upper_bound(channel->chunkStart.constBegin(), channel->chunkStart.constEnd(), time);
+    int chunk = qMax(0, static_cast<int>(next - channel->chunkStart.constBegin()) - 1);
+
+    uchar *data = mapChunk(channel, chunk);
+    if (data == nullptr)
+        return static_cast<qint64>(chunk) * chunkRecords;
+    double const* chunkTimes = times(data);
+    int size = chunkSize(channel, chunk);
+    int index = static_cast<int>(std::lower_bound(chunkTimes, chunkTimes + size, time) - chunkTimes);
+    return static_cast<qint64>(chunk) * chunkRecords + index;
+}
+
+QVector<QPointF> TelemetryStore::read(int id, double t0, double t1, int maxBuckets, bool *reduced) {
+    QVector<QPointF> points;
+    Channel *channel = channels.at(id);
+    qint64 begin = lowerBound(channel, t0);
+    qint64 end = lowerBound(channel, std::nextafter(t1, t1 + 1));
+    qint64 total = end - begin;
+    if (reduced)
+        *reduced = false;
+    if (total <= 0 || maxBuckets <= 0)
+        return points;
+
+    //raw points if they fit, otherwise min and max of every bucket in time order
+    qint64 bucketSize = total <= 2 * maxBuckets ? 1 : (total + maxBuckets - 1) / maxBuckets;
+    //buckets of whole blocks are aligned to the blocks, so only the ends of the range are read record by record
+    bool summaries = bucketSize >= blockRecords;
+    if (summaries)
+        bucketSize = (bucketSize + blockRecords - 1) / blockRecords * blockRecords;
+    if (reduced)
+        *reduced = bucketSize > 1;
+    points.reserve(static_cast<int>(bucketSize == 1 ? total : 2 * maxBuckets + 4));
+
+    QPointF min, max;
+    qint64 inBucket = 0;
+    auto add = [&min, &max, &inBucket](QPointF const& low, QPointF const& high, qint64 records) {
+        if (inBucket == 0 || low.y() < min.y())
+            min = low;
+        if (inBucket == 0 || high.y() > max.y())
+            max = high;
+        inBucket += records;
+    };
+    auto emitBucket = [&]() {
+        points.append(min.x() <= max.x() ? min : max);
+        points.append(min.x() <= max.x() ? max : min);
+        inBucket = 0;
+    };
+
+    qint64 bucketEnd = summaries ? (begin / bucketSize + 1) * bucketSize : begin + bucketSize;
+    int mappedChunk = -1;
+    uchar *data = nullptr;
+    qint64 index = begin;
+    while (index < end) {
+        if (summaries && index % blockRecords == 0 && index + blockRecords <= qMin(end, bucketEnd)) {
+            Block const& block = channel->blocks.at(static_cast<int>(index / blockRecords));
+            add(QPointF(block.tAtMin, static_cast<double>(block.min)), QPointF(block.tAtMax, static_cast<double>(block.max)), blockRecords);
+            index += blockRecords;
+        }   else    {
+            int chunk = static_cast<int>(index / chunkRecords);
+            if (chunk != mappedChunk)   {
+                data = mapChunk(channel, chunk);
+                mappedChunk = chunk;
+            }
+            if (data == nullptr)
+                break;
+            int i = static_cast<int>(index % chunkRecords);
+            QPointF point(times(data)[i], static_cast<double>(values(data)[i]));
+            index++;
+            if (bucketSize == 1)    {
+                points.append(point);
+                continue;
+            }
+            add(point, point, 1);
+        }
+        if (index == bucketEnd) {
+            emitBucket();
+            bucketEnd += bucketSize;
+        }
+    }
+    if (inBucket)
+        emitBucket();
+    return points;
+}
+
+//drops all the stored records, files are truncated
+void TelemetryStore::clear()    {
+    for (Channel *channel : channels)   {
+        unmapReadChunks(channel);
+        if (channel->writeChunk)
+            channel->file->unmap(channel->writeChunk);
+        channel->writeChunk = nullptr;
+        channel->file->resize(0);
+        channel->chunkStart.clear();
+        channel->blocks.clear();
+        channel->count = 0;
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef TELEMETRYSTORE_H
+#define TELEMETRYSTORE_H
+
+#include <QString>
+#include <QVector>
+#include <QPointF>
+#include <QFile>
+#include <QDir>
+#include <QStandardPaths>
+#include <QDateTime>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+/*
+ * Append-only long history of the telemetry channels.
+ * Every channel is a file of fixed-size chunks, a chunk is columnar:
+ * chunkRecords timestamps (float64, sec) followed by chunkRecords values (float32).
+ * Only the chunk being written and a few recently read chunks are mapped into memory,
+ * so resident memory doesn't depend on the session length.
+ * The sparse index keeps the first timestamp of every chunk: time lookups are
+ * binary searches over the index and then inside one chunk, O(log n).
+ * Every block of blockRecords records has its min/max summary in memory (about 1% of the records size),
+ * wide reads take whole blocks from the summaries and touch the records only at the ends of the range.
+ */
+class TelemetryStore
+{
+private:
+    static const int chunkRecords = 16384;
+    static const qint64 chunkBytes = chunkRecords * (sizeof(double) + sizeof(float));
+    static const int maxMappedChunks = 4;   //read cache per channel
+    static const int blockRecords = 256;
+
+    struct Block    {
+        double tAtMin = 0;
+        double tAtMax = 0;
+        float min = 0;
+        float max = 0;
+    };
+
+    struct MappedChunk  {
+        int chunk = -1;
+        uchar *data = nullptr;
+        quint64 lastUse = 0;
+    };
+
+    struct Channel  {
+        QString name;
+        QFile *file = nullptr;
+        QVector<double> chunkStart; //sparse time index
+        qint64 count = 0;
+        uchar *writeChunk = nullptr;
+        QVector<MappedChunk> readChunks;
+        QVector<Block> blocks;      //min/max of every blockRecords records
+    };
+
+    QDir directory;
+    QVector<Channel*> channels;
+    quint64 useCounter = 0;
+
+    static double* times(uchar *chunk);
+    static float* values(uchar *chunk);
+    uchar* mapChunk(Channel *channel, int chunk);
+    void unmapReadChunks(Channel *channel);
+    int chunkSize(Channel const* channel, int chunk) const;
+    qint64 lowerBound(Channel *channel, double time);
+public:
+    explicit TelemetryStore(QString const& path = QString());
+    ~TelemetryStore();
+
+    //registers the channel (or finds the registered one) and returns its id
+    int channel(QString const& name);
+    int channelCount() const;
+    QString channelName(int channel) const;
+    void append(int channel, double time, float value);
+    qint64 count(int channel) const;
+    bool timeRange(int channel, double &first, double &last);
+    //points inside [t0, t1], reduced to min/max pairs if there are more than 2 * maxBuckets
+    //(reduced is set then), buckets of whole blocks are read from the block summaries
+    QVector<QPointF> read(int channel, double t0, double t1, int maxBuckets, bool *reduced = nullptr);
+    void clear();
+};
+
+#endif // TELEMETRYSTORE_H
@@ -0,0 +1,134 @@
+#include "trajectorytrail.h"
+#include <QtMath>
+#include <cmath>
+
+void TrajectoryTrail::Sleeve::reset(QPointF const& anchor)  {
+    this->anchor = anchor;
+    open = true;
+    reach = 0;
+}
+
+bool TrajectoryTrail::Sleeve::fits(QPointF const& point, qreal tolerance)  {
+    QPointF delta = point - anchor;
+    qreal distance = qSqrt(delta.x() * delta.x() + delta.y() * delta.y());
+    //turning back, the farthest sample would be past the segment end
+    if (distance < reach - tolerance)
+        return false;
+    reach = qMax(reach, distance);
+    if (distance <= tolerance)
+        return true;
+
+    qreal direction = qAtan2(delta.y(), delta.x());
+    qreal half = qAsin(tolerance / distance);
+    if (open)   {
+        open = false;
+        base = direction;
+        low = -half;
+        high = half;
+        return true;
+    }
+    qreal relative = std::remainder(direction - base, 2 * M_PI);
+    if (relative < low || relative > high)
+        return false;
+    low = qMax(low, relative - half);
+    high = qMin(high, relative + half);
+    return true;
+}
+
+TrajectoryTrail::TrajectoryTrail(qreal tolerance, int maxPoints) :
+    tolerance(tolerance), oldestTolerance(tolerance * (1 << (tiers - 1))), maxPoints(qMax(maxPoints, 16 * tiers)),
+    tierSizes(tiers, 0)  {
+    points.reserve(this->maxPoints + tiers);
+}
+
+void TrajectoryTrail::append(QPointF const& sample)    {
+    if (points.isEmpty())   {
+        points.append(sample);
+        points.append(sample);
+        tierSizes[0] = 2;
+        sleeve.reset(sample);
+        return;
+    }
+    if (sleeve.fits(sample, tolerance)) {
+        points.last() = sample;
+        return;
+    }
+
+    //the previous sample becomes a vertex
+    sleeve.reset(points.last());
+    sleeve.fits(sample, tolerance);
+    points.append(sample);
+    tierSizes[0]++;
+    if (tierSizes.at(0) > maxPoints / tiers)
+        coarsen();
+}
+
+//appends vertices of points[from, to] to out, both ends are kept
+void TrajectoryTrail::simplify(QVector<QPointF> const& points, int from, int to, qreal tolerance,
+                               QVector<QPointF> &out)   {
+    Sleeve pass;
+    pass.reset(points.at(from));
+    out.append(points.at(from));
+    for (int i = from + 1; i < to; i++)   {
+        if (pass.fits(points.at(i), tolerance))
+            continue;
+        out.append(points.at(i - 1));
+        pass.reset(points.at(i - 1));
+        pass.fits(points.at(i), tolerance);
+    }
+    out.append(points.at(to));
+}
+
+//moves the older half of every full band into the next band simplified with its tolerance,
+//a band gets full after maxPoints / tiers / 2 new vertices, O(tiers) amortized per vertex
+void TrajectoryTrail::coarsen() {
+    int capacity = maxPoints / tiers;
+    QVector<QPointF> coarse;
+    int end = points.size();    //end of the band
+    for (int tier = 0; tier < tiers && tierSizes.at(tier) > capacity; tier++)  {
+        int start = end - tierSizes.at(tier);
+        int half = tierSizes.at(tier) / 2;
+        bool oldest = tier == tiers - 1;
+        qreal bandTolerance = oldest ? oldestTolerance : tolerance * (1 << (tier + 1));
+
+        coarse.clear();
+        coarse.reserve(points.size());
+        for (int i = 0; i < start; i++)
+            coarse.append(points.at(i));
+        simplify(points, start, start + half, bandTolerance, coarse);
+        int simplified = coarse.size() - start;
+        for (int i = start + half + 1; i < points.size(); i++)
+            coarse.append(points.at(i));
+        points.swap(coarse);
+
+        if (oldest) {
+            tierSizes[tier] += simplified - (half + 1);
+            if (tierSizes.at(tier) > capacity)
+                oldestTolerance *= 2;
+        }   else    {
+            tierSizes[tier] -= half + 1;
+            tierSizes[tier + 1] += simplified;
+        }
+        end = start + simplified;
+    }
+    serial++;
+}
+
+void TrajectoryTrail::clear()   {
+    points.clear();
+    tierSizes.fill(0);
+    oldestTolerance = tolerance * (1 << (tiers - 1));
+    serial++;
+}
+
+QVector<QPointF> const& TrajectoryTrail::getPoints() const  {
+    return points;
+}
+
+quint32 TrajectoryTrail::getSerial() const  {
+    return serial;
+}
+
+qreal TrajectoryTrail::getTolerance() const {
+    return tolerance;
+}
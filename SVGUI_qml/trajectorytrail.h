@@ -0,0 +1,62 @@
+#ifndef TRAJECTORYTRAIL_H
+#define TRAJECTORYTRAIL_H
+
+#include <QVector>
+#include <QPointF>
+
+/*
+ * Path of the vehicle as a polyline simplified online.
+ * A sample extends the last segment while every sample since the last vertex stays
+ * within the tolerance of it (sleeve of directions from the vertex, O(1) per sample),
+ * otherwise the previous sample becomes a vertex. The last point follows the latest sample.
+ * Vertices are kept in age bands (tiers) of at most maxPoints / tiers vertices, band k is
+ * simplified with tolerance * 2^k: when a band is full its older half is simplified with
+ * the next band's tolerance and moves there, so recent driving keeps the base tolerance.
+ * The oldest band is simplified in place, its tolerance doubles only when a pass can't
+ * get it under its size, so hours of driving keep a bounded vertex count.
+ * Only positions are kept, the heading is drawn from the latest pose and the full-rate
+ * angle is in the telemetry store.
+ */
+class TrajectoryTrail
+{
+private:
+    //directions from the anchor keeping all the passed samples within the tolerance
+    struct Sleeve   {
+        QPointF anchor;
+        bool open = true;   //no direction limit yet
+        qreal base = 0;     //rad, low and high are relative to it
+        qreal low = 0;
+        qreal high = 0;
+        qreal reach = 0;    //distance to the farthest sample
+
+        void reset(QPointF const& anchor);
+        //narrows the sleeve by the point, false if the segment to the point leaves any passed sample
+        bool fits(QPointF const& point, qreal tolerance);
+    };
+
+    static const int tiers = 8;
+
+    qreal tolerance;
+    qreal oldestTolerance;  //of the oldest band
+    int maxPoints;
+    QVector<QPointF> points;
+    QVector<int> tierSizes; //vertices of every band, tier 0 is the newest one at the end of points
+    Sleeve sleeve;
+    quint32 serial = 0;
+
+    static void simplify(QVector<QPointF> const& points, int from, int to, qreal tolerance, QVector<QPointF> &out);
+    void coarsen();
+public:
+    //tolerance in the position units (cells)
+    explicit TrajectoryTrail(qreal tolerance = 0.05, int maxPoints = 8192);
+
+    void append(QPointF const& sample);
+    void clear();
+    //vertices, the last one is the latest sample
+    QVector<QPointF> const& getPoints() const;
+    //changes when the vertices are rewritten, not only appended
+    quint32 getSerial() const;
+    qreal getTolerance() const;
+};
+
+#endif // TRAJECTORYTRAIL_H
@@ -29,6 +29,9 @@ SOURCES += \
         mainwindow.cpp \
         addressvalidator.cpp \
         ../common/svserver.cpp \
+        ../common/svtrace.cpp \
+        ../common/svmetrics.cpp \
+        ../common/telemetrycodec.cpp \
         ../common/datapackage.cpp
 
 INCLUDEPATH += ../common/
@@ -36,6 +39,9 @@ INCLUDEPATH += ../common/
 HEADERS += \
         mainwindow.h \
         ../common/svserver.h \
+        ../common/svtrace.h \
+        ../common/svmetrics.h \
+        ../common/telemetrycodec.h \
         ../common/datapackage.h \
         addressvalidator.h
 
@@ -18,6 +18,9 @@ DEFINES += QT_DEPRECATED_WARNINGS
 SOURCES += \
         main.cpp \
         ../common/svserver.cpp \
+        ../common/svtrace.cpp \
+        ../common/svmetrics.cpp \
+        ../common/telemetrycodec.cpp \
         ../common/datapackage.cpp
 
 INCLUDEPATH += ../common/
@@ -29,4 +32,7 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 
 HEADERS += \
         ../common/svserver.h \
+        ../common/svtrace.h \
+        ../common/svmetrics.h \
+        ../common/telemetrycodec.h \
         ../common/datapackage.h \
@@ -18,7 +18,12 @@ DEFINES += QT_DEPRECATED_WARNINGS
 SOURCES += \
         main.cpp \
     ../../common/datapackage.cpp \
-    ../../common/svserver.cpp
+    ../../common/svserver.cpp \
+    ../../common/svtrace.cpp \
+    ../../common/svmetrics.cpp \
+    ../../common/telemetrycodec.cpp \
+    ../../common/gridplanner.cpp \
+    ../../common/vehiclesimulator.cpp
 
 INCLUDEPATH += ../../common/
 
@@ -29,4 +34,9 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 
 HEADERS += \
     ../../common/datapackage.h \
-    ../../common/svserver.h
+    ../../common/svserver.h \
+    ../../common/svtrace.h \
+    ../../common/svmetrics.h \
+    ../../common/telemetrycodec.h \
+    ../../common/gridplanner.h \
+    ../../common/vehiclesimulator.h
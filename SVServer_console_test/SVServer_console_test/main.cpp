@@ -1,69 +1,101 @@
 #include <QCoreApplication>
 #include <svserver.h>
-#include <QTime>
+#include <vehiclesimulator.h>
+#include <svtrace.h>
+#include <svmetrics.h>
+#include <QCommandLineParser>
 #include <QTimer>
-
-#include <cmath>
+#include <QtMath>
 
 int main(int argc, char *argv[])
 {
     QCoreApplication a(argc, argv);
 
+    //telemetry rates and the seed of the simulated vehicle
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption highFreqOption("hf-rate", "HighFreqDataPackage per second.", "rate", "100");
+    QCommandLineOption lowFreqOption("lf-rate", "LowFreqDataPackage per second.", "rate", "1");
+    QCommandLineOption stepOption("step-rate", "Simulation steps per second.", "rate", "1000");
+    QCommandLineOption seedOption("seed", "Seed of the sensor noise.", "seed", "1");
+    QCommandLineOption traceOption("trace", "Trace the server and write the trace when a client disconnects.", "file");
+    QCommandLineOption metricsOption("metrics-port", "Serve Prometheus metrics on the local port.", "port", "0");
+    QCommandLineOption plainOption("no-compression", "Send the plain telemetry to all the clients.");
+    QCommandLineOption doorOption("door-period", "Close and open the door of the inner room every period.", "sec", "0");
+    parser.addOptions({highFreqOption, lowFreqOption, stepOption, seedOption, traceOption, metricsOption, plainOption,
+                       doorOption});
+    parser.process(a);
+
+    SVMetricsServer metricsServer;
+    quint16 metricsPort = static_cast<quint16>(parser.value(metricsOption).toUInt());
+    if (metricsPort)
+        metricsServer.start(QHostAddress::LocalHost, metricsPort);
+
+    VehicleSimulator::Config config;
+    config.highFreqRate = parser.value(highFreqOption).toInt();
+    config.lowFreqRate = parser.value(lowFreqOption).toInt();
+    config.stepRate = parser.value(stepOption).toInt();
+    config.seed = parser.value(seedOption).toUInt();
+
     SVServer server;
+    server.setCompression(!parser.isSet(plainOption));
+    server.setTelemetryRates(static_cast<quint16>(config.highFreqRate), static_cast<quint16>(config.lowFreqRate));
     bool result = server.start(QHostAddress("0.0.0.0"), 5556);
 
-    MapPackage map({{1, 1, 1, 1, 1, 1, 1, 1},
-                    {1, 0, 0, 0, 0, 0, 0, 1},
-                    {1, 0, 1, 1, 1, 1, 0, 1},
-                    {1, 0, 1, 0, 0, 1, 0, 1},
-                    {1, 0, 1, 0, 0, 0, 0, 1},
-                    {1, 0, 1, 1, 1, 1, 1, 1}});
+    QVector<QVector<qint8>> cells({{1, 1, 1, 1, 1, 1, 1, 1},
+                                   {1, 0, 0, 0, 0, 0, 0, 1},
+                                   {1, 0, 1, 1, 1, 1, 0, 1},
+                                   {1, 0, 1, 0, 0, 1, 0, 1},
+                                   {1, 0, 1, 0, 0, 0, 0, 1},
+                                   {1, 0, 1, 1, 1, 1, 1, 1}});
+    MapPackage map(cells);
 
     if (result) {
-        QTime midnight(0,0,0);
-        qsrand(midnight.secsTo(QTime::currentTime()));
-
-        static float t = 0;
-        static float x = 0;
-        static float angle = 0;
-
         QObject::connect(&server, &SVServer::signalNewConnection, [&server, &map] {
             server.slotSendMap(map);
         });
 
-        QTimer *timerHighFreq = new QTimer();
-        QObject::connect(timerHighFreq, &QTimer::timeout, [&server] {
-            HighFreqDataPackage data;
-            t += 0.01f;
-            float v = sin(t) * 15;
-            //x += 0.1f + (qrand() % 100 - 50) / 100;
-            x += 0.1f;
-            angle += 1;
-
-            data.m_encoderValue = x;
-            data.m_steeringAngle = v;
-            data.x = 1.5;
-            data.y = 2.5;
-            data.angle = angle;
-
-            server.slotSendHighFreqData(data);
-
+        //the vehicle plans the path to the goal on its own map and drives there
+        VehicleSimulator *simulator = new VehicleSimulator(map, config, &a);
+        simulator->setPose(1.5, 2.5, -M_PI / 2);
+        QObject::connect(&server, &SVServer::signalControl, simulator, &VehicleSimulator::slotControl);
+        //the vehicle sends at the offered rates, every client gets the share of its own rates
+        QObject::connect(&server, &SVServer::signalTaskGoal, [&server, simulator](qint32 goalX, qint32 goalY) {
+            bool planned = simulator->setGoal(QPoint(goalX, goalY));
+            qDebug() << "Goal" << goalX << goalY << (planned ? "planned" : "is unreachable");
+            server.slotTaskDone(planned ? AnswerPackage::GOAL_PLANNED : AnswerPackage::GOAL_UNREACHABLE);
         });
-        timerHighFreq->start(50); // <- delay between sending
-
-        QTimer *timerLowFreq = new QTimer();
-        QObject::connect(timerLowFreq, &QTimer::timeout, [&server] {
-            LowFreqDataPackage data;
-
-            data.stateType = LowFreqDataPackage::State::WAIT;
-            data.m_compBatteryPerc = qrand() % 100;
-            data.m_motorBatteryPerc = qrand() % 100;
-            data.m_temp = qrand() % 100;
-
-            server.slotSendLowFreqData(data);
+        QObject::connect(simulator, &VehicleSimulator::signalGoalReached, [] {
+            qDebug() << "Goal reached";
         });
-        timerLowFreq->start(1000); // <- delay between sending
-
+        QObject::connect(simulator, &VehicleSimulator::signalGoalAborted, [] {
+            qDebug() << "Goal aborted, the way is blocked";
+        });
+        //the changed map goes to the vehicle, which plans the rest of the path again, and to the clients
+        int doorPeriod = parser.value(doorOption).toInt();
+        if (doorPeriod > 0) {
+            QTimer *door = new QTimer(&a);
+            QObject::connect(door, &QTimer::timeout, [&server, &map, &cells, simulator] {
+                qint8 &cell = cells[4][5];
+                cell = cell == MapPackage::WALL ? MapPackage::EMPTY : MapPackage::WALL;
+                qDebug() << "Door" << (cell == MapPackage::WALL ? "closed" : "opened");
+                map = MapPackage(cells);
+                simulator->setMap(map);
+                server.slotSendMap(map);
+            });
+            door->start(doorPeriod * 1000);
+        }
+        QObject::connect(simulator, &VehicleSimulator::signalHighFreqData, &server, &SVServer::slotSendHighFreqData);
+        QObject::connect(simulator, &VehicleSimulator::signalLowFreqData, &server, &SVServer::slotSendLowFreqData);
+        simulator->start();
+
+        if (parser.isSet(traceOption))  {
+            QString traceFile = parser.value(traceOption);
+            SVTrace::setEnabled(true);
+            QObject::connect(&server, &SVServer::signalDisconnected, [traceFile] {
+                SVTrace::dump(traceFile);
+            });
+        }
     }
 
     return a.exec();
@@ -1,16 +1,157 @@
 #include "datapackage.h"
+#include <QtEndian>
+#include <cstring>
+
+Q_LOGGING_CATEGORY(svPackages, "sv.packages", QtInfoMsg)
 
 /* Check this! You use many functions for strings, but put array of chars without terminator ymbol \0 */
 /* Better use casual string or change to QString with fixed size */
 //const char AuthPackage::authRequest[10] = {'k', 'o', 'n', 'n', 'i', 'c', 'h', 'i', 'w', 'a'};
 const char AuthPackage::authRequest[] = "konnichiwa";
 
+//COMPACT fields, the swap is its own inverse
+static quint32 littleEndian(quint32 value)  {
+    return qToLittleEndian(value);
+}
+
+static quint16 littleEndian(quint16 value)  {
+    return qToLittleEndian(value);
+}
+
+static qint32 littleEndian(qint32 value)    {
+    return qToLittleEndian(value);
+}
+
+static float littleEndian(float value)  {
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    bits = qToLittleEndian(bits);
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+template <typename Compact>
+static QByteArray compactBytes(Compact const& compact)  {
+    return QByteArray(reinterpret_cast<char const*>(&compact), sizeof(Compact));
+}
+
+//missing bytes of a short package are zeros, as QDataStream reads them
+template <typename Compact>
+static Compact compactStruct(QByteArray const& bytes)   {
+    Compact compact;
+    std::memset(&compact, 0, sizeof(Compact));
+    std::memcpy(&compact, bytes.constData(), qMin(static_cast<size_t>(bytes.size()), sizeof(Compact)));
+    return compact;
+}
+
+QByteArray Package::toBytes(Layout) const   {
+    return toBytes();
+}
+
+QByteArray PackageFrame::wrap(QByteArray const& data, bool longFrames)   {
+    QByteArray bytes;
+    bytes.reserve(data.size() + 2);
+    bytes.append(static_cast<char>(data.size() & 0xff));
+    if (longFrames)
+        bytes.append(static_cast<char>((data.size() >> 8) & 0xff));
+    bytes.append(data);
+    return bytes;
+}
+
+bool PackageFrame::read(QIODevice *device, bool longFrames, QByteArray &data)    {
+    int prefix = longFrames ? 2 : 1;
+    if (device->bytesAvailable() < prefix)
+        return false;
+    QByteArray header = device->peek(prefix);
+    int size = static_cast<quint8>(header.at(0));
+    if (longFrames)
+        size |= static_cast<quint8>(header.at(1)) << 8;
+    if (device->bytesAvailable() < prefix + size)
+        return false;
+    device->read(prefix);
+    data = device->read(size);
+    return true;
+}
+
+Capabilities Capabilities::local()  {
+    Capabilities capabilities;
+    capabilities.version = currentVersion;
+    capabilities.maxFrameSize = 65535;
+    capabilities.encodings = 1 << DELTA;
+    return capabilities;
+}
+
+Capabilities Capabilities::negotiate(Capabilities const& client, Capabilities const& server)   {
+    Capabilities agreed;
+    agreed.version = qMin(client.version, server.version);
+    if (agreed.version < 2)
+        return agreed;
+    agreed.maxFrameSize = qMin(client.maxFrameSize, server.maxFrameSize);
+    quint8 encodings = client.encodings & server.encodings;
+    for (int encoding = 7; encoding > PLAIN; encoding--)
+        if (encodings & (1 << encoding))    {
+            agreed.encodings = static_cast<quint8>(1 << encoding);
+            break;
+        }
+    quint8 transports = client.transports & server.transports;
+    agreed.transports = transports ? static_cast<quint8>(transports & -transports) : static_cast<quint8>(1 << TCP);
+    auto rate = [](quint16 preferred, quint16 available) -> quint16 {
+        if (preferred == 0)
+            return available;
+        return available == 0 ? preferred : qMin(preferred, available);
+    };
+    agreed.highFreqRate = rate(client.highFreqRate, server.highFreqRate);
+    agreed.lowFreqRate = rate(client.lowFreqRate, server.lowFreqRate);
+    return agreed;
+}
+
+QByteArray Capabilities::toBytes() const    {
+    QByteArray bytes;
+    QDataStream stream(&bytes, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream << version << maxFrameSize << encodings << transports << highFreqRate << lowFreqRate;
+    return bytes;
+}
+
+bool Capabilities::fromBytes(QByteArray const& bytes, int offset)  {
+    *this = Capabilities();
+    if (bytes.size() < offset + bytesSize || static_cast<quint8>(bytes.at(offset)) < 2)
+        return false;
+    QDataStream stream(bytes.mid(offset));
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream >> version >> maxFrameSize >> encodings >> transports >> highFreqRate >> lowFreqRate;
+    maxFrameSize = qMax<quint16>(maxFrameSize, 127);
+    return true;
+}
+
+bool Capabilities::supports(Encoding encoding) const    {
+    return encoding == PLAIN || (encodings & (1 << encoding));
+}
+
+Capabilities::Encoding Capabilities::encoding() const   {
+    return supports(DELTA) ? DELTA : PLAIN;
+}
+
+bool Capabilities::longFrames() const   {
+    return version >= 2;
+}
+
+Package::Layout Capabilities::layout() const   {
+    return version >= 3 ? Package::COMPACT : Package::STREAM;
+}
+
 AuthPackage::AuthPackage() {}
 
+AuthPackage::AuthPackage(QByteArray &bytes)    {
+    capabilities.fromBytes(bytes, sizeof(packageType) + sizeof(authRequest));
+}
+
 QByteArray AuthPackage::toBytes() const {
     QByteArray bytes;
     bytes.append(packageType);
     bytes.append(authRequest, sizeof(AuthPackage::authRequest));
+    if (capabilities.version >= 2)
+        bytes.append(capabilities.toBytes());
     return bytes;
 }
 
@@ -21,12 +162,24 @@ size_t AuthPackage::size() const    {
 AuthAnswerPackage::AuthAnswerPackage(qint8 deviceType, qint8 deviceID, qint8 stateType) :
     deviceType(deviceType), deviceID(deviceID), stateType(stateType)   {}
 
+AuthAnswerPackage::AuthAnswerPackage(QByteArray &bytes) :
+    deviceType(0), deviceID(0), stateType(0)    {
+    if (bytes.size() > 3)   {
+        deviceType = bytes.at(1);
+        deviceID = bytes.at(2);
+        stateType = bytes.at(3);
+    }
+    capabilities.fromBytes(bytes, 4);
+}
+
 QByteArray AuthAnswerPackage::toBytes() const   {
     QByteArray bytes;
     bytes.append(packageType);
     bytes.append(deviceType);
     bytes.append(deviceID);
     bytes.append(stateType);
+    if (capabilities.version >= 2)
+        bytes.append(capabilities.toBytes());
     return bytes;
 }
 
@@ -34,7 +187,23 @@ size_t AuthAnswerPackage::size() const  {
     return static_cast<size_t>(toBytes().size());
 }
 
-SetPackage::SetPackage(QByteArray& bytes)   {
+SetPackage::SetPackage(QByteArray& bytes, Layout layout)   {
+    if (layout == COMPACT)  {
+        CompactSetPackage compact = compactStruct<CompactSetPackage>(bytes);
+        steering_p = littleEndian(compact.steering_p);
+        steering_i = littleEndian(compact.steering_i);
+        steering_d = littleEndian(compact.steering_d);
+        steering_servoZero = littleEndian(compact.steering_servoZero);
+        forward_p = littleEndian(compact.forward_p);
+        forward_i = littleEndian(compact.forward_i);
+        forward_d = littleEndian(compact.forward_d);
+        forward_int = littleEndian(compact.forward_int);
+        backward_p = littleEndian(compact.backward_p);
+        backward_i = littleEndian(compact.backward_i);
+        backward_d = littleEndian(compact.backward_d);
+        backward_int = littleEndian(compact.backward_int);
+        return;
+    }
     QDataStream stream(&bytes, QIODevice::ReadOnly);
 
     stream.skipRawData(sizeof( SetPackage::packageType ));
@@ -75,6 +244,26 @@ QByteArray SetPackage::toBytes() const    {
     return bytes;
 }
 
+QByteArray SetPackage::toBytes(Layout layout) const  {
+    if (layout != COMPACT)
+        return toBytes();
+    CompactSetPackage compact;
+    compact.packageType = packageType;
+    compact.steering_p = littleEndian(steering_p);
+    compact.steering_i = littleEndian(steering_i);
+    compact.steering_d = littleEndian(steering_d);
+    compact.steering_servoZero = littleEndian(steering_servoZero);
+    compact.forward_p = littleEndian(forward_p);
+    compact.forward_i = littleEndian(forward_i);
+    compact.forward_d = littleEndian(forward_d);
+    compact.forward_int = littleEndian(forward_int);
+    compact.backward_p = littleEndian(backward_p);
+    compact.backward_i = littleEndian(backward_i);
+    compact.backward_d = littleEndian(backward_d);
+    compact.backward_int = littleEndian(backward_int);
+    return compactBytes(compact);
+}
+
 size_t SetPackage::size() const {
     return static_cast<size_t>(toBytes().size());
 }
@@ -120,20 +309,49 @@ MapPackage::MapPackage()    {}
 MapPackage::MapPackage(QVector<QVector<qint8>> const& cells)    {
     _cells = cells;
 
-    mapHeight = static_cast<qint8>(cells.size());
+    mapHeight = cells.size();
     if (mapHeight)  {
-        mapWidth = static_cast<qint8>(cells.first().size());
+        mapWidth = cells.first().size();
     }
 }
 
-MapPackage::MapPackage(QByteArray &bytes)    {
+MapPackage::MapPackage(QByteArray &bytes, Layout layout)    {
+    if (layout == COMPACT)  {
+        CompactMapHeader header = compactStruct<CompactMapHeader>(bytes);
+        int width = littleEndian(header.width);
+        int height = littleEndian(header.height);
+        if (bytes.size() < static_cast<int>(sizeof(CompactMapHeader)) + width * height)
+            return;
+        mapWidth = width;
+        mapHeight = height;
+        char const* cells = bytes.constData() + sizeof(CompactMapHeader);
+        _cells.resize(height);
+        for (int i = 0; i < height; i++)
+            _cells[i] = QVector<qint8>(width);
+        for (int i = 0; i < height; i++)
+            std::memcpy(_cells[i].data(), cells + i * width, static_cast<size_t>(width));
+        return;
+    }
     QDataStream stream(&bytes, QIODevice::ReadOnly);
 
+    qint8 width = 0;
+    qint8 height = 0;
     stream.skipRawData(sizeof(packageType));
-    stream >> mapWidth;
-    stream >> mapHeight;
+    stream >> width;
+    stream >> height;
 
     stream >> _cells;
+    //rows carry their own sizes, a map with rows of different lengths is dropped
+    mapHeight = _cells.size();
+    mapWidth = mapHeight ? _cells.first().size() : 0;
+    for (QVector<qint8> const& row : _cells)
+        if (row.size() != mapWidth) {
+            clear();
+            return;
+        }
+    if (stream.status() != QDataStream::Ok || width != static_cast<qint8>(qMin(mapWidth, 127)) ||
+            height != static_cast<qint8>(qMin(mapHeight, 127)))
+        clear();
 }
 
 void MapPackage::clear()    {
@@ -167,14 +385,32 @@ QByteArray MapPackage::toBytes() const  {
     QDataStream stream(&bytes, QIODevice::WriteOnly);
 
     stream << packageType;
-    stream << mapWidth;
-    stream << mapHeight;
+    stream << static_cast<qint8>(qMin(mapWidth, 127));
+    stream << static_cast<qint8>(qMin(mapHeight, 127));
 
     stream << _cells;
 
     return bytes;
 }
 
+QByteArray MapPackage::toBytes(Layout layout) const {
+    if (layout != COMPACT)
+        return toBytes();
+    CompactMapHeader header;
+    header.packageType = packageType;
+    header.width = littleEndian(static_cast<quint16>(mapWidth));
+    header.height = littleEndian(static_cast<quint16>(mapHeight));
+    QByteArray bytes = compactBytes(header);
+    bytes.reserve(bytes.size() + mapWidth * mapHeight);
+    //every row is width cells, short rows are padded with empty ones
+    for (QVector<qint8> const& row : _cells)    {
+        int count = qMin(row.size(), mapWidth);
+        bytes.append(reinterpret_cast<char const*>(row.constData()), count);
+        bytes.append(mapWidth - count, static_cast<char>(EMPTY));
+    }
+    return bytes;
+}
+
 LowFreqDataPackage::LowFreqDataPackage() :
     LowFreqDataPackage( State::WAIT ) /* Delegated to LowFreqDataPackage(State state) */
 {
@@ -188,17 +424,26 @@ LowFreqDataPackage::LowFreqDataPackage(State state) :
     timeStamp = static_cast<quint32>(QTime::currentTime().msecsSinceStartOfDay());
 }
 
-LowFreqDataPackage::LowFreqDataPackage(QByteArray& bytes) {
+LowFreqDataPackage::LowFreqDataPackage(QByteArray& bytes, Layout layout) {
+    if (layout == COMPACT)  {
+        CompactLowFreqDataPackage compact = compactStruct<CompactLowFreqDataPackage>(bytes);
+        stateType = compact.stateType;
+        timeStamp = littleEndian(compact.timeStamp);
+        m_motorBatteryPerc = littleEndian(compact.motorBatteryPerc);
+        m_compBatteryPerc = littleEndian(compact.compBatteryPerc);
+        m_temp = littleEndian(compact.temp);
+        return;
+    }
     QDataStream stream(&bytes, QIODevice::ReadOnly);
 
     stream.skipRawData(sizeof(packageType));
     stream >> stateType;
     stream >> timeStamp;
-    stream.skipRawData(sizeof(DataType));
+    stream.skipRawData(streamTagSize);
     stream >> m_motorBatteryPerc;
-    stream.skipRawData(sizeof(DataType));
+    stream.skipRawData(streamTagSize);
     stream >> m_compBatteryPerc;
-    stream.skipRawData(sizeof(DataType));
+    stream.skipRawData(streamTagSize);
     stream >> m_temp;
 }
 
@@ -209,16 +454,29 @@ QByteArray LowFreqDataPackage::toBytes() const  {
     stream << packageType;
     stream << stateType;
     stream << timeStamp;
-    stream << DataType::MOTOR_BATTERY;
+    stream << static_cast<qint32>(MOTOR_BATTERY);
     stream << m_motorBatteryPerc;
-    stream << DataType::COMP_BATTERY;
+    stream << static_cast<qint32>(COMP_BATTERY);
     stream << m_compBatteryPerc;
-    stream << DataType::TEMPERATURE;
+    stream << static_cast<qint32>(TEMPERATURE);
     stream << m_temp;
 
     return bytes;
 }
 
+QByteArray LowFreqDataPackage::toBytes(Layout layout) const  {
+    if (layout != COMPACT)
+        return toBytes();
+    CompactLowFreqDataPackage compact;
+    compact.packageType = packageType;
+    compact.stateType = stateType;
+    compact.timeStamp = littleEndian(timeStamp);
+    compact.motorBatteryPerc = littleEndian(m_motorBatteryPerc);
+    compact.compBatteryPerc = littleEndian(m_compBatteryPerc);
+    compact.temp = littleEndian(m_temp);
+    return compactBytes(compact);
+}
+
 size_t LowFreqDataPackage::size() const {
     return static_cast<size_t>(toBytes().size());
 }
@@ -229,20 +487,30 @@ HighFreqDataPackage::HighFreqDataPackage() :
     timeStamp = static_cast<quint32>(QTime::currentTime().msecsSinceStartOfDay());
 }
 
-HighFreqDataPackage::HighFreqDataPackage(QByteArray& bytes) {
+HighFreqDataPackage::HighFreqDataPackage(QByteArray& bytes, Layout layout) {
+    if (layout == COMPACT)  {
+        CompactHighFreqDataPackage compact = compactStruct<CompactHighFreqDataPackage>(bytes);
+        timeStamp = littleEndian(compact.timeStamp);
+        m_encoderValue = littleEndian(compact.encoderValue);
+        m_steeringAngle = littleEndian(compact.steeringAngle);
+        x = littleEndian(compact.x);
+        y = littleEndian(compact.y);
+        angle = littleEndian(compact.angle);
+        return;
+    }
     QDataStream stream(&bytes, QIODevice::ReadOnly);
 
     stream.skipRawData(sizeof(packageType));
     stream >> timeStamp;
-    stream.skipRawData(sizeof(DataType));
+    stream.skipRawData(streamTagSize);
     stream >> m_encoderValue;
-    stream.skipRawData(sizeof(DataType));
+    stream.skipRawData(streamTagSize);
     stream >> m_steeringAngle;
-    stream.skipRawData(sizeof(DataType));
+    stream.skipRawData(streamTagSize);
     stream >> x;
-    stream.skipRawData(sizeof(DataType));
+    stream.skipRawData(streamTagSize);
     stream >> y;
-    stream.skipRawData(sizeof(DataType));
+    stream.skipRawData(streamTagSize);
     stream >> angle;
 }
 
@@ -252,20 +520,34 @@ QByteArray HighFreqDataPackage::toBytes() const  {
 
     stream << packageType;
     stream << timeStamp;
-    stream << DataType::ENCODER;
+    stream << static_cast<qint32>(ENCODER);
     stream << m_encoderValue;
-    stream << DataType::STEERING;
+    stream << static_cast<qint32>(STEERING);
     stream << m_steeringAngle;
-    stream << DataType::X;
+    stream << static_cast<qint32>(X);
     stream << x;
-    stream << DataType::Y;
+    stream << static_cast<qint32>(Y);
     stream << y;
-    stream << DataType::ANGLE;
+    stream << static_cast<qint32>(ANGLE);
     stream << angle;
 
     return bytes;
 }
 
+QByteArray HighFreqDataPackage::toBytes(Layout layout) const  {
+    if (layout != COMPACT)
+        return toBytes();
+    CompactHighFreqDataPackage compact;
+    compact.packageType = packageType;
+    compact.timeStamp = littleEndian(timeStamp);
+    compact.encoderValue = littleEndian(m_encoderValue);
+    compact.steeringAngle = littleEndian(m_steeringAngle);
+    compact.x = littleEndian(x);
+    compact.y = littleEndian(y);
+    compact.angle = littleEndian(angle);
+    return compactBytes(compact);
+}
+
 size_t HighFreqDataPackage::size() const {
     return static_cast<size_t>(toBytes().size());
 }
@@ -274,14 +556,20 @@ ControlPackage::ControlPackage()    {
 
 }
 
-ControlPackage::ControlPackage(QByteArray &bytes)   {
+ControlPackage::ControlPackage(QByteArray &bytes, Layout layout)   {
+    if (layout == COMPACT)  {
+        CompactControlPackage compact = compactStruct<CompactControlPackage>(bytes);
+        xAxis = littleEndian(compact.xAxis);
+        yAxis = littleEndian(compact.yAxis);
+        return;
+    }
     QDataStream stream(&bytes, QIODevice::ReadOnly);
 
     stream.skipRawData(sizeof(packageType));
 
-    stream.skipRawData(sizeof(DataType));
+    stream.skipRawData(streamTagSize);
     stream >> xAxis;
-    stream.skipRawData(sizeof(DataType));
+    stream.skipRawData(streamTagSize);
     stream >> yAxis;
 }
 
@@ -290,14 +578,67 @@ QByteArray ControlPackage::toBytes() const  {
     QDataStream stream(&bytes, QIODevice::WriteOnly);
 
     stream << packageType;
-    stream << DataType::XAXIS;
+    stream << static_cast<qint32>(XAXIS);
     stream << xAxis;
-    stream << DataType::YAXIS;
+    stream << static_cast<qint32>(YAXIS);
     stream << yAxis;
 
     return bytes;
 }
 
+QByteArray ControlPackage::toBytes(Layout layout) const  {
+    if (layout != COMPACT)
+        return toBytes();
+    CompactControlPackage compact;
+    compact.packageType = packageType;
+    compact.xAxis = littleEndian(xAxis);
+    compact.yAxis = littleEndian(yAxis);
+    return compactBytes(compact);
+}
+
 size_t ControlPackage::size()   const   {
     return toBytes().size();
 }
+
+GoalPackage::GoalPackage()  {}
+
+GoalPackage::GoalPackage(qint32 x, qint32 y) : x(x), y(y)    {}
+
+GoalPackage::GoalPackage(QByteArray &bytes, Layout layout) {
+    if (layout == COMPACT)  {
+        CompactGoalPackage compact = compactStruct<CompactGoalPackage>(bytes);
+        x = littleEndian(compact.x);
+        y = littleEndian(compact.y);
+        return;
+    }
+    QDataStream stream(&bytes, QIODevice::ReadOnly);
+
+    stream.skipRawData(sizeof(packageType));
+    stream >> x;
+    stream >> y;
+}
+
+QByteArray GoalPackage::toBytes() const {
+    QByteArray bytes;
+    QDataStream stream(&bytes, QIODevice::WriteOnly);
+
+    stream << packageType;
+    stream << x;
+    stream << y;
+
+    return bytes;
+}
+
+QByteArray GoalPackage::toBytes(Layout layout) const  {
+    if (layout != COMPACT)
+        return toBytes();
+    CompactGoalPackage compact;
+    compact.packageType = packageType;
+    compact.x = littleEndian(x);
+    compact.y = littleEndian(y);
+    return compactBytes(compact);
+}
+
+size_t GoalPackage::size() const    {
+    return static_cast<size_t>(toBytes().size());
+}
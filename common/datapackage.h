@@ -5,21 +5,155 @@
 #include <QVector>
 #include <QTime>
 #include <QDebug>
+#include <QLoggingCategory>
 #include <QDataStream>
+#include <QIODevice>
+#include <cstddef>
+#include <limits>
+
+//a line per package sent or received, off by default, QT_LOGGING_RULES="sv.packages.debug=true" turns it on
+Q_DECLARE_LOGGING_CATEGORY(svPackages)
 
 struct Package
 {
+    /*
+     * STREAM - QDataStream defaults: big endian, floats as doubles, qint32 tags before the fields.
+     * COMPACT - the Compact* struct of the package byte to byte, since protocol version 3.
+     */
+    enum Layout {
+        STREAM = 0,
+        COMPACT = 1
+    };
+    static const int streamTagSize = 4;     //DataType tags are written as qint32
+
     virtual QByteArray toBytes() const = 0;
+    //packages with a single layout ignore it
+    virtual QByteArray toBytes(Layout layout) const;
     virtual size_t size() const = 0;
     virtual ~Package() = default;
 };
 
+/*
+ * COMPACT layout: fixed little endian fields, float32 and fixed size ints, no tags and no padding,
+ * so a package is decoded with plain loads from the receive buffer (swapped on big endian hosts only).
+ */
+#pragma pack(push, 1)
+struct CompactSetPackage {
+    qint8 packageType;
+    float steering_p, steering_i, steering_d, steering_servoZero;
+    float forward_p, forward_i, forward_d, forward_int;
+    float backward_p, backward_i, backward_d, backward_int;
+};
+
+//followed by width * height cells, row by row
+struct CompactMapHeader {
+    qint8 packageType;
+    quint16 width;
+    quint16 height;
+};
+
+struct CompactLowFreqDataPackage {
+    qint8 packageType;
+    qint8 stateType;
+    quint32 timeStamp;
+    quint32 motorBatteryPerc;
+    quint32 compBatteryPerc;
+    float temp;
+};
+
+struct CompactHighFreqDataPackage {
+    qint8 packageType;
+    quint32 timeStamp;
+    float encoderValue;
+    float steeringAngle;
+    float x;
+    float y;
+    float angle;
+};
+
+struct CompactControlPackage {
+    qint8 packageType;
+    float xAxis;
+    float yAxis;
+};
+
+struct CompactGoalPackage {
+    qint8 packageType;
+    qint32 x;
+    qint32 y;
+};
+#pragma pack(pop)
+
+static_assert(std::numeric_limits<float>::is_iec559 && sizeof(float) == 4, "float32 is expected");
+static_assert(sizeof(CompactSetPackage) == 49 && offsetof(CompactSetPackage, backward_int) == 45, "CompactSetPackage layout");
+static_assert(sizeof(CompactMapHeader) == 5 && offsetof(CompactMapHeader, height) == 3, "CompactMapHeader layout");
+static_assert(sizeof(CompactLowFreqDataPackage) == 18 && offsetof(CompactLowFreqDataPackage, timeStamp) == 2 &&
+              offsetof(CompactLowFreqDataPackage, temp) == 14, "CompactLowFreqDataPackage layout");
+static_assert(sizeof(CompactHighFreqDataPackage) == 25 && offsetof(CompactHighFreqDataPackage, timeStamp) == 1 &&
+              offsetof(CompactHighFreqDataPackage, encoderValue) == 5 && offsetof(CompactHighFreqDataPackage, angle) == 21,
+              "CompactHighFreqDataPackage layout");
+static_assert(sizeof(CompactControlPackage) == 9 && offsetof(CompactControlPackage, yAxis) == 5, "CompactControlPackage layout");
+static_assert(sizeof(CompactGoalPackage) == 9 && offsetof(CompactGoalPackage, y) == 5, "CompactGoalPackage layout");
+
+/*
+ * What a peer supports, sent after the auth request and in the auth answer
+ * (little endian: version, maxFrameSize, encodings, transports, highFreqRate, lowFreqRate).
+ * Peers without it are version 1: 1 byte size prefix, plain packages, TCP.
+ * Since version 2 packages after the auth answer have 2 bytes size prefix,
+ * since version 3 they are in the COMPACT layout.
+ */
+struct Capabilities
+{
+    static const quint8 currentVersion = 3;
+    static const int bytesSize = 9;
+
+    enum Encoding {
+        PLAIN = 0,
+        DELTA = 1   //TelemetryEncoder frames instead of HighFreqDataPackage
+    };
+    enum Transport {
+        TCP = 0
+    };
+
+    quint8 version = 1;
+    quint16 maxFrameSize = 127;
+    quint8 encodings = 0;           //bit per encoding besides PLAIN, the answer has the chosen one only
+    quint8 transports = 1 << TCP;
+    quint16 highFreqRate = 0;       //packages per second, 0 - any
+    quint16 lowFreqRate = 0;
+
+    //of this build
+    static Capabilities local();
+    //what the server uses with the client: the lowest version and frame size,
+    //the best common encoding and transport, the client's rates if the server can do them
+    static Capabilities negotiate(Capabilities const& client, Capabilities const& server);
+
+    QByteArray toBytes() const;
+    //false and version 1 if the bytes at the offset are not capabilities
+    bool fromBytes(QByteArray const& bytes, int offset);
+    bool supports(Encoding encoding) const;
+    Encoding encoding() const;
+    bool longFrames() const;
+    Package::Layout layout() const;
+};
+
+//size prefix of the packages on the wire: 1 byte, 2 bytes little endian with long frames
+struct PackageFrame
+{
+    static QByteArray wrap(QByteArray const& data, bool longFrames);
+    //takes the next package if it is received completely
+    static bool read(QIODevice *device, bool longFrames, QByteArray &data);
+};
+
 struct AuthPackage : public Package
 {
     static const qint8 packageType = 1;
     static const char authRequest[];
+    //sent after the request so old servers don't see it
+    Capabilities capabilities;
 
     explicit AuthPackage();
+    explicit AuthPackage(QByteArray &bytes);
     QByteArray toBytes() const;
     size_t size() const;
 };
@@ -30,8 +164,11 @@ struct AuthAnswerPackage : public Package
     qint8 deviceType;
     qint8 deviceID;
     qint8 stateType;
+    //agreed by the server, old servers don't send them and old clients don't read them
+    Capabilities capabilities;
 
     explicit AuthAnswerPackage(qint8 deviceType = 0, qint8 deviceID = 0, qint8 stateType = 0);
+    explicit AuthAnswerPackage(QByteArray &bytes);
     QByteArray toBytes() const;
     size_t size() const;
 };
@@ -52,9 +189,10 @@ struct SetPackage : public Package
     float backward_d = 0;
     float backward_int = 0;
 
-    explicit SetPackage(QByteArray& bytes);
+    explicit SetPackage(QByteArray& bytes, Layout layout = STREAM);
     explicit SetPackage();
     QByteArray toBytes() const;
+    QByteArray toBytes(Layout layout) const;
     size_t size() const;
 };
 
@@ -63,6 +201,13 @@ struct AnswerPackage : public Package
     static const qint8 packageType = 5;
     qint8 answerType;
 
+    enum AnswerType {
+        SET_ERROR = 0,
+        SET_DONE = 1,
+        GOAL_PLANNED = 2,
+        GOAL_UNREACHABLE = 3
+    };
+
     explicit AnswerPackage(qint8 answerType = 1);
     explicit AnswerPackage(QByteArray& bytes);
     QByteArray toBytes() const;
@@ -86,9 +231,10 @@ struct MapPackage : public Package  {
 
     explicit MapPackage();
     explicit MapPackage(QVector<QVector<qint8>> const& cells);
-    explicit MapPackage(QByteArray &bytes);
+    explicit MapPackage(QByteArray &bytes, Layout layout = STREAM);
 
     QByteArray toBytes() const;
+    QByteArray toBytes(Layout layout) const;
     size_t size() const;
     int getWidth() const;
     int getHeight() const;
@@ -96,8 +242,9 @@ struct MapPackage : public Package  {
     QVector<QVector<qint8>> cells() const;
 
 private:
-    qint8 mapWidth = 0;
-    qint8 mapHeight = 0;
+    //the STREAM layout has qint8 sizes, up to 127 cells, the COMPACT one quint16 sizes
+    int mapWidth = 0;
+    int mapHeight = 0;
     QVector<QVector<qint8>> _cells;
     void clear();
 };
@@ -125,8 +272,9 @@ struct LowFreqDataPackage : Package {
 
     explicit LowFreqDataPackage();
     explicit LowFreqDataPackage(State state);
-    explicit LowFreqDataPackage(QByteArray &bytes);
+    explicit LowFreqDataPackage(QByteArray &bytes, Layout layout = STREAM);
     QByteArray toBytes() const;
+    QByteArray toBytes(Layout layout) const;
     size_t size() const;
 
 };
@@ -149,8 +297,9 @@ struct HighFreqDataPackage : Package   {
     };
 
     explicit HighFreqDataPackage();
-    explicit HighFreqDataPackage(QByteArray &bytes);
+    explicit HighFreqDataPackage(QByteArray &bytes, Layout layout = STREAM);
     QByteArray toBytes() const;
+    QByteArray toBytes(Layout layout) const;
     size_t size() const;
 };
 
@@ -165,8 +314,23 @@ struct ControlPackage : Package {
     };
 
     explicit ControlPackage();
-    explicit ControlPackage(QByteArray &bytes);
+    explicit ControlPackage(QByteArray &bytes, Layout layout = STREAM);
+    QByteArray toBytes() const;
+    QByteArray toBytes(Layout layout) const;
+    size_t size() const;
+};
+
+//one-time navigation command: go to the map cell
+struct GoalPackage : Package    {
+    static const qint8 packageType = 11;
+    qint32 x = 0;
+    qint32 y = 0;
+
+    explicit GoalPackage();
+    explicit GoalPackage(qint32 x, qint32 y);
+    explicit GoalPackage(QByteArray &bytes, Layout layout = STREAM);
     QByteArray toBytes() const;
+    QByteArray toBytes(Layout layout) const;
     size_t size() const;
 };
 
@@ -207,6 +371,8 @@ struct ControlPackage : Package {
 Q_DECLARE_METATYPE(HighFreqDataPackage);
 Q_DECLARE_METATYPE(LowFreqDataPackage);
 Q_DECLARE_METATYPE(ControlPackage);
+Q_DECLARE_METATYPE(GoalPackage);
 Q_DECLARE_METATYPE(MapPackage);
+Q_DECLARE_METATYPE(SetPackage);
 
 #endif // DATAPACKAGE_H
@@ -0,0 +1,361 @@
+#include "gridplanner.h"
+#include <QtAlgorithms>
+#include <QtMath>
+#include <algorithm>
+
+static const float diagonalCost = 1.41421356f;
+
+//scans the line of the wall bitset from pos in the direction dir (+1/-1) for the first jump point:
+//the goal or a cell with a forced neighbour (free cell beside it, the previous cell beside is a wall)
+//returns -1 if a wall is hit first, lines beside the scanned one and the line ends are always present
+static int scanLine(quint64 const* bits, int stride, int line, int pos, int dir, int goal) {
+    quint64 const* before = bits + (line - 1) * stride;
+    quint64 const* current = bits + line * stride;
+    quint64 const* after = bits + (line + 1) * stride;
+    int word = pos >> 6;
+
+    if (dir > 0)    {
+        quint64 mask = ~0ULL << (pos & 63);
+        for (;; word++, mask = ~0ULL)   {
+            //bit i - the previous cell (i - 1) of the line beside
+            quint64 prevBefore = (before[word] << 1) | (word > 0 ? before[word - 1] >> 63 : 0);
+            quint64 prevAfter = (after[word] << 1) | (word > 0 ? after[word - 1] >> 63 : 0);
+            quint64 stop = (~before[word] & prevBefore) | (~after[word] & prevAfter) | current[word];
+            if (goal >= 0 && (goal >> 6) == word)
+                stop |= 1ULL << (goal & 63);
+            stop &= mask;
+            if (stop == 0)
+                continue;
+            int bit = static_cast<int>(qCountTrailingZeroBits(stop));
+            return (current[word] >> bit) & 1 ? -1 : (word << 6) + bit;
+        }
+    }
+
+    quint64 mask = ~0ULL >> (63 - (pos & 63));
+    for (;; word--, mask = ~0ULL)   {
+        //bit i - the next cell (i + 1) of the line beside
+        quint64 nextBefore = (before[word] >> 1) | (before[word + 1] << 63);
+        quint64 nextAfter = (after[word] >> 1) | (after[word + 1] << 63);
+        quint64 stop = (~before[word] & nextBefore) | (~after[word] & nextAfter) | current[word];
+        if (goal >= 0 && (goal >> 6) == word)
+            stop |= 1ULL << (goal & 63);
+        stop &= mask;
+        if (stop == 0)
+            continue;
+        int bit = 63 - static_cast<int>(qCountLeadingZeroBits(stop));
+        return (current[word] >> bit) & 1 ? -1 : (word << 6) + bit;
+    }
+}
+
+GridPlanner::GridPlanner()  {}
+
+GridPlanner::GridPlanner(MapPackage const& map)  {
+    setMap(map);
+}
+
+void GridPlanner::setMap(MapPackage const& map)  {
+    setSize(map.getWidth(), map.getHeight());
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            if (map.at(y, x) == MapPackage::WALL)
+                setBit(x + 1, y + 1, true);
+}
+
+//padded grid has a wall border, one more word in every line lets the scan read the next word
+void GridPlanner::setSize(int width, int height) {
+    this->width = qMax(width, 0);
+    this->height = qMax(height, 0);
+    pitch = this->width + 2;
+    rowStride = (pitch + 63) / 64 + 1;
+    columnStride = (this->height + 2 + 63) / 64 + 1;
+    rows.fill(0, rowStride * (this->height + 2));
+    columns.fill(0, columnStride * pitch);
+    for (int px = 0; px < pitch; px++)  {
+        setBit(px, 0, true);
+        setBit(px, this->height + 1, true);
+    }
+    for (int py = 0; py < this->height + 2; py++)   {
+        setBit(0, py, true);
+        setBit(pitch - 1, py, true);
+    }
+
+    int cells = pitch * (this->height + 2);
+    cost.fill(0, cells);
+    parent.fill(-1, cells);
+    stamp.fill(0, cells);
+    search = 0;
+    path.clear();
+    pathLength = 0;
+}
+
+bool GridPlanner::wall(int px, int py) const    {
+    return (rows.at(py * rowStride + (px >> 6)) >> (px & 63)) & 1;
+}
+
+void GridPlanner::setBit(int px, int py, bool wall) {
+    quint64 rowBit = 1ULL << (px & 63);
+    quint64 columnBit = 1ULL << (py & 63);
+    quint64 &row = rows[py * rowStride + (px >> 6)];
+    quint64 &column = columns[px * columnStride + (py >> 6)];
+    if (wall)   {
+        row |= rowBit;
+        column |= columnBit;
+    }   else    {
+        row &= ~rowBit;
+        column &= ~columnBit;
+    }
+}
+
+void GridPlanner::setCell(int x, int y, bool wall)   {
+    if (x < 0 || y < 0 || x >= width || y >= height || isWall(x, y) == wall)
+        return;
+    setBit(x + 1, y + 1, wall);
+    if (wall)
+        pathBlocked = pathBlocked || isOnPath(x, y);
+    else
+        cellsCleared = true;
+}
+
+bool GridPlanner::isWall(int x, int y) const    {
+    if (x < 0 || y < 0 || x >= width || y >= height)
+        return true;
+    return wall(x + 1, y + 1);
+}
+
+int GridPlanner::getWidth() const   {
+    return width;
+}
+
+int GridPlanner::getHeight() const  {
+    return height;
+}
+
+float GridPlanner::distance(int dx, int dy)  {
+    dx = qAbs(dx);
+    dy = qAbs(dy);
+    return qAbs(dx - dy) + diagonalCost * qMin(dx, dy);
+}
+
+//jump point from the padded cell (px, py) moving straight, the cell itself is tested too
+//returns padded cell index or -1
+int GridPlanner::jumpStraight(int px, int py, int dx, int dy) const {
+    if (dx) {
+        int x = scanLine(rows.constData(), rowStride, py, px, dx, py == goalY ? goalX : -1);
+        return x < 0 ? -1 : py * pitch + x;
+    }
+    int y = scanLine(columns.constData(), columnStride, px, py, dy, px == goalX ? goalY : -1);
+    return y < 0 ? -1 : y * pitch + px;
+}
+
+//diagonal cell is a jump point if a straight jump from it finds one
+int GridPlanner::jumpDiagonal(int px, int py, int dx, int dy) const {
+    for (;;)    {
+        if (wall(px, py))
+            return -1;
+        if (px == goalX && py == goalY)
+            return py * pitch + px;
+        if (jumpStraight(px + dx, py, dx, 0) >= 0 || jumpStraight(px, py + dy, 0, dy) >= 0)
+            return py * pitch + px;
+        //no corner cutting
+        if (wall(px + dx, py) || wall(px, py + dy))
+            return -1;
+        px += dx;
+        py += dy;
+    }
+}
+
+void GridPlanner::push(int cell, int from, float g)  {
+    if (stamp.at(cell) == search && cost.at(cell) <= g)
+        return;
+    stamp[cell] = search;
+    cost[cell] = g;
+    parent[cell] = from;
+    Open entry;
+    entry.g = g;
+    entry.f = g + distance(cell % pitch - goalX, cell / pitch - goalY);
+    entry.cell = cell;
+    open.append(entry);
+    std::push_heap(open.begin(), open.end());
+}
+
+bool GridPlanner::plan(QPoint const& start, QPoint const& goal)  {
+    this->goal = goal;
+    path.clear();
+    pathLength = 0;
+    pathBlocked = false;
+    cellsCleared = false;
+    expanded = 0;
+    if (isWall(start.x(), start.y()) || isWall(goal.x(), goal.y()))
+        return false;
+
+    if (++search == 0)  {
+        stamp.fill(0);
+        search = 1;
+    }
+    goalX = goal.x() + 1;
+    goalY = goal.y() + 1;
+    int goalCell = goalY * pitch + goalX;
+    open.clear();
+    push((start.y() + 1) * pitch + start.x() + 1, -1, 0);
+
+    //directions to jump from the cell, pruned by the direction of the arrival
+    int directions[8][2];
+    while (!open.isEmpty()) {
+        std::pop_heap(open.begin(), open.end());
+        Open current = open.last();
+        open.removeLast();
+        if (current.g > cost.at(current.cell))
+            continue;
+        if (current.cell == goalCell)
+            break;
+        expanded++;
+
+        int px = current.cell % pitch;
+        int py = current.cell / pitch;
+        int count = 0;
+        int from = parent.at(current.cell);
+        if (from < 0)   {
+            for (int dy = -1; dy <= 1; dy++)
+                for (int dx = -1; dx <= 1; dx++)    {
+                    if ((dx || dy) && !wall(px + dx, py + dy) && (!dx || !dy || (!wall(px + dx, py) && !wall(px, py + dy))))  {
+                        directions[count][0] = dx;
+                        directions[count++][1] = dy;
+                    }
+                }
+        }   else    {
+            int dx = qBound(-1, px - from % pitch, 1);
+            int dy = qBound(-1, py - from / pitch, 1);
+            if (dx && dy)   {
+                bool freeX = !wall(px + dx, py);
+                bool freeY = !wall(px, py + dy);
+                if (freeY)  { directions[count][0] = 0; directions[count++][1] = dy; }
+                if (freeX)  { directions[count][0] = dx; directions[count++][1] = 0; }
+                if (freeX && freeY) { directions[count][0] = dx; directions[count++][1] = dy; }
+            }   else if (dx)    {
+                //a cell beside is forced only if the cell behind it is a wall,
+                //otherwise it is reached by the diagonal step from the previous cell
+                bool next = !wall(px + dx, py);
+                bool up = !wall(px, py - 1) && wall(px - dx, py - 1);
+                bool down = !wall(px, py + 1) && wall(px - dx, py + 1);
+                if (next)   {
+                    directions[count][0] = dx; directions[count++][1] = 0;
+                    if (up)     { directions[count][0] = dx; directions[count++][1] = -1; }
+                    if (down)   { directions[count][0] = dx; directions[count++][1] = 1; }
+                }
+                if (up)     { directions[count][0] = 0; directions[count++][1] = -1; }
+                if (down)   { directions[count][0] = 0; directions[count++][1] = 1; }
+            }   else    {
+                bool next = !wall(px, py + dy);
+                bool left = !wall(px - 1, py) && wall(px - 1, py - dy);
+                bool right = !wall(px + 1, py) && wall(px + 1, py - dy);
+                if (next)   {
+                    directions[count][0] = 0; directions[count++][1] = dy;
+                    if (left)   { directions[count][0] = -1; directions[count++][1] = dy; }
+                    if (right)  { directions[count][0] = 1; directions[count++][1] = dy; }
+                }
+                if (left)   { directions[count][0] = -1; directions[count++][1] = 0; }
+                if (right)  { directions[count][0] = 1; directions[count++][1] = 0; }
+            }
+        }
+
+        for (int i = 0; i < count; i++) {
+            int dx = directions[i][0];
+            int dy = directions[i][1];
+            int jump = dx && dy ? jumpDiagonal(px + dx, py + dy, dx, dy)
+                                : jumpStraight(px + dx, py + dy, dx, dy);
+            if (jump < 0)
+                continue;
+            push(jump, current.cell, current.g + distance(jump % pitch - px, jump / pitch - py));
+        }
+    }
+
+    if (stamp.at(goalCell) != search)
+        return false;
+    for (int cell = goalCell; cell >= 0; cell = parent.at(cell))
+        path.append(QPoint(cell % pitch - 1, cell / pitch - 1));
+    std::reverse(path.begin(), path.end());
+    pathLength = cost.at(goalCell);
+    return true;
+}
+
+bool GridPlanner::replan(QPoint const& start)    {
+    if (path.isEmpty())
+        return plan(start, goal);
+    if (!pathBlocked && !cellsCleared)  {
+        //start is on the path, passed turn points are dropped
+        for (int i = 0; i + 1 < path.size(); i++)   {
+            if (segmentStep(path.at(i), path.at(i + 1), start) < 0)
+                continue;
+            path.remove(0, i + 1);
+            path.prepend(start);
+            pathLength = 0;
+            for (int j = 0; j + 1 < path.size(); j++)
+                pathLength += distance(path.at(j + 1).x() - path.at(j).x(), path.at(j + 1).y() - path.at(j).y());
+            return true;
+        }
+    }
+    return plan(start, goal);
+}
+
+QVector<QPoint> const& GridPlanner::getPath() const {
+    return path;
+}
+
+QPoint GridPlanner::getGoal() const {
+    return goal;
+}
+
+float GridPlanner::getPathLength() const    {
+    return pathLength;
+}
+
+int GridPlanner::getExpanded() const    {
+    return expanded;
+}
+
+//step number of the point on the straight or diagonal segment, -1 if it is not on the segment
+int GridPlanner::segmentStep(QPoint const& from, QPoint const& to, QPoint const& point)  {
+    int dx = qBound(-1, to.x() - from.x(), 1);
+    int dy = qBound(-1, to.y() - from.y(), 1);
+    int steps = qMax(qAbs(to.x() - from.x()), qAbs(to.y() - from.y()));
+    int step = dx ? (point.x() - from.x()) * dx : (point.y() - from.y()) * dy;
+    if (step < 0 || step > steps || from + QPoint(dx, dy) * step != point)
+        return -1;
+    return step;
+}
+
+//a wall blocks the path if it is on it or at a corner of a diagonal step
+bool GridPlanner::isOnPath(int x, int y) const  {
+    QPoint point(x, y);
+    for (int i = 0; i + 1 < path.size(); i++)   {
+        QPoint const& from = path.at(i);
+        QPoint const& to = path.at(i + 1);
+        if (segmentStep(from, to, point) >= 0)
+            return true;
+        int dx = qBound(-1, to.x() - from.x(), 1);
+        int dy = qBound(-1, to.y() - from.y(), 1);
+        if (!dx || !dy)
+            continue;
+        int steps = qAbs(to.x() - from.x());
+        int stepX = segmentStep(from, to, point - QPoint(dx, 0));
+        int stepY = segmentStep(from, to, point - QPoint(0, dy));
+        if ((stepX >= 0 && stepX < steps) || (stepY >= 0 && stepY < steps))
+            return true;
+    }
+    return false;
+}
+
+QVector<QPoint> GridPlanner::cells(QVector<QPoint> const& path) {
+    QVector<QPoint> cells;
+    if (path.isEmpty())
+        return cells;
+    cells.append(path.first());
+    for (int i = 0; i + 1 < path.size(); i++)   {
+        QPoint step(qBound(-1, path.at(i + 1).x() - path.at(i).x(), 1), qBound(-1, path.at(i + 1).y() - path.at(i).y(), 1));
+        for (QPoint cell = path.at(i); cell != path.at(i + 1);) {
+            cell += step;
+            cells.append(cell);
+        }
+    }
+    return cells;
+}
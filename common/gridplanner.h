@@ -0,0 +1,88 @@
+#ifndef GRIDPLANNER_H
+#define GRIDPLANNER_H
+
+#include <QVector>
+#include <QPoint>
+#include "datapackage.h"
+
+/*
+ * Shortest path planner on the occupancy grid of MapPackage (EMPTY/WALL cells).
+ * A* with Jump Point Search, 8-connected, diagonal moves don't cut wall corners.
+ * Walls are stored as bitsets by rows and by columns with a wall border around the map,
+ * so straight jumps test 64 cells per step and need no bounds checks.
+ * Search buffers are allocated once per map size, planning doesn't allocate.
+ * Changed cells are checked against the current path: replan() keeps the path
+ * if no new wall is on it and no wall was removed, otherwise plans again.
+ */
+class GridPlanner
+{
+private:
+    struct Open {
+        float f;
+        float g;
+        int cell;
+        bool operator<(Open const& other) const   { return f > other.f; }  //min-heap
+    };
+
+    int width = 0;
+    int height = 0;
+    int pitch = 0;          //cells per padded row
+    int rowStride = 0;      //words per padded row
+    int columnStride = 0;   //words per padded column
+    QVector<quint64> rows;      //wall bits by rows
+    QVector<quint64> columns;   //wall bits by columns
+
+    //search state by padded cell index, valid for cells with stamp == search
+    QVector<float> cost;
+    QVector<int> parent;
+    QVector<quint32> stamp;
+    quint32 search = 0;
+    QVector<Open> open;
+    int expanded = 0;
+    int goalX = 0;  //padded
+    int goalY = 0;
+
+    QPoint goal;
+    QVector<QPoint> path;
+    float pathLength = 0;
+    bool pathBlocked = false;   //new wall on the path
+    bool cellsCleared = false;  //shorter path may exist
+
+    bool wall(int px, int py) const;
+    void setBit(int px, int py, bool wall);
+    int jumpStraight(int px, int py, int dx, int dy) const;
+    int jumpDiagonal(int px, int py, int dx, int dy) const;
+    void push(int cell, int from, float g);
+    bool isOnPath(int x, int y) const;
+    static int segmentStep(QPoint const& from, QPoint const& to, QPoint const& point);
+    static float distance(int dx, int dy);
+public:
+    GridPlanner();
+    explicit GridPlanner(MapPackage const& map);
+
+    void setMap(MapPackage const& map);
+    //empty map of the size
+    void setSize(int width, int height);
+    void setCell(int x, int y, bool wall);
+    //cells out of the map are walls
+    bool isWall(int x, int y) const;
+    int getWidth() const;
+    int getHeight() const;
+
+    //plans from start to goal, the path is the start, the turn points and the goal
+    bool plan(QPoint const& start, QPoint const& goal);
+    //plans again to the last goal from the new start, the path is reused
+    //if the start is on it and changed cells don't affect it
+    bool replan(QPoint const& start);
+    QVector<QPoint> const& getPath() const;
+    QPoint getGoal() const;
+    //length in cells, diagonal step is sqrt(2)
+    float getPathLength() const;
+    //cells expanded by the last search
+    int getExpanded() const;
+
+    //every cell of the path
+    static QVector<QPoint> cells(QVector<QPoint> const& path);
+};
+
+#endif // GRIDPLANNER_H
@@ -0,0 +1,345 @@
+#include "svmetrics.h"
+#include <QTcpSocket>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static QString number(double value)    {
+    return QString::number(value, 'g', 10);
+}
+
+//labels of the series with the extra label
+static QString braces(QString const& labels, QString const& extra = QString())    {
+    if (labels.isEmpty() && extra.isEmpty())
+        return QString();
+    if (labels.isEmpty() || extra.isEmpty())
+        return "{" + labels + extra + "}";
+    return "{" + labels + "," + extra + "}";
+}
+
+SVCounter::SVCounter() : value(0)   {}
+
+quint64 SVCounter::get() const  {
+    return value.load(std::memory_order_relaxed);
+}
+
+void SVCounter::write(QTextStream &stream, QString const& name, QString const& labels) const  {
+    stream << name << braces(labels) << " " << get() << "\n";
+}
+
+QString SVCounter::summary() const  {
+    return QString::number(get());
+}
+
+SVGauge::SVGauge() : value(0)   {}
+
+qint64 SVGauge::get() const {
+    return value.load(std::memory_order_relaxed);
+}
+
+void SVGauge::write(QTextStream &stream, QString const& name, QString const& labels) const    {
+    stream << name << braces(labels) << " " << get() << "\n";
+}
+
+QString SVGauge::summary() const    {
+    return QString::number(get());
+}
+
+SVHistogram::SVHistogram(QVector<double> const& bounds) :
+    bounds(bounds), buckets(new std::atomic<quint64>[bounds.size() + 1]), count(0), sum(0)  {
+    std::sort(this->bounds.begin(), this->bounds.end());
+    for (int i = 0; i <= bounds.size(); i++)
+        buckets[i].store(0, std::memory_order_relaxed);
+}
+
+SVHistogram::~SVHistogram() {
+    delete[] buckets;
+}
+
+void SVHistogram::observe(double value) {
+    int index = static_cast<int>(std::lower_bound(bounds.constBegin(), bounds.constEnd(), value) - bounds.constBegin());
+    buckets[index].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    double current = sum.load(std::memory_order_relaxed);
+    while (!sum.compare_exchange_weak(current, current + value, std::memory_order_relaxed))  {}
+}
+
+quint64 SVHistogram::getCount() const   {
+    return count.load(std::memory_order_relaxed);
+}
+
+double SVHistogram::getSum() const  {
+    return sum.load(std::memory_order_relaxed);
+}
+
+double SVHistogram::quantile(double q) const    {
+    quint64 total = getCount();
+    if (total == 0)
+        return 0;
+    quint64 target = static_cast<quint64>(std::ceil(q * total));
+    quint64 cumulative = 0;
+    for (int i = 0; i < bounds.size(); i++) {
+        cumulative += buckets[i].load(std::memory_order_relaxed);
+        if (cumulative >= target)
+            return bounds.at(i);
+    }
+    return std::numeric_limits<double>::infinity();
+}
+
+void SVHistogram::write(QTextStream &stream, QString const& name, QString const& labels) const    {
+    quint64 cumulative = 0;
+    for (int i = 0; i < bounds.size(); i++) {
+        cumulative += buckets[i].load(std::memory_order_relaxed);
+        stream << name << "_bucket" << braces(labels, "le=\"" + number(bounds.at(i)) + "\"") << " " << cumulative << "\n";
+    }
+    cumulative += buckets[bounds.size()].load(std::memory_order_relaxed);
+    stream << name << "_bucket" << braces(labels, "le=\"+Inf\"") << " " << cumulative << "\n";
+    stream << name << "_sum" << braces(labels) << " " << number(getSum()) << "\n";
+    stream << name << "_count" << braces(labels) << " " << getCount() << "\n";
+}
+
+QString SVHistogram::summary() const    {
+    quint64 total = getCount();
+    if (total == 0)
+        return "no samples";
+    return QString("count %1, mean %2, p50 <= %3, p99 <= %4")
+            .arg(total).arg(number(getSum() / total)).arg(number(quantile(0.5))).arg(number(quantile(0.99)));
+}
+
+SVMetrics::~SVMetrics() {
+    for (Family const& family : families)
+        for (Series const& series : family.series)
+            delete series.metric;
+}
+
+SVMetrics& SVMetrics::global()  {
+    static SVMetrics metrics;
+    return metrics;
+}
+
+//registers one more user of the series, if there is one of the type
+template <typename Metric>
+Metric* SVMetrics::find(QString const& name, QString const& labels) {
+    for (Family &family : families) {
+        if (family.name != name)
+            continue;
+        for (Series &series : family.series)
+            if (series.labels == labels)    {
+                Metric *metric = dynamic_cast<Metric*>(series.metric);
+                if (metric)
+                    series.references++;
+                return metric;
+            }
+    }
+    return nullptr;
+}
+
+void SVMetrics::add(QString const& name, QString const& help, QString const& type, QString const& labels, SVMetric *metric) {
+    Series series;
+    series.labels = labels;
+    series.metric = metric;
+    series.references = 1;
+    for (Family &family : families)
+        if (family.name == name)    {
+            family.series.append(series);
+            return;
+        }
+    Family family;
+    family.name = name;
+    family.help = help;
+    family.type = type;
+    family.series.append(series);
+    families.append(family);
+}
+
+SVCounter* SVMetrics::counter(QString const& name, QString const& help, QString const& labels)   {
+    QMutexLocker lock(&mutex);
+    if (SVCounter *counter = find<SVCounter>(name, labels))
+        return counter;
+    SVCounter *counter = new SVCounter();
+    add(name, help, "counter", labels, counter);
+    return counter;
+}
+
+SVGauge* SVMetrics::gauge(QString const& name, QString const& help, QString const& labels)   {
+    QMutexLocker lock(&mutex);
+    if (SVGauge *gauge = find<SVGauge>(name, labels))
+        return gauge;
+    SVGauge *gauge = new SVGauge();
+    add(name, help, "gauge", labels, gauge);
+    return gauge;
+}
+
+SVHistogram* SVMetrics::histogram(QString const& name, QString const& help, QVector<double> const& bounds,
+                                  QString const& labels)  {
+    QMutexLocker lock(&mutex);
+    if (SVHistogram *histogram = find<SVHistogram>(name, labels))
+        return histogram;
+    SVHistogram *histogram = new SVHistogram(bounds);
+    add(name, help, "histogram", labels, histogram);
+    return histogram;
+}
+
+void SVMetrics::remove(SVMetric *metric)    {
+    QMutexLocker lock(&mutex);
+    for (int i = 0; i < families.size(); i++)   {
+        QVector<Series> &series = families[i].series;
+        for (int j = 0; j < series.size(); j++)
+            if (series.at(j).metric == metric)  {
+                if (--series[j].references > 0)
+                    return;
+                series.remove(j);
+                if (series.isEmpty())
+                    families.remove(i);
+                delete metric;
+                return;
+            }
+    }
+}
+
+QString SVMetrics::toPrometheus() const {
+    QString text;
+    QTextStream stream(&text);
+    QMutexLocker lock(&mutex);
+    for (Family const& family : families)   {
+        stream << "# HELP " << family.name << " " << family.help << "\n";
+        stream << "# TYPE " << family.name << " " << family.type << "\n";
+        for (Series const& series : family.series)
+            series.metric->write(stream, family.name, series.labels);
+    }
+    stream.flush();
+    return text;
+}
+
+QString SVMetrics::toText() const   {
+    QString text;
+    QTextStream stream(&text);
+    QMutexLocker lock(&mutex);
+    for (Family const& family : families)
+        for (Series const& series : family.series)
+            stream << family.name << braces(series.labels) << "  " << series.metric->summary() << "\n";
+    stream.flush();
+    return text;
+}
+
+QString SVMetrics::label(QString const& name, QString const& value)  {
+    QString escaped = value;
+    escaped.replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n");
+    return name + "=\"" + escaped + "\"";
+}
+
+QString SVMetrics::packageTypeName(qint8 type)  {
+    switch (type)   {
+    case 1: return "auth";
+    case 2: return "auth_answer";
+    case 3: return "task";
+    case 4: return "set";
+    case 5: return "answer";
+    case 6: return "set_request";
+    case 7: return "map";
+    case 8: return "low_freq";
+    case 9: return "high_freq";
+    case 10: return "control";
+    case 11: return "goal";
+    case 12: return "high_freq_delta";
+    default: return "unknown";
+    }
+}
+
+QVector<double> SVMetrics::timeBounds() {
+    return {0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+}
+
+SVPackageCounters::SVPackageCounters(QString const& prefix, QString const& direction, QString const& labels,
+                                     SVMetrics &metrics) :
+    metrics(metrics), prefix(prefix), direction(direction), labels(labels)  {}
+
+SVPackageCounters::~SVPackageCounters() {
+    for (int i = 0; i < types; i++) {
+        if (frames[i])
+            metrics.remove(frames[i]);
+        if (bytes[i])
+            metrics.remove(bytes[i]);
+    }
+}
+
+void SVPackageCounters::count(qint8 type, qint64 size, int number)  {
+    int index = type > 0 && type < types ? type : 0;
+    if (!frames[index]) {
+        QString typeLabel = SVMetrics::label("type", SVMetrics::packageTypeName(static_cast<qint8>(index)));
+        QString series = labels.isEmpty() ? typeLabel : labels + "," + typeLabel;
+        frames[index] = metrics.counter(prefix + "_frames_" + direction + "_total",
+                                        "Packages " + direction + " by type.", series);
+        bytes[index] = metrics.counter(prefix + "_bytes_" + direction + "_total",
+                                       "Bytes " + direction + " by package type, with the size prefix.", series);
+    }
+    frames[index]->add(static_cast<quint64>(number));
+    bytes[index]->add(static_cast<quint64>(size) * static_cast<quint64>(number));
+}
+
+SVLoopLag::SVLoopLag(QString const& name, QString const& labels, QObject *parent, SVMetrics &metrics) :
+    QObject(parent), timer(this), metrics(metrics)  {
+    lag = metrics.histogram(name, "Delay of a periodic timer of the event loop, seconds.", SVMetrics::timeBounds(), labels);
+    timer.setTimerType(Qt::PreciseTimer);
+    timer.setInterval(interval);
+    connect(&timer, SIGNAL(timeout()), this, SLOT(slotTick()));
+}
+
+SVLoopLag::~SVLoopLag() {
+    metrics.remove(lag);
+}
+
+void SVLoopLag::slotStart() {
+    clock.start();
+    timer.start();
+}
+
+void SVLoopLag::slotTick()  {
+    qint64 elapsed = clock.nsecsElapsed();
+    clock.restart();
+    lag->observe(qMax<qint64>(0, elapsed - interval * 1000000LL) / 1e9);
+}
+
+SVMetricsServer::SVMetricsServer(QObject *parent, SVMetrics &metrics) :
+    QObject(parent), server(this), metrics(metrics)    {
+    connect(&server, SIGNAL(newConnection()), this, SLOT(slotNewConnection()));
+}
+
+bool SVMetricsServer::start(QHostAddress const& address, quint16 port)  {
+    if (!server.listen(address, port))  {
+        qDebug() << "Metrics: can't listen on port" << port << server.errorString();
+        return false;
+    }
+    qDebug() << "Metrics: http://" + address.toString() + ":" + QString::number(server.serverPort()) + "/metrics";
+    return true;
+}
+
+quint16 SVMetricsServer::getPort() const    {
+    return server.serverPort();
+}
+
+//answers the request line, headers of the request are not needed
+void SVMetricsServer::slotNewConnection()   {
+    while (QTcpSocket *socket = server.nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket] {
+            if (!socket->canReadLine())
+                return;
+            QList<QByteArray> request = socket->readLine().trimmed().split(' ');
+            QByteArray status = "200 OK";
+            QByteArray body;
+            if (request.size() < 2 || request.at(0) != "GET")
+                status = "405 Method Not Allowed";
+            else if (request.at(1) != "/metrics" && request.at(1) != "/")
+                status = "404 Not Found";
+            else
+                body = metrics.toPrometheus().toUtf8();
+            socket->write("HTTP/1.0 " + status + "\r\n"
+                          "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                          "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                          "Connection: close\r\n\r\n" + body);
+            socket->disconnectFromHost();
+        });
+    }
+}
@@ -0,0 +1,200 @@
+#ifndef SVMETRICS_H
+#define SVMETRICS_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QMutex>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QTcpServer>
+#include <QHostAddress>
+#include <QTextStream>
+#include <atomic>
+
+/*
+ * Runtime metrics of the client and the server.
+ * Counters, gauges and histograms are updated lock-free from any thread and
+ * read by the metrics panel of the GUI and by the Prometheus text endpoint.
+ * Metric objects are owned by the registry and stay valid until removed
+ * as many times as they were registered.
+ */
+class SVMetric
+{
+    friend class SVMetrics;
+protected:
+    virtual void write(QTextStream &stream, QString const& name, QString const& labels) const = 0;
+    virtual QString summary() const = 0;
+public:
+    virtual ~SVMetric() = default;
+};
+
+class SVCounter : public SVMetric
+{
+private:
+    std::atomic<quint64> value;
+protected:
+    void write(QTextStream &stream, QString const& name, QString const& labels) const override;
+    QString summary() const override;
+public:
+    SVCounter();
+    void add(quint64 count = 1)  {
+        value.fetch_add(count, std::memory_order_relaxed);
+    }
+    quint64 get() const;
+};
+
+class SVGauge : public SVMetric
+{
+private:
+    std::atomic<qint64> value;
+protected:
+    void write(QTextStream &stream, QString const& name, QString const& labels) const override;
+    QString summary() const override;
+public:
+    SVGauge();
+    void set(qint64 value)  {
+        this->value.store(value, std::memory_order_relaxed);
+    }
+    void add(qint64 delta)  {
+        value.fetch_add(delta, std::memory_order_relaxed);
+    }
+    qint64 get() const;
+};
+
+//cumulative buckets by upper bounds, the last bucket is +Inf
+class SVHistogram : public SVMetric
+{
+private:
+    QVector<double> bounds;
+    std::atomic<quint64> *buckets;
+    std::atomic<quint64> count;
+    std::atomic<double> sum;
+protected:
+    void write(QTextStream &stream, QString const& name, QString const& labels) const override;
+    QString summary() const override;
+public:
+    explicit SVHistogram(QVector<double> const& bounds);
+    ~SVHistogram() override;
+    SVHistogram(SVHistogram const&) = delete;
+    SVHistogram& operator=(SVHistogram const&) = delete;
+
+    void observe(double value);
+    quint64 getCount() const;
+    double getSum() const;
+    //upper bound of the bucket holding the quantile
+    double quantile(double q) const;
+};
+
+class SVMetrics
+{
+private:
+    struct Series {
+        QString labels;
+        SVMetric *metric;
+        int references;     //registrations not removed yet
+    };
+    struct Family {
+        QString name;
+        QString help;
+        QString type;
+        QVector<Series> series;
+    };
+
+    mutable QMutex mutex;
+    QVector<Family> families;
+
+    template <typename Metric>
+    Metric* find(QString const& name, QString const& labels);
+    void add(QString const& name, QString const& help, QString const& type, QString const& labels, SVMetric *metric);
+public:
+    SVMetrics() = default;
+    ~SVMetrics();
+    SVMetrics(SVMetrics const&) = delete;
+    SVMetrics& operator=(SVMetrics const&) = delete;
+
+    //metrics of the process
+    static SVMetrics& global();
+
+    //the same name and labels give the same metric, labels are like a="1",b="2";
+    //every registration is paired with a remove, the last one deletes the metric
+    SVCounter* counter(QString const& name, QString const& help, QString const& labels = QString());
+    SVGauge* gauge(QString const& name, QString const& help, QString const& labels = QString());
+    SVHistogram* histogram(QString const& name, QString const& help, QVector<double> const& bounds,
+                           QString const& labels = QString());
+    void remove(SVMetric *metric);
+
+    //Prometheus text exposition format 0.0.4
+    QString toPrometheus() const;
+    //one line per series for the metrics panel
+    QString toText() const;
+
+    static QString label(QString const& name, QString const& value);
+    static QString packageTypeName(qint8 type);
+    //seconds, 100 us .. 10 s
+    static QVector<double> timeBounds();
+};
+
+//frames and bytes of each package type in one direction,
+//series of a type are created by its first package and removed with the object
+class SVPackageCounters
+{
+private:
+    static const int types = 16;
+
+    SVMetrics &metrics;
+    QString prefix;
+    QString direction;
+    QString labels;
+    SVCounter *frames[types] = {};
+    SVCounter *bytes[types] = {};
+public:
+    SVPackageCounters(QString const& prefix, QString const& direction, QString const& labels = QString(),
+                      SVMetrics &metrics = SVMetrics::global());
+    ~SVPackageCounters();
+    SVPackageCounters(SVPackageCounters const&) = delete;
+    SVPackageCounters& operator=(SVPackageCounters const&) = delete;
+
+    //number of frames of the same size
+    void count(qint8 type, qint64 size, int number = 1);
+};
+
+//lateness of a periodic timer in the thread of the object, i.e. how long events wait in its loop
+class SVLoopLag : public QObject
+{
+    Q_OBJECT
+private:
+    static const int interval = 100;   //msec
+
+    QTimer timer;
+    QElapsedTimer clock;
+    SVHistogram *lag;
+    SVMetrics &metrics;
+private slots:
+    void slotTick();
+public:
+    SVLoopLag(QString const& name, QString const& labels = QString(), QObject *parent = nullptr,
+              SVMetrics &metrics = SVMetrics::global());
+    ~SVLoopLag();
+public slots:
+    //starts in the current thread of the object
+    void slotStart();
+};
+
+//plain HTTP endpoint for Prometheus scrapes, every GET gets the whole registry
+class SVMetricsServer : public QObject
+{
+    Q_OBJECT
+private:
+    QTcpServer server;
+    SVMetrics &metrics;
+private slots:
+    void slotNewConnection();
+public:
+    explicit SVMetricsServer(QObject *parent = nullptr, SVMetrics &metrics = SVMetrics::global());
+
+    bool start(QHostAddress const& address, quint16 port);
+    quint16 getPort() const;
+};
+
+#endif // SVMETRICS_H
@@ -1,11 +1,40 @@
 #include "svserver.h"
+#include "svtrace.h"
 
 Server::Server(QObject* parent)    {
     this->setParent(parent);
 }
 
-SVServer::SVServer()   {
+int SVServer::servers = 0;
+
+//true for the packages of the share, agreed of every available ones, evenly spread
+static bool takeShare(quint32 &credit, quint16 agreed, quint16 available)  {
+    if (agreed == 0 || available == 0 || agreed >= available)
+        return true;
+    credit += agreed;
+    if (credit < available)
+        return false;
+    credit -= available;
+    return true;
+}
+
+QString SVServer::nextLabels()  {
+    return SVMetrics::label("server", QString::number(++servers));
+}
+
+SVServer::SVServer() :
+    labels(nextLabels()), received("svserver", "received", labels), sent("svserver", "sent", labels)   {
     log("Server initializing...");
+    SVMetrics &metrics = SVMetrics::global();
+    decodeErrors = metrics.counter("svserver_decode_errors_total", "Packages of unknown type.", labels);
+    connectionsGauge = metrics.gauge("svserver_connections", "Connected clients.", labels);
+    handshakeTime = metrics.histogram("svserver_handshake_seconds", "Time from the connection to the valid auth package.",
+                                      SVMetrics::timeBounds(), labels);
+    clock.start();
+    //the probe starts in the thread the server is running in
+    loopLag = new SVLoopLag("svserver_event_loop_lag_seconds", labels, this);
+    QMetaObject::invokeMethod(loopLag, "slotStart", Qt::QueuedConnection);
+
     server = new Server(this);
     connect(server, SIGNAL(newConnection()), this, SLOT(slotNewConnection()));
     connect(server, SIGNAL(acceptError(QAbstractSocket::SocketError)), this, SLOT(slotAcceptError(QAbstractSocket::SocketError)));
@@ -19,6 +48,12 @@ SVServer::~SVServer()   {
         socket->close();
         delete socket;
     }
+    for (QTcpSocket *socket : peers.keys())
+        removePeer(socket);
+    SVMetrics &metrics = SVMetrics::global();
+    metrics.remove(decodeErrors);
+    metrics.remove(connectionsGauge);
+    metrics.remove(handshakeTime);
 }
 
 void SVServer::log(QString const& message) {
@@ -117,23 +152,48 @@ void SVServer::sendAll(AnswerPackage const &answer) {
     sendAll(answer.toBytes());
 }
 
-void SVServer::sendTo(QTcpSocket* socket, QString const& data)   {
-    char *bytes = new char[static_cast<size_t>(data.size() + 2)];
-    bytes[0] = static_cast<char>(data.size());
-    for (int i = 0; i < data.size(); i++)    {
-        bytes[i + 1] = static_cast<char>(data.data()[i].toLatin1());
+void SVServer::sendAll(Package const& package)  {
+    if (!server->isListening())  {
+        log("Warning! Server is disabled.");
+        return;
     }
-    bytes[data.size() + 1] = '\0';
-    socket->write(bytes);
+    QByteArray layouts[2];
+    foreach (QTcpSocket* socket, connections)  {
+        Package::Layout layout = peers.value(socket).capabilities.layout();
+        if (layouts[layout].isEmpty())
+            layouts[layout] = package.toBytes(layout);
+        sendTo(socket, layouts[layout]);
+    }
+}
 
-    delete[] bytes;
+void SVServer::sendTo(QTcpSocket* socket, QString const& data)   {
+    sendTo(socket, data.toLatin1());
 }
 
+//in the framing agreed with the client, packages over its frame size are dropped
 void SVServer::sendTo(QTcpSocket *socket, QByteArray const &data)   {
-    QByteArray bytes;
-    bytes.append(static_cast<char>(data.size()));
-    bytes.append(data);
+    SV_TRACE("SVServer socket write");
+    Capabilities const& agreed = peers.value(socket).capabilities;
+    if (data.size() > agreed.maxFrameSize)  {
+        log("Warning! Package of " + QString::number(data.size()) + " bytes is too long for the client.");
+        return;
+    }
+    QByteArray bytes = PackageFrame::wrap(data, agreed.longFrames());
     socket->write(bytes);
+    sent.count(data.isEmpty() ? 0 : static_cast<qint8>(data.at(0)), bytes.size());
+    updateBacklog(socket);
+}
+
+void SVServer::updateBacklog(QTcpSocket *socket)    {
+    if (SVGauge *backlog = peers.value(socket).backlog)
+        backlog->set(socket->bytesToWrite());
+}
+
+void SVServer::removePeer(QTcpSocket *socket)   {
+    Peer peer = peers.take(socket);
+    delete peer.encoder;
+    if (peer.backlog)
+        SVMetrics::global().remove(peer.backlog);
 }
 
 void SVServer::sendTo(QTcpSocket *socket, AnswerPackage const &answer)  {
@@ -160,11 +220,40 @@ int SVServer::activeConnections() const {
     return connections.size();
 }
 
+void SVServer::setCapabilities(Capabilities const& capabilities)    {
+    this->capabilities = capabilities;
+}
+
+Capabilities const& SVServer::getCapabilities() const   {
+    return capabilities;
+}
+
+void SVServer::setCompression(bool enabled) {
+    if (enabled)
+        capabilities.encodings |= 1 << Capabilities::DELTA;
+    else
+        capabilities.encodings &= ~(1 << Capabilities::DELTA);
+}
+
+void SVServer::setTelemetryRates(quint16 highFreqRate, quint16 lowFreqRate) {
+    capabilities.highFreqRate = highFreqRate;
+    capabilities.lowFreqRate = lowFreqRate;
+}
+
 void SVServer::slotNewConnection()  {
     QTcpSocket* newConnection = dynamic_cast<QTcpSocket*>(server->nextPendingConnection());
     log("New connection: socket descriptor " + QString::number(newConnection->socketDescriptor()));
     if (newConnection != nullptr)
         connections.insert(newConnection->socketDescriptor(), newConnection);
+    Peer peer;
+    peer.connectTime = clock.nsecsElapsed();
+    peer.backlog = SVMetrics::global().gauge("svserver_send_backlog_bytes", "Bytes not written to the client yet.",
+                                             labels + "," + SVMetrics::label("client", QString::number(newConnection->socketDescriptor())));
+    peers.insert(newConnection, peer);
+    connectionsGauge->set(connections.size());
+    connect(newConnection, &QTcpSocket::bytesWritten, this, [this, newConnection] {
+        updateBacklog(newConnection);
+    });
 
     connect(newConnection, SIGNAL(disconnected()), this, SLOT(slotClientDisconnected()));
     connect(newConnection, SIGNAL(readyRead()),this, SLOT(slotReadyRead()));
@@ -179,49 +268,80 @@ void SVServer::slotClientDisconnected() {
     log("Client disconnected");
     QTcpSocket* disconnectedClient = dynamic_cast<QTcpSocket*>(sender());
     connections.remove(connections.key(disconnectedClient));
+    connectionsGauge->set(connections.size());
+    removePeer(disconnectedClient);
     emit signalDisconnected(disconnectedClient->socketDescriptor());
     disconnectedClient->deleteLater();
 }
 
+//all the packages received completely, the rest waits for the next readyRead
 void SVServer::slotReadyRead()  {
+    SV_TRACE("SVServer::slotReadyRead");
     log("Incoming data");
     QTcpSocket* client = dynamic_cast<QTcpSocket*>(sender());
 
-    if (client->bytesAvailable())   {
-        char blockSize = 0;
-        client->read(&blockSize, 1);
-        QByteArray bytes = client->read(blockSize);
-        QString message(bytes);
-        if (message.endsWith("\r\n"))
-            message.chop(2);
-
-        log("Data[" + QString::number(blockSize) + "]: " + message);
-
-        if (bytes.at(0) == AuthPackage::packageType)    {
-            if (message.endsWith(validAuthPackage.authRequest)) {
-                log("Valid GUI device connected.");
-                sendTo(client, AuthAnswerPackage(1, 2, 3));
-                emit signalNewConnection(client->socketDescriptor());
-            }
-        }   else if (bytes.at(0) == SetPackage::packageType)  {
-            SetPackage set(bytes);
-            emit signalSetSteering(set.steering_p, set.steering_i, set.steering_d, set.steering_servoZero);
-            emit signalSetForward(set.forward_p, set.forward_i, set.forward_d, set.forward_int);
-            emit signalSetBackward(set.backward_p, set.backward_i, set.backward_d, set.backward_int);
-            log("Incoming new settings");
-        }   else if (bytes.at(0) == SetRequestPackage::packageType)   {
-            emit signalUploadSettings();
-            log("Incoming settings request");
-        } else if (bytes.at(0) == ControlPackage::packageType)  {
-            ControlPackage control(bytes);
-            qDebug() << "Control: " << control.xAxis << " : " << control.yAxis;
-            emit signalControl(control);
-        } else {
-            log("Corrupted or illegal package.");
-        }
+    QByteArray bytes;
+    while (peers.contains(client) && PackageFrame::read(client, peers.value(client).capabilities.longFrames(), bytes))
+        handlePackage(client, bytes);
+}
+
+void SVServer::handlePackage(QTcpSocket *client, QByteArray &bytes) {
+    Package::Layout layout = peers.value(client).capabilities.layout();
+    QString message(bytes);
+    if (message.endsWith("\r\n"))
+        message.chop(2);
+
+    log("Data[" + QString::number(bytes.size()) + "]: " + message);
+    received.count(bytes.isEmpty() ? 0 : static_cast<qint8>(bytes.at(0)), bytes.size() + 1);
+
+    if (bytes.isEmpty())    {
+        decodeErrors->add();
+        log("Empty package.");
+    }   else if (bytes.at(0) == AuthPackage::packageType)    {
+        if (message.endsWith(validAuthPackage.authRequest))
+            authorize(client, bytes);
+    }   else if (bytes.at(0) == SetPackage::packageType)  {
+        SetPackage set(bytes, layout);
+        emit signalSetSteering(set.steering_p, set.steering_i, set.steering_d, set.steering_servoZero);
+        emit signalSetForward(set.forward_p, set.forward_i, set.forward_d, set.forward_int);
+        emit signalSetBackward(set.backward_p, set.backward_i, set.backward_d, set.backward_int);
+        log("Incoming new settings");
+    }   else if (bytes.at(0) == SetRequestPackage::packageType)   {
+        emit signalUploadSettings();
+        log("Incoming settings request");
+    } else if (bytes.at(0) == ControlPackage::packageType)  {
+        ControlPackage control(bytes, layout);
+        qCDebug(svPackages) << "Control: " << control.xAxis << " : " << control.yAxis;
+        emit signalControl(control);
+    } else if (bytes.at(0) == GoalPackage::packageType)  {
+        GoalPackage goal(bytes, layout);
+        log("Incoming goal: " + QString::number(goal.x) + ", " + QString::number(goal.y));
+        emit signalTaskGoal(goal.x, goal.y);
+    } else {
+        decodeErrors->add();
+        log("Corrupted or illegal package.");
     }
 }
 
+//the answer goes in the old framing, the agreed capabilities are used after it
+void SVServer::authorize(QTcpSocket *client, QByteArray &bytes)   {
+    log("Valid GUI device connected.");
+    AuthPackage auth(bytes);
+    AuthAnswerPackage answer(1, 2, 3);
+    answer.capabilities = Capabilities::negotiate(auth.capabilities, capabilities);
+    Capabilities const& agreed = answer.capabilities;
+    sendTo(client, answer);
+
+    Peer &peer = peers[client];
+    peer.capabilities = agreed;
+    delete peer.encoder;
+    peer.encoder = agreed.encoding() == Capabilities::DELTA ? new TelemetryEncoder() : nullptr;
+    log("Protocol version " + QString::number(agreed.version) + ", frames up to " + QString::number(agreed.maxFrameSize) +
+        " bytes, layout " + QString::number(agreed.layout()) + ", telemetry encoding " + QString::number(agreed.encoding()));
+    handshakeTime->observe((clock.nsecsElapsed() - peer.connectTime) / 1e9);
+    emit signalNewConnection(client->socketDescriptor());
+}
+
 void SVServer::slotUIStart(QString adress, quint16 port) {
     start(QHostAddress(adress), port);
 }
@@ -239,25 +359,56 @@ void SVServer::slotUITestData(qint32 encoderValue, qint32 potentiometerValue) {
     data.m_steeringAngle = potentiometerValue;
     data.m_encoderValue = encoderValue;
 
-    sendAll(data.toBytes());
+    sendAll(data);
 }
 
 void SVServer::slotTaskDone(qint8 answerType)   {
     sendAll(AnswerPackage(answerType));
 }
 
+//every compressed client has its own stream of deltas
 void SVServer::slotSendHighFreqData(HighFreqDataPackage const& data)   {
-    sendAll(data.toBytes());
+    if (!server->isListening())  {
+        log("Warning! Server is disabled.");
+        return;
+    }
+    QByteArray layouts[2];
+    foreach (QTcpSocket* socket, connections)  {
+        Peer &peer = peers[socket];
+        if (!takeShare(peer.highFreqCredit, peer.capabilities.highFreqRate, capabilities.highFreqRate))
+            continue;
+        if (peer.encoder) {
+            sendTo(socket, peer.encoder->encode(data));
+        }   else    {
+            Package::Layout layout = peer.capabilities.layout();
+            if (layouts[layout].isEmpty())
+                layouts[layout] = data.toBytes(layout);
+            sendTo(socket, layouts[layout]);
+        }
+    }
 }
 
 void SVServer::slotSendLowFreqData(LowFreqDataPackage const& data)   {
-    sendAll(data.toBytes());
+    if (!server->isListening())  {
+        log("Warning! Server is disabled.");
+        return;
+    }
+    QByteArray layouts[2];
+    foreach (QTcpSocket* socket, connections)  {
+        Peer &peer = peers[socket];
+        if (!takeShare(peer.lowFreqCredit, peer.capabilities.lowFreqRate, capabilities.lowFreqRate))
+            continue;
+        Package::Layout layout = peer.capabilities.layout();
+        if (layouts[layout].isEmpty())
+            layouts[layout] = data.toBytes(layout);
+        sendTo(socket, layouts[layout]);
+    }
 }
 
 void SVServer::slotSendSettings(SetPackage const& set)   {
-    sendAll(set.toBytes());
+    sendAll(set);
 }
 
 void SVServer::slotSendMap(MapPackage const& map)  {
-    sendAll(map.toBytes());
+    sendAll(map);
 }
@@ -11,7 +11,11 @@
 #include <QThread>
 #include <QTime>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QHash>
 #include "datapackage.h"
+#include "svmetrics.h"
+#include "telemetrycodec.h"
 
 class Server : public QTcpServer    {
     Q_OBJECT
@@ -32,6 +36,36 @@ private:
      * в качестве ключа используется socket->socketDescriptor()
      */
     AuthPackage validAuthPackage;    
+    Capabilities capabilities = Capabilities::local();   //offered to the clients
+
+    //state of a connected client
+    struct Peer {
+        Capabilities capabilities;      //agreed by the auth answer, version 1 before it
+        TelemetryEncoder *encoder = nullptr;    //DELTA encoding
+        SVGauge *backlog = nullptr;     //bytes not written to the client yet
+        qint64 connectTime = 0;         //nsec of the clock
+        //telemetry is produced at the offered rates, a peer with lower agreed rates gets a share of it
+        quint32 highFreqCredit = 0;
+        quint32 lowFreqCredit = 0;
+    };
+    QHash<QTcpSocket*, Peer> peers;
+
+    //metrics of the server are labeled by its number in the process
+    static int servers;
+    QString labels;
+    SVPackageCounters received;
+    SVPackageCounters sent;
+    SVCounter *decodeErrors;
+    SVGauge *connectionsGauge;
+    SVHistogram *handshakeTime;
+    QElapsedTimer clock;
+    SVLoopLag *loopLag;
+
+    static QString nextLabels();
+    void updateBacklog(QTcpSocket *socket);
+    void removePeer(QTcpSocket *socket);
+    void handlePackage(QTcpSocket *client, QByteArray &bytes);
+    void authorize(QTcpSocket *client, QByteArray &bytes);
 
     void sendTo(QTcpSocket* socket, QString const& data);
     void sendTo(QTcpSocket* socket, QByteArray const& data);
@@ -51,11 +85,18 @@ public:
     void sendAll(QString const& data);
     void sendAll(QByteArray const& data);
     void sendAll(AnswerPackage const& answer);
+    //in the layout agreed with every client
+    void sendAll(Package const& package);
 
     QHostAddress getHostAddress() const;
     quint16 getPort() const;
     bool isListening() const;
     int activeConnections() const;
+    //offered to the clients connecting later
+    void setCapabilities(Capabilities const& capabilities);
+    Capabilities const& getCapabilities() const;
+    void setCompression(bool enabled);
+    void setTelemetryRates(quint16 highFreqRate, quint16 lowFreqRate);
 private slots:
     void slotNewConnection();
     void slotAcceptError(QAbstractSocket::SocketError error);
@@ -80,6 +121,7 @@ signals:
     void signalTaskForward(float distantion);
     void signalTaskWheels(float angle);
     void signalTaskFlick();
+    void signalTaskGoal(qint32 x, qint32 y);
     void signalSetSteering(float p, float i, float d, float zero);
     void signalSetForward(float p, float i, float d, float integrator);
     void signalSetBackward(float p, float i, float d, float integrator);
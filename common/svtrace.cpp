@@ -0,0 +1,116 @@
+#include "svtrace.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+
+std::atomic<bool> SVTrace::active(false);
+QMutex SVTrace::registryMutex;
+QVector<SVTrace::Buffer*> SVTrace::buffers;
+
+SVTrace::Buffer* SVTrace::threadBuffer()    {
+    static thread_local Buffer *buffer = nullptr;
+    if (buffer)
+        return buffer;
+
+    buffer = new Buffer();
+    buffer->events.resize(bufferSize);
+    QThread *thread = QThread::currentThread();
+    QCoreApplication *application = QCoreApplication::instance();
+    buffer->threadName = thread->objectName();
+    if (application && thread == application->thread())
+        buffer->threadName = "Main";
+    QMutexLocker lock(&registryMutex);
+    buffer->thread = buffers.size() + 1;
+    if (buffer->threadName.isEmpty())
+        buffer->threadName = "Thread " + QString::number(buffer->thread);
+    buffers.append(buffer);
+    return buffer;
+}
+
+void SVTrace::setEnabled(bool enabled)  {
+    active.store(enabled, std::memory_order_relaxed);
+}
+
+void SVTrace::record(char const* name, qint64 start, qint64 end)    {
+    Buffer *buffer = threadBuffer();
+    QMutexLocker lock(&buffer->mutex);
+    Event &event = buffer->events[static_cast<int>(buffer->written % bufferSize)];
+    event.name = name;
+    event.start = start;
+    event.duration = end - start;
+    buffer->written++;
+}
+
+static QString escaped(char const* name)    {
+    QString text = QString::fromLatin1(name);
+    text.replace('\\', "\\\\");
+    text.replace('"', "\\\"");
+    return text;
+}
+
+//complete ("X") events in microseconds from the first event, one track per thread
+bool SVTrace::dump(QString const& fileName)    {
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))  {
+        qDebug() << "Trace: can't open " << fileName;
+        return false;
+    }
+
+    struct Track {
+        int thread;
+        QString name;
+        QVector<Event> events;
+    };
+    QVector<Track> tracks;
+    qint64 origin = -1;
+    {
+        QMutexLocker registryLock(&registryMutex);
+        for (Buffer *buffer : buffers)  {
+            QMutexLocker lock(&buffer->mutex);
+            Track track;
+            track.thread = buffer->thread;
+            track.name = buffer->threadName;
+            qint64 first = qMax<qint64>(0, buffer->written - bufferSize);
+            track.events.reserve(static_cast<int>(buffer->written - first));
+            for (qint64 i = first; i < buffer->written; i++)    {
+                Event const& event = buffer->events.at(static_cast<int>(i % bufferSize));
+                track.events.append(event);
+                if (origin < 0 || event.start < origin)
+                    origin = event.start;
+            }
+            tracks.append(track);
+        }
+    }
+
+    qint64 pid = QCoreApplication::applicationPid();
+    QTextStream stream(&file);
+    stream << "{\"traceEvents\":[\n";
+    bool first = true;
+    int count = 0;
+    for (Track const& track : tracks)   {
+        stream << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+               << ",\"tid\":" << track.thread << ",\"args\":{\"name\":\"" << track.name << "\"}}";
+        first = false;
+        for (Event const& event : track.events) {
+            stream << ",\n{\"name\":\"" << escaped(event.name) << "\",\"ph\":\"X\",\"pid\":" << pid
+                   << ",\"tid\":" << track.thread
+                   << ",\"ts\":" << QString::number((event.start - origin) / 1000.0, 'f', 3)
+                   << ",\"dur\":" << QString::number(event.duration / 1000.0, 'f', 3) << "}";
+        }
+        count += track.events.size();
+    }
+    stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    stream.flush();
+    qDebug() << "Trace:" << count << "events of" << tracks.size() << "threads written to" << fileName;
+    return stream.status() == QTextStream::Ok;
+}
+
+void SVTrace::clear()   {
+    QMutexLocker registryLock(&registryMutex);
+    for (Buffer *buffer : buffers)  {
+        QMutexLocker lock(&buffer->mutex);
+        buffer->written = 0;
+    }
+}
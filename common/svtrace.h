@@ -0,0 +1,79 @@
+#ifndef SVTRACE_H
+#define SVTRACE_H
+
+#include <QString>
+#include <QVector>
+#include <QMutex>
+#include <atomic>
+#include <chrono>
+
+/*
+ * Scoped trace points of the telemetry pipeline, dumped in Chrome trace format
+ * (chrome://tracing, ui.perfetto.dev). SV_TRACE("name") records the time the scope takes
+ * as a complete event into the buffer of the current thread, a ring of the last
+ * bufferSize events. Names must be string literals, recording doesn't allocate.
+ * When tracing is off a trace point is one relaxed atomic load.
+ */
+class SVTrace
+{
+public:
+    struct Event {
+        char const* name = nullptr;
+        qint64 start = 0;   //nsec of the trace clock
+        qint64 duration = 0;
+    };
+private:
+    static const int bufferSize = 1 << 16;  //events per thread
+
+    //written by its thread, read by dump()
+    struct Buffer {
+        QMutex mutex;
+        QVector<Event> events;
+        qint64 written = 0;
+        int thread = 0;
+        QString threadName;
+    };
+
+    static std::atomic<bool> active;
+    //buffers of all the threads, buffers of finished threads are kept for the dump
+    static QMutex registryMutex;
+    static QVector<Buffer*> buffers;
+
+    static Buffer* threadBuffer();
+public:
+    static bool isEnabled()  {
+        return active.load(std::memory_order_relaxed);
+    }
+    static void setEnabled(bool enabled);
+    static qint64 now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    //event measured by the caller, e.g. between two signals
+    static void record(char const* name, qint64 start, qint64 end);
+    //writes events of all the threads as JSON, the buffers are kept
+    static bool dump(QString const& fileName);
+    static void clear();
+};
+
+class SVTraceScope
+{
+private:
+    char const* name;
+    qint64 start;
+public:
+    explicit SVTraceScope(char const* name) :
+        name(SVTrace::isEnabled() ? name : nullptr), start(this->name ? SVTrace::now() : 0)   {}
+    ~SVTraceScope() {
+        if (name)
+            SVTrace::record(name, start, SVTrace::now());
+    }
+    SVTraceScope(SVTraceScope const&) = delete;
+    SVTraceScope& operator=(SVTraceScope const&) = delete;
+};
+
+#define SV_TRACE_CONCAT2(a, b) a##b
+#define SV_TRACE_CONCAT(a, b) SV_TRACE_CONCAT2(a, b)
+#define SV_TRACE(name) SVTraceScope SV_TRACE_CONCAT(svTraceScope, __LINE__)(name)
+
+#endif // SVTRACE_H
@@ -0,0 +1,240 @@
+#include "telemetrybatch.h"
+#include <QtEndian>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SV_BATCH_X86
+#define SV_TARGET(name) __attribute__((target(name)))
+#include <immintrin.h>
+#endif
+
+//field offsets in the package, timeStamp first
+static const int streamFrameSize = 1 + 4 + 5 * (Package::streamTagSize + 8);
+static const int streamFields[5] = {9, 21, 33, 45, 57};
+static const int compactFields[5] = {
+    offsetof(CompactHighFreqDataPackage, encoderValue),
+    offsetof(CompactHighFreqDataPackage, steeringAngle),
+    offsetof(CompactHighFreqDataPackage, x),
+    offsetof(CompactHighFreqDataPackage, y),
+    offsetof(CompactHighFreqDataPackage, angle)
+};
+static const int timeStampOffset = 1;
+
+struct Output {
+    quint32 *timeStamps;
+    float *fields[5];   //encoder, steering, x, y, angle
+};
+
+static void decodeStream(char const* data, qint32 const* offsets, int from, int count, Output const& out)  {
+    for (int i = from; i < count; i++)  {
+        char const* frame = data + offsets[i];
+        out.timeStamps[i] = qFromBigEndian<quint32>(frame + timeStampOffset);
+        for (int field = 0; field < 5; field++) {
+            quint64 bits = qFromBigEndian<quint64>(frame + streamFields[field]);
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            out.fields[field][i] = static_cast<float>(value);
+        }
+    }
+}
+
+static void decodeCompact(char const* data, qint32 const* offsets, int from, int count, Output const& out) {
+    for (int i = from; i < count; i++)  {
+        char const* frame = data + offsets[i];
+        out.timeStamps[i] = qFromLittleEndian<quint32>(frame + timeStampOffset);
+        for (int field = 0; field < 5; field++) {
+            quint32 bits = qFromLittleEndian<quint32>(frame + compactFields[field]);
+            std::memcpy(out.fields[field] + i, &bits, sizeof(float));
+        }
+    }
+}
+
+#ifdef SV_BATCH_X86
+//4 frames: gathers of the big endian doubles, byte swap inside the 64 bit lanes, narrowing to floats
+SV_TARGET("avx2") static int decodeStreamAvx2(char const* data, qint32 const* offsets, int count, Output const& out)   {
+    __m256i const swap64 = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                            7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    __m128i const swap32 = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    int i = 0;
+    for (; i + 4 <= count; i += 4)  {
+        __m128i index = _mm_loadu_si128(reinterpret_cast<__m128i const*>(offsets + i));
+        __m128i time = _mm_i32gather_epi32(reinterpret_cast<int const*>(data + timeStampOffset), index, 1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out.timeStamps + i), _mm_shuffle_epi8(time, swap32));
+        for (int field = 0; field < 5; field++) {
+            __m256i bits = _mm256_i32gather_epi64(reinterpret_cast<long long const*>(data + streamFields[field]), index, 1);
+            __m256d values = _mm256_castsi256_pd(_mm256_shuffle_epi8(bits, swap64));
+            _mm_storeu_ps(out.fields[field] + i, _mm256_cvtpd_ps(values));
+        }
+    }
+    return i;
+}
+
+//2 frames: the same with two loads instead of a gather
+SV_TARGET("ssse3") static int decodeStreamSsse3(char const* data, qint32 const* offsets, int count, Output const& out)  {
+    __m128i const swap64 = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    int i = 0;
+    for (; i + 2 <= count; i += 2)  {
+        char const* first = data + offsets[i];
+        char const* second = data + offsets[i + 1];
+        out.timeStamps[i] = qFromBigEndian<quint32>(first + timeStampOffset);
+        out.timeStamps[i + 1] = qFromBigEndian<quint32>(second + timeStampOffset);
+        for (int field = 0; field < 5; field++) {
+            __m128i bits = _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(first + streamFields[field])),
+                                              _mm_loadl_epi64(reinterpret_cast<__m128i const*>(second + streamFields[field])));
+            __m128 values = _mm_cvtpd_ps(_mm_castsi128_pd(_mm_shuffle_epi8(bits, swap64)));
+            _mm_storel_pi(reinterpret_cast<__m64*>(out.fields[field] + i), values);
+        }
+    }
+    return i;
+}
+
+//8 frames: gathers of the little endian fields, nothing to convert
+SV_TARGET("avx2") static int decodeCompactAvx2(char const* data, qint32 const* offsets, int count, Output const& out)  {
+    int i = 0;
+    for (; i + 8 <= count; i += 8)  {
+        __m256i index = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(offsets + i));
+        __m256i time = _mm256_i32gather_epi32(reinterpret_cast<int const*>(data + timeStampOffset), index, 1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.timeStamps + i), time);
+        for (int field = 0; field < 5; field++) {
+            __m256i bits = _mm256_i32gather_epi32(reinterpret_cast<int const*>(data + compactFields[field]), index, 1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.fields[field] + i), bits);
+        }
+    }
+    return i;
+}
+
+//4 frames: encoder, steering, x and y of every frame are one load, transposed to the columns
+SV_TARGET("ssse3") static int decodeCompactSse(char const* data, qint32 const* offsets, int count, Output const& out)   {
+    int i = 0;
+    for (; i + 4 <= count; i += 4)  {
+        __m128 rows[4];
+        for (int k = 0; k < 4; k++) {
+            char const* frame = data + offsets[i + k];
+            rows[k] = _mm_loadu_ps(reinterpret_cast<float const*>(frame + compactFields[0]));
+            out.timeStamps[i + k] = qFromLittleEndian<quint32>(frame + timeStampOffset);
+            quint32 bits = qFromLittleEndian<quint32>(frame + compactFields[4]);
+            std::memcpy(out.fields[4] + i + k, &bits, sizeof(float));
+        }
+        _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+        for (int field = 0; field < 4; field++)
+            _mm_storeu_ps(out.fields[field] + i, rows[field]);
+    }
+    return i;
+}
+#endif
+
+int TelemetryColumns::size() const  {
+    return timeStamps.size();
+}
+
+void TelemetryColumns::resize(int size) {
+    timeStamps.resize(size);
+    encoder.resize(size);
+    steering.resize(size);
+    x.resize(size);
+    y.resize(size);
+    angle.resize(size);
+}
+
+void TelemetryColumns::clear()  {
+    resize(0);
+}
+
+void TelemetryColumns::append(HighFreqDataPackage const& data)   {
+    timeStamps.append(data.timeStamp);
+    encoder.append(data.m_encoderValue);
+    steering.append(data.m_steeringAngle);
+    x.append(data.x);
+    y.append(data.y);
+    angle.append(data.angle);
+}
+
+HighFreqDataPackage TelemetryColumns::at(int i) const   {
+    HighFreqDataPackage data;
+    data.timeStamp = timeStamps.at(i);
+    data.m_encoderValue = encoder.at(i);
+    data.m_steeringAngle = steering.at(i);
+    data.x = x.at(i);
+    data.y = y.at(i);
+    data.angle = angle.at(i);
+    return data;
+}
+
+TelemetryBatchDecoder::Path TelemetryBatchDecoder::available()  {
+#ifdef SV_BATCH_X86
+    static Path const path = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return AVX2;
+        if (__builtin_cpu_supports("ssse3"))
+            return SSSE3;
+        return SCALAR;
+    }();
+    return path;
+#else
+    return SCALAR;
+#endif
+}
+
+QString TelemetryBatchDecoder::pathName(Path path)  {
+    switch (path)   {
+    case AUTO: return pathName(available());
+    case SCALAR: return "scalar";
+    case SSSE3: return "ssse3";
+    case AVX2: return "avx2";
+    }
+    return QString();
+}
+
+int TelemetryBatchDecoder::frameSize(Package::Layout layout)    {
+    return layout == Package::COMPACT ? static_cast<int>(sizeof(CompactHighFreqDataPackage)) : streamFrameSize;
+}
+
+int TelemetryBatchDecoder::decode(char const* data, int size, bool longFrames, Package::Layout layout,
+                                  TelemetryColumns &columns, Path path) {
+    int prefix = longFrames ? 2 : 1;
+    int expected = frameSize(layout);
+    QVector<qint32> offsets;
+    offsets.reserve(size / (prefix + expected));
+    int position = 0;
+    while (position + prefix + expected <= size)    {
+        int frame = static_cast<quint8>(data[position]);
+        if (longFrames)
+            frame |= static_cast<quint8>(data[position + 1]) << 8;
+        if (frame != expected || data[position + prefix] != HighFreqDataPackage::packageType)
+            break;
+        offsets.append(position + prefix);
+        position += prefix + frame;
+    }
+    int count = offsets.size();
+    if (!count)
+        return 0;
+
+    int first = columns.size();
+    columns.resize(first + count);
+    Output out = {columns.timeStamps.data() + first,
+                  {columns.encoder.data() + first, columns.steering.data() + first,
+                   columns.x.data() + first, columns.y.data() + first, columns.angle.data() + first}};
+    if (path == AUTO || path > available())
+        path = available();
+
+    int done = 0;
+    if (layout == Package::COMPACT) {
+#ifdef SV_BATCH_X86
+        if (path == AVX2)
+            done = decodeCompactAvx2(data, offsets.constData(), count, out);
+        else if (path == SSSE3)
+            done = decodeCompactSse(data, offsets.constData(), count, out);
+#endif
+        decodeCompact(data, offsets.constData(), done, count, out);
+    }   else    {
+#ifdef SV_BATCH_X86
+        if (path == AVX2)
+            done = decodeStreamAvx2(data, offsets.constData(), count, out);
+        else if (path == SSSE3)
+            done = decodeStreamSsse3(data, offsets.constData(), count, out);
+#endif
+        decodeStream(data, offsets.constData(), done, count, out);
+    }
+    return position;
+}
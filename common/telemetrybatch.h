@@ -0,0 +1,59 @@
+#ifndef TELEMETRYBATCH_H
+#define TELEMETRYBATCH_H
+
+#include <QVector>
+#include "datapackage.h"
+
+//field-major HighFreqDataPackage samples
+struct TelemetryColumns {
+    QVector<quint32> timeStamps;
+    QVector<float> encoder;
+    QVector<float> steering;
+    QVector<float> x;
+    QVector<float> y;
+    QVector<float> angle;
+
+    int size() const;
+    void resize(int size);
+    void clear();
+    void append(HighFreqDataPackage const& data);
+    HighFreqDataPackage at(int i) const;
+};
+
+Q_DECLARE_METATYPE(TelemetryColumns);
+
+/*
+ * Bulk decoder of runs of framed HighFreqDataPackage, for the receive buffer after a stall
+ * and for recordings. The frames of the run are found by their size prefixes first,
+ * then every field is decoded for all the frames at once from the frame offsets:
+ *  STREAM - AVX2 gathers 4 big endian doubles per field, swaps the bytes and narrows them to floats,
+ *           SSSE3 does it for 2 frames with loads instead of the gathers;
+ *  COMPACT - AVX2 gathers 8 little endian fields, SSE transposes 4 frames of encoder..y.
+ * The scalar path is used on other CPUs and compilers, the results of all paths are the same.
+ */
+class TelemetryBatchDecoder
+{
+public:
+    enum Path {
+        AUTO = 0,
+        SCALAR = 1,
+        SSSE3 = 2,
+        AVX2 = 3
+    };
+
+    //the best path of this CPU
+    static Path available();
+    static QString pathName(Path path);
+
+    /*
+     * Decodes the leading run of complete HighFreqDataPackage frames of the buffer,
+     * appends them to the columns and returns the bytes of the run (0 if the buffer starts with another package).
+     * The run stops at the first frame of another type or size, so the packages keep their order.
+     */
+    static int decode(char const* data, int size, bool longFrames, Package::Layout layout,
+                      TelemetryColumns &columns, Path path = AUTO);
+    //size of HighFreqDataPackage without the size prefix
+    static int frameSize(Package::Layout layout);
+};
+
+#endif // TELEMETRYBATCH_H
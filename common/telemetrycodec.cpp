@@ -0,0 +1,142 @@
+#include "telemetrycodec.h"
+#include <QtEndian>
+#include <cmath>
+#include <cstring>
+
+static void putVarint(QByteArray &bytes, qint64 value)    {
+    quint64 zigzag = (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63);
+    while (zigzag >= 0x80)  {
+        bytes.append(static_cast<char>(zigzag | 0x80));
+        zigzag >>= 7;
+    }
+    bytes.append(static_cast<char>(zigzag));
+}
+
+static bool getVarint(QByteArray const& bytes, int &offset, qint64 &value) {
+    quint64 zigzag = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (offset >= bytes.size())
+            return false;
+        quint8 byte = static_cast<quint8>(bytes.at(offset++));
+        zigzag |= static_cast<quint64>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            value = static_cast<qint64>(zigzag >> 1) ^ -static_cast<qint64>(zigzag & 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+//out of range steps are clamped to +-(2^62 - 1), so llround is defined and the difference of two steps
+//is within qint64; 2^62 - 1 has no double, the bound is applied again to the rounded steps
+static qint64 quantize(float value, float resolution)   {
+    double const limit = 4611686018427387904.0;
+    qint64 const steps = (Q_INT64_C(1) << 62) - 1;
+    double scaled = static_cast<double>(value) / static_cast<double>(resolution);
+    if (!std::isfinite(value) || std::isnan(scaled))
+        return 0;
+    return qBound(-steps, static_cast<qint64>(std::llround(qBound(-limit, scaled, limit))), steps);
+}
+
+//modulo 2^64 like the wire format, no signed overflow for any pair of values
+static qint64 wrappingSub(qint64 a, qint64 b)   {
+    return static_cast<qint64>(static_cast<quint64>(a) - static_cast<quint64>(b));
+}
+
+static qint64 wrappingAdd(qint64 a, qint64 b)   {
+    return static_cast<qint64>(static_cast<quint64>(a) + static_cast<quint64>(b));
+}
+
+TelemetryEncoder::TelemetryEncoder(TelemetryResolution const& resolution, int keyframeInterval) :
+    resolution{resolution.encoder, resolution.steering, resolution.x, resolution.y, resolution.angle},
+    keyframeInterval(qMax(keyframeInterval, 1))  {}
+
+QByteArray TelemetryEncoder::encode(HighFreqDataPackage const& data)  {
+    qint64 current[values] = {
+        data.timeStamp,
+        quantize(data.m_encoderValue, resolution[0]),
+        quantize(data.m_steeringAngle, resolution[1]),
+        quantize(data.x, resolution[2]),
+        quantize(data.y, resolution[3]),
+        quantize(data.angle, resolution[4])
+    };
+
+    QByteArray bytes;
+    bytes.reserve(maxFrameSize);
+    bool keyframe = frames == 0;
+    bytes.append(packageType);
+    bytes.append(static_cast<char>(keyframe ? KEYFRAME : 0));
+    bytes.append(static_cast<char>(sequence++));
+    if (keyframe)   {
+        for (float value : resolution)  {
+            quint32 bits;
+            std::memcpy(&bits, &value, 4);
+            char raw[4];
+            qToLittleEndian(bits, raw);
+            bytes.append(raw, 4);
+        }
+    }
+    for (int i = 0; i < values; i++)    {
+        putVarint(bytes, keyframe ? current[i] : wrappingSub(current[i], previous[i]));
+        previous[i] = current[i];
+    }
+    frames = (frames + 1) % keyframeInterval;
+    return bytes;
+}
+
+void TelemetryEncoder::reset()  {
+    frames = 0;
+}
+
+TelemetryDecoder::TelemetryDecoder() {}
+
+bool TelemetryDecoder::decode(QByteArray const& bytes, HighFreqDataPackage &data)   {
+    if (bytes.size() < 3 || bytes.at(0) != TelemetryEncoder::packageType)
+        return false;
+    bool keyframe = static_cast<quint8>(bytes.at(1)) & TelemetryEncoder::KEYFRAME;
+    quint8 frameSequence = static_cast<quint8>(bytes.at(2));
+    //a lost frame breaks the deltas until the next keyframe
+    if (!keyframe && (!synced || frameSequence != sequence))  {
+        synced = false;
+        return false;
+    }
+
+    int offset = 3;
+    float frameResolution[values - 1];
+    if (keyframe)   {
+        if (bytes.size() < offset + 4 * (values - 1))
+            return false;
+        for (float &value : frameResolution)    {
+            quint32 bits = qFromLittleEndian<quint32>(bytes.constData() + offset);
+            std::memcpy(&value, &bits, 4);
+            offset += 4;
+        }
+    }
+    qint64 current[values];
+    for (int i = 0; i < values; i++)    {
+        qint64 value = 0;
+        if (!getVarint(bytes, offset, value))   {
+            synced = false;
+            return false;
+        }
+        current[i] = keyframe ? value : wrappingAdd(previous[i], value);
+    }
+
+    if (keyframe)
+        std::copy(frameResolution, frameResolution + values - 1, resolution);
+    std::copy(current, current + values, previous);
+    synced = true;
+    sequence = static_cast<quint8>(frameSequence + 1);
+
+    data.timeStamp = static_cast<quint32>(current[0]);
+    data.m_encoderValue = static_cast<float>(current[1] * static_cast<double>(resolution[0]));
+    data.m_steeringAngle = static_cast<float>(current[2] * static_cast<double>(resolution[1]));
+    data.x = static_cast<float>(current[3] * static_cast<double>(resolution[2]));
+    data.y = static_cast<float>(current[4] * static_cast<double>(resolution[3]));
+    data.angle = static_cast<float>(current[5] * static_cast<double>(resolution[4]));
+    return true;
+}
+
+void TelemetryDecoder::reset()  {
+    synced = false;
+}
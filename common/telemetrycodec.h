@@ -0,0 +1,69 @@
+#ifndef TELEMETRYCODEC_H
+#define TELEMETRYCODEC_H
+
+#include <QByteArray>
+#include "datapackage.h"
+
+/*
+ * Compressed stream of HighFreqDataPackage (Capabilities::DELTA encoding).
+ * Every channel is quantized to its resolution, a frame carries zigzag varint deltas
+ * of the quantized values against the previous frame of the stream, so the rounding
+ * errors don't add up. A keyframe carries the resolutions and the absolute values,
+ * it starts the stream and is repeated every keyframeInterval frames.
+ *
+ * Frame: packageType, flags, sequence (quint8, +1 every frame), then
+ *  keyframe - timeStamp resolution is 1 ms, resolutions of the channels (f32 little endian),
+ *             timeStamp and the channels as zigzag varints;
+ *  delta - zigzag varint deltas of timeStamp and the channels.
+ * Channels: encoder, steering, x, y, angle.
+ */
+struct TelemetryResolution {
+    float encoder = 0.001f;
+    float steering = 0.01f;    //deg
+    float x = 0.001f;
+    float y = 0.001f;
+    float angle = 0.01f;       //deg
+};
+
+class TelemetryEncoder
+{
+private:
+    static const int values = 6;    //timeStamp and the channels
+
+    float resolution[values - 1];
+    int keyframeInterval;
+    qint64 previous[values] = {};
+    int frames = 0;         //since the keyframe
+    quint8 sequence = 0;
+public:
+    static const qint8 packageType = 12;
+    static const quint8 KEYFRAME = 1;
+    static const int maxFrameSize = 3 + (values - 1) * 4 + values * 10;
+    static const int minFrameSize = 3 + values;    //a delta of one byte varints
+
+    explicit TelemetryEncoder(TelemetryResolution const& resolution = TelemetryResolution(), int keyframeInterval = 100);
+
+    //package bytes without the size prefix
+    QByteArray encode(HighFreqDataPackage const& data);
+    //the next frame is a keyframe
+    void reset();
+};
+
+class TelemetryDecoder
+{
+private:
+    static const int values = 6;
+
+    float resolution[values - 1] = {};
+    qint64 previous[values] = {};
+    bool synced = false;    //false until a keyframe
+    quint8 sequence = 0;
+public:
+    TelemetryDecoder();
+
+    //false for broken frames and for deltas before the keyframe
+    bool decode(QByteArray const& bytes, HighFreqDataPackage &data);
+    void reset();
+};
+
+#endif // TELEMETRYCODEC_H
@@ -0,0 +1,266 @@
+#include "vehiclesimulator.h"
+#include "svtrace.h"
+#include <QtMath>
+#include <QDebug>
+#include <cmath>
+
+VehicleSimulator::VehicleSimulator(MapPackage const& map, QObject *parent) :
+    VehicleSimulator(map, Config(), parent) {}
+
+VehicleSimulator::VehicleSimulator(MapPackage const& map, Config const& config, QObject *parent) :
+    QObject(parent), config(config), grid(map), random(config.seed)    {
+    this->config.highFreqRate = qMax(this->config.highFreqRate, 1);
+    this->config.lowFreqRate = qMax(this->config.lowFreqRate, 1);
+    this->config.stepRate = qMax(this->config.stepRate, this->config.highFreqRate);
+    timer.setTimerType(Qt::PreciseTimer);
+    timer.setInterval(1);
+    connect(&timer, SIGNAL(timeout()), this, SLOT(slotTick()));
+}
+
+void VehicleSimulator::setMap(MapPackage const& map)    {
+    if (map.getWidth() != grid.getWidth() || map.getHeight() != grid.getHeight())  {
+        grid.setMap(map);
+        path.clear();
+        return;
+    }
+    for (int y = 0; y < map.getHeight(); y++)
+        for (int x = 0; x < map.getWidth(); x++)
+            grid.setCell(x, y, map.at(y, x) == MapPackage::WALL);
+    if (!path.isEmpty())
+        replanPath();
+}
+
+void VehicleSimulator::setCell(int x, int y, bool wall)  {
+    grid.setCell(x, y, wall);
+    if (!path.isEmpty())
+        replanPath();
+}
+
+//the rest of the path from the current cell, the goal is given up if it is unreachable now
+bool VehicleSimulator::replanPath() {
+    QPoint start(qFloor(state.x), qFloor(state.y));
+    bool planned = grid.replan(start);
+    path.clear();
+    pathIndex = 0;
+    reverseUntil = 0;
+    if (!planned)   {
+        throttle = 0;
+        steer = 0;
+        emit signalGoalAborted();
+        return false;
+    }
+    for (QPoint const& point : grid.getPath())
+        path.append(QPointF(point.x() + 0.5, point.y() + 0.5));
+    return true;
+}
+
+void VehicleSimulator::setRates(int highFreqRate, int lowFreqRate)    {
+    if (highFreqRate > 0)
+        config.highFreqRate = qMin(highFreqRate, config.stepRate);
+    if (lowFreqRate > 0)
+        config.lowFreqRate = qMin(lowFreqRate, config.stepRate);
+}
+
+void VehicleSimulator::setPose(double x, double y, double heading)  {
+    state.x = x;
+    state.y = y;
+    state.heading = heading;
+    state.speed = 0;
+}
+
+bool VehicleSimulator::setGoal(QPoint const& goal)   {
+    path.clear();
+    pathIndex = 0;
+    pathCollisions = 0;
+    reverseUntil = 0;
+    QPoint start(qFloor(state.x), qFloor(state.y));
+    if (!grid.plan(start, goal))
+        return false;
+    for (QPoint const& point : grid.getPath())
+        path.append(QPointF(point.x() + 0.5, point.y() + 0.5));
+    qDebug() << "Simulator: path to" << goal << "of" << grid.getPathLength() << "cells";
+    return true;
+}
+
+//uniform in [-amplitude, amplitude], mt19937 output is the same on every platform
+double VehicleSimulator::noise(double amplitude)    {
+    return amplitude * (static_cast<double>(random()) / 2147483647.5 - 1);
+}
+
+//the circle of the vehicle overlaps a wall cell, cells out of the map are walls
+bool VehicleSimulator::collides(double x, double y) const {
+    double r = config.radius;
+    for (int cy = qFloor(y - r); cy <= qFloor(y + r); cy++)
+        for (int cx = qFloor(x - r); cx <= qFloor(x + r); cx++) {
+            if (!grid.isWall(cx, cy))
+                continue;
+            double dx = x - qBound(static_cast<double>(cx), x, cx + 1.0);
+            double dy = y - qBound(static_cast<double>(cy), y, cy + 1.0);
+            if (dx * dx + dy * dy < r * r)
+                return true;
+        }
+    return false;
+}
+
+//pure pursuit to the next point of the path, slower in turns and at the goal,
+//backs up turning the other way for a while if the point is behind or the way is blocked
+void VehicleSimulator::follow()  {
+    QPointF target = path.at(pathIndex);
+    double dx = target.x() - state.x;
+    double dy = target.y() - state.y;
+    double distance = qSqrt(dx * dx + dy * dy);
+    if (distance < 0.2)   {
+        if (++pathIndex < path.size())
+            return;
+        path.clear();
+        throttle = 0;
+        steer = 0;
+        emit signalGoalReached();
+        return;
+    }
+
+    double error = std::remainder(qAtan2(dy, dx) - state.heading, 2 * M_PI);
+    if (steps >= reverseUntil && qAbs(error) > M_PI * 0.6)
+        reverseUntil = steps + config.stepRate / 2;
+    if (steps < reverseUntil)   {
+        steer = error > 0 ? -1 : 1;
+        throttle = -0.15;
+    }   else    {
+        double curvature = 2 * qSin(error) / qMax(distance, 0.5);
+        double steering = qRadiansToDegrees(qAtan(config.wheelBase * curvature));
+        steer = qBound(-1.0, steering / config.maxSteering, 1.0);
+        throttle = qAbs(error) > M_PI / 6 ? 0.15 : qBound(0.2, distance, 0.6);
+    }
+    controlStep = steps;
+}
+
+void VehicleSimulator::step()   {
+    double dt = 1.0 / config.stepRate;
+    if (!path.isEmpty())
+        follow();
+    else if (steps - controlStep > config.controlTimeout * config.stepRate)
+        throttle = steer = 0;
+
+    //speed and steering follow the controls with limited rates
+    double targetSpeed = throttle * config.maxSpeed;
+    double acceleration = qBound(-config.maxAcceleration, (targetSpeed - state.speed) / dt, config.maxAcceleration);
+    state.speed += acceleration * dt;
+    double targetSteering = qDegreesToRadians(steer * config.maxSteering);
+    double steeringRate = qDegreesToRadians(config.steeringRate);
+    state.steering += qBound(-steeringRate * dt, targetSteering - state.steering, steeringRate * dt);
+
+    double x = state.x + state.speed * qCos(state.heading) * dt;
+    double y = state.y + state.speed * qSin(state.heading) * dt;
+    bool wasBlocked = blocked;
+    blocked = collides(x, y);
+    if (blocked)    {
+        state.speed = 0;
+        if (!wasBlocked)
+            collisions++;
+        if (!path.isEmpty() && !wasBlocked) {
+            //backs up from the wall or stops backing up into it
+            reverseUntil = steps < reverseUntil ? steps : steps + config.stepRate / 2;
+            if (++pathCollisions > maxPathCollisions)   {
+                path.clear();
+                throttle = 0;
+                emit signalGoalAborted();
+            }
+        }
+    }   else    {
+        state.heading += state.speed / config.wheelBase * qTan(state.steering) * dt;
+        state.heading = std::remainder(state.heading, 2 * M_PI);
+        state.distance += state.speed * dt;
+        state.x = x;
+        state.y = y;
+    }
+
+    //the motor drains its battery and heats up with the load
+    double load = qAbs(state.speed) / config.maxSpeed + qAbs(acceleration) / config.maxAcceleration;
+    state.motorBattery = qMax(0.0, state.motorBattery - (0.002 + 0.02 * load) * dt);
+    state.compBattery = qMax(0.0, state.compBattery - 0.005 * dt);
+    state.temperature += (0.5 * load - 0.01 * (state.temperature - 25)) * dt;
+    steps++;
+
+    //Bresenham-like schedule, the average rates are exact for any step rate
+    if ((steps * config.highFreqRate) / config.stepRate != ((steps - 1) * config.highFreqRate) / config.stepRate)
+        emit signalHighFreqData(highFreqData());
+    if ((steps * config.lowFreqRate) / config.stepRate != ((steps - 1) * config.lowFreqRate) / config.stepRate)
+        emit signalLowFreqData(lowFreqData());
+}
+
+//simulated msec, 0 is taken by the GUI as no data yet
+quint32 VehicleSimulator::timeStamp() const  {
+    return static_cast<quint32>(steps * 1000 / config.stepRate + 1);
+}
+
+HighFreqDataPackage VehicleSimulator::highFreqData() {
+    HighFreqDataPackage data;
+    data.timeStamp = timeStamp();
+    data.m_encoderValue = static_cast<float>(state.distance + noise(0.002));
+    data.m_steeringAngle = static_cast<float>(qRadiansToDegrees(state.steering) + noise(0.2));
+    data.x = static_cast<float>(state.x + noise(0.01));
+    data.y = static_cast<float>(state.y + noise(0.01));
+    data.angle = static_cast<float>(qRadiansToDegrees(state.heading) + noise(0.5));
+    return data;
+}
+
+LowFreqDataPackage VehicleSimulator::lowFreqData()   {
+    LowFreqDataPackage data(qAbs(state.speed) > 1e-3 ? LowFreqDataPackage::RUN : LowFreqDataPackage::WAIT);
+    data.timeStamp = timeStamp();
+    data.m_motorBatteryPerc = static_cast<quint32>(qRound(state.motorBattery));
+    data.m_compBatteryPerc = static_cast<quint32>(qRound(state.compBattery));
+    data.m_temp = static_cast<float>(state.temperature + noise(0.1));
+    return data;
+}
+
+void VehicleSimulator::advance(qint64 count)    {
+    for (qint64 i = 0; i < count; i++)
+        step();
+}
+
+void VehicleSimulator::start()  {
+    clock.start();
+    clockSteps = 0;
+    timer.start();
+}
+
+void VehicleSimulator::stop()   {
+    timer.stop();
+}
+
+//catches up with the wall clock, at most 100 ms at once if the process was stalled
+void VehicleSimulator::slotTick()   {
+    SV_TRACE("VehicleSimulator::slotTick");
+    qint64 due = clock.nsecsElapsed() * config.stepRate / 1000000000;
+    qint64 count = due - clockSteps;
+    if (count > config.stepRate / 10)   {
+        qDebug() << "Simulator: behind real time by" << count - config.stepRate / 10 << "steps, skipped";
+        count = config.stepRate / 10;
+    }
+    clockSteps = due;
+    advance(count);
+}
+
+void VehicleSimulator::slotControl(ControlPackage const& control)   {
+    //manual control takes over the path
+    path.clear();
+    steer = qBound(-1.0, static_cast<double>(control.xAxis), 1.0);
+    throttle = qBound(-1.0, static_cast<double>(control.yAxis), 1.0);
+    controlStep = steps;
+}
+
+VehicleSimulator::Config const& VehicleSimulator::getConfig() const  {
+    return config;
+}
+
+qint64 VehicleSimulator::getSteps() const   {
+    return steps;
+}
+
+qint64 VehicleSimulator::getCollisions() const  {
+    return collisions;
+}
+
+QPointF VehicleSimulator::getPosition() const   {
+    return QPointF(state.x, state.y);
+}
@@ -0,0 +1,119 @@
+#ifndef VEHICLESIMULATOR_H
+#define VEHICLESIMULATOR_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QPointF>
+#include <random>
+#include "datapackage.h"
+#include "gridplanner.h"
+
+/*
+ * Vehicle for the test server: kinematic bicycle model integrated with a fixed step,
+ * driven by ControlPackage (xAxis - steering, yAxis - throttle, -1..1) or along
+ * the path planned to the goal cell, and stopped by the walls of the map.
+ * Positions are in cells, the vehicle is a circle of the radius for collisions.
+ * Telemetry is produced in simulated time at the configured rates (up to the step rate),
+ * sensor noise comes from the seeded generator, so runs with the same seed and
+ * the same controls are the same. start() follows the wall clock, advance() runs offline.
+ */
+class VehicleSimulator : public QObject
+{
+    Q_OBJECT
+public:
+    struct Config {
+        int stepRate = 1000;            //steps per second, at least highFreqRate
+        int highFreqRate = 100;         //HighFreqDataPackage per second
+        int lowFreqRate = 1;            //LowFreqDataPackage per second
+        quint32 seed = 1;
+        double wheelBase = 0.2;         //cells
+        double radius = 0.2;            //cells
+        double maxSpeed = 2;            //cells/s
+        double maxAcceleration = 4;     //cells/s^2
+        double maxSteering = 35;        //deg
+        double steeringRate = 180;      //deg/s
+        double controlTimeout = 0.5;    //s, the vehicle stops if the controls don't come
+    };
+private:
+    struct State {
+        double x = 1.5;
+        double y = 2.5;
+        double heading = 0;         //rad, clockwise on the map (y goes down)
+        double speed = 0;           //cells/s
+        double steering = 0;        //rad
+        double distance = 0;        //encoder, cells
+        double motorBattery = 100;  //%
+        double compBattery = 100;   //%
+        double temperature = 25;    //C
+    };
+
+    Config config;
+    State state;
+    GridPlanner grid;
+    std::mt19937 random;
+    qint64 steps = 0;
+    qint64 collisions = 0;
+    bool blocked = false;       //stands at a wall
+
+    //controls, -1..1
+    double throttle = 0;
+    double steer = 0;
+    qint64 controlStep = 0;
+
+    static const int maxPathCollisions = 20;   //the goal is given up
+
+    QVector<QPointF> path;      //cell centers to pass
+    int pathIndex = 0;
+    int pathCollisions = 0;
+    qint64 reverseUntil = 0;    //step
+
+    QTimer timer;
+    QElapsedTimer clock;
+    qint64 clockSteps = 0;      //steps done in real time since start()
+
+    double noise(double amplitude);
+    bool collides(double x, double y) const;
+    bool replanPath();
+    void follow();
+    void step();
+    quint32 timeStamp() const;
+    HighFreqDataPackage highFreqData();
+    LowFreqDataPackage lowFreqData();
+private slots:
+    void slotTick();
+public:
+    explicit VehicleSimulator(MapPackage const& map, QObject *parent = nullptr);
+    VehicleSimulator(MapPackage const& map, Config const& config, QObject *parent = nullptr);
+
+    //changed cells of a map of the same size are applied one by one and the path to the goal
+    //is planned again from the current cell, the planner keeps it if the changes don't affect it
+    void setMap(MapPackage const& map);
+    void setCell(int x, int y, bool wall);
+    void setPose(double x, double y, double heading);
+    //plans the path to the cell from the current one, false if it is unreachable
+    bool setGoal(QPoint const& goal);
+    //telemetry rates up to the step rate, 0 keeps the rate
+    void setRates(int highFreqRate, int lowFreqRate);
+
+    //runs the steps immediately, telemetry signals are emitted on the way
+    void advance(qint64 count);
+    //runs in real time from the event loop
+    void start();
+    void stop();
+
+    Config const& getConfig() const;
+    qint64 getSteps() const;
+    qint64 getCollisions() const;
+    QPointF getPosition() const;
+public slots:
+    void slotControl(ControlPackage const& control);
+signals:
+    void signalHighFreqData(HighFreqDataPackage const& data);
+    void signalLowFreqData(LowFreqDataPackage const& data);
+    void signalGoalReached();
+    void signalGoalAborted();
+};
+
+#endif // VEHICLESIMULATOR_H